@@ -1,48 +1,132 @@
 #pragma once
 #include "Neat\Types.h"
 
+#include <algorithm>
+#include <cstddef>
+#include <cstring>
+#include <new>
+#include <type_traits>
+
 namespace Neat
 {
 	class IAllocator
 	{
 	public:
+		// Alignment of blocks returned by Allocate
+		static constexpr size_t DefaultAlignment = alignof(std::max_align_t);
+
 		virtual byte_t* Allocate(size_t bytes) = 0;
 		virtual void Deallocate(byte_t* p, size_t bytes) = 0;
 		virtual bool Owns(byte_t* p, size_t bytes) = 0;
+
+		// Alignment must be a power of two, blocks are released by DeallocateAligned
+		virtual byte_t* AllocateAligned(size_t bytes, size_t alignment) = 0;
+		virtual void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) = 0;
+
+		// Resizes block returned by Allocate without moving it, returns false when it's not possible
+		virtual bool TryExpand(byte_t* p, size_t bytes, size_t newBytes);
+		// Resizes block returned by Allocate, moving it when needed.
+		// On failure returns null and the original block stays valid.
+		virtual byte_t* Reallocate(byte_t* p, size_t bytes, size_t newBytes);
+
+		// Allocates count blocks of the given sizes at once, zero sizes yield null blocks.
+		// On failure returns false, blocks allocated so far are released and all are null.
+		virtual bool AllocateBatch(const size_t* sizes, size_t count, byte_t** blocks);
+		// Releases blocks returned by Allocate or AllocateBatch, null blocks are skipped
+		virtual void DeallocateBatch(byte_t* const* blocks, const size_t* sizes, size_t count);
 	};
 
+	inline bool IAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		return false;
+	}
+
+	inline byte_t* IAllocator::Reallocate(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		if (!p)
+			return Allocate(newBytes);
+
+		if (TryExpand(p, bytes, newBytes))
+			return p;
+
+		const auto q = Allocate(newBytes);
+		if (!q)
+			return nullptr;
+
+		memcpy(q, p, (std::min)(bytes, newBytes));
+		Deallocate(p, bytes);
+		return q;
+	}
+
+	inline bool IAllocator::AllocateBatch(const size_t* sizes, size_t count, byte_t** blocks)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			blocks[i] = (sizes[i] > 0) ? Allocate(sizes[i]) : nullptr;
+			if (!blocks[i] && sizes[i] > 0)
+			{
+				DeallocateBatch(blocks, sizes, i);
+				memset(blocks, 0, count * sizeof(byte_t*));
+				return false;
+			}
+		}
+		return true;
+	}
+
+	inline void IAllocator::DeallocateBatch(byte_t* const* blocks, const size_t* sizes, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			if (blocks[i])
+				Deallocate(blocks[i], sizes[i]);
+		}
+	}
+
+	//
+	// Standard allocator over IAllocator. Copies and moves share the IAllocator,
+	// which follows containers on copy, move and swap.
+	//
+
 	template <class T>
 	class Allocator
 	{
 	public:
 		typedef T value_type;
+		typedef std::true_type propagate_on_container_copy_assignment;
+		typedef std::true_type propagate_on_container_move_assignment;
+		typedef std::true_type propagate_on_container_swap;
+		typedef std::false_type is_always_equal;
 
-		Allocator(IAllocator* allocator) noexcept
+		// Alignment below alignof(T) is ignored
+		Allocator(IAllocator* allocator, size_t alignment = 0) noexcept
 			: m_allocator(allocator)
+			, m_alignment(alignment)
 		{
 		}
 
 		Allocator(Allocator&& other) noexcept
 			: m_allocator(other.m_allocator)
+			, m_alignment(other.m_alignment)
 		{
-			other.m_allocator = nullptr;
 		}
 
 		Allocator(const Allocator& other) noexcept
 			: m_allocator(other.m_allocator)
+			, m_alignment(other.m_alignment)
 		{
 		}
 
 		template <class U>
 		Allocator(Allocator<U>&& other) noexcept
 			: m_allocator(other.m_allocator)
+			, m_alignment(other.m_alignment)
 		{
-			other.m_allocator = nullptr;
 		}
 
 		template <class U>
 		Allocator(const Allocator<U>& other) noexcept
 			: m_allocator(other.m_allocator)
+			, m_alignment(other.m_alignment)
 		{
 		}
 
@@ -53,13 +137,14 @@ namespace Neat
 		Allocator& operator=(Allocator&& other) noexcept
 		{
 			m_allocator = other.m_allocator;
-			other.m_allocator = nullptr;
+			m_alignment = other.m_alignment;
 			return *this;
 		}
 
 		Allocator& operator=(const Allocator& other) noexcept
 		{
 			m_allocator = other.m_allocator;
+			m_alignment = other.m_alignment;
 			return *this;
 		}
 
@@ -67,7 +152,7 @@ namespace Neat
 		Allocator& operator=(Allocator<U>&& other) noexcept
 		{
 			m_allocator = other.m_allocator;
-			other.m_allocator = nullptr;
+			m_alignment = other.m_alignment;
 			return *this;
 		}
 
@@ -75,14 +160,21 @@ namespace Neat
 		Allocator& operator=(const Allocator<U>& other) noexcept
 		{
 			m_allocator = other.m_allocator;
+			m_alignment = other.m_alignment;
 			return *this;
 		}
 
+		// Throws std::bad_alloc when IAllocator is null or out of memory
 		T* allocate(size_t n)
 		{
 			if (!m_allocator)
-				return nullptr;
-			auto p = m_allocator->Allocate(sizeof(T) * n);
+				throw std::bad_alloc();
+			const auto alignment = GetAlignment();
+			auto p = (alignment > IAllocator::DefaultAlignment) ?
+				m_allocator->AllocateAligned(sizeof(T) * n, alignment) :
+				m_allocator->Allocate(sizeof(T) * n);
+			if (!p)
+				throw std::bad_alloc();
 			return reinterpret_cast<T*>(p);
 		}
 
@@ -90,10 +182,33 @@ namespace Neat
 		{
 			if (!m_allocator)
 				return;
-			m_allocator->Deallocate(reinterpret_cast<byte_t*>(p), sizeof(T) * n);
+			const auto alignment = GetAlignment();
+			if (alignment > IAllocator::DefaultAlignment)
+				m_allocator->DeallocateAligned(reinterpret_cast<byte_t*>(p), sizeof(T) * n, alignment);
+			else
+				m_allocator->Deallocate(reinterpret_cast<byte_t*>(p), sizeof(T) * n);
+		}
+
+		size_t GetAlignment() const noexcept
+		{
+			return (std::max)(m_alignment, alignof(T));
+		}
+
+		// Blocks of equal allocators can be freed by each other
+		template <class U>
+		bool operator==(const Allocator<U>& other) const noexcept
+		{
+			return m_allocator == other.m_allocator && m_alignment == other.m_alignment;
+		}
+
+		template <class U>
+		bool operator!=(const Allocator<U>& other) const noexcept
+		{
+			return !operator==(other);
 		}
 
 	public:
 		IAllocator* m_allocator;
+		size_t m_alignment;
 	};
 }
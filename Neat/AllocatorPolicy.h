@@ -0,0 +1,153 @@
+#pragma once
+#include "Neat\Allocator.h"
+#include "Neat\AllocatorScope.h"
+
+#include <new>
+
+namespace Neat
+{
+	//
+	// Allocator policies bind BufferT and StringT to their memory source at compile time.
+	// A policy is a base class of the buffer, so a stateless policy takes no space in it.
+	// Alignment up to IAllocator::DefaultAlignment, including zero, means the default one.
+	// Copies of a buffer or a string take the policy returned by SelectForCopy of the source.
+	//
+
+	// Dispatches to IAllocator chosen at run time, or to new[]/delete[] when it's null
+	class RuntimeAllocatorPolicy
+	{
+	public:
+		// Implicit, so buffers and strings still accept IAllocator* directly.
+		// Null allocator is replaced with the one of the current AllocatorScope, if any.
+		RuntimeAllocatorPolicy(IAllocator* allocator = nullptr);
+
+		IAllocator* GetAllocator() const;
+		// Copies share the allocator, a copy of null one takes the allocator of the current scope
+		RuntimeAllocatorPolicy SelectForCopy() const;
+
+		byte_t* AllocateBlock(size_t bytes, size_t alignment);
+		void DeallocateBlock(byte_t* p, size_t bytes, size_t alignment);
+		// Returns nullptr when the block can't be resized, it stays valid then
+		byte_t* ReallocateBlock(byte_t* p, size_t bytes, size_t newBytes, size_t alignment);
+		// Blocks have default alignment and are released one by one with DeallocateBlock
+		bool AllocateBlocks(const size_t* sizes, size_t count, byte_t** blocks);
+
+	private:
+		IAllocator* m_allocator;
+	};
+
+	// Calls stateless allocator type A without virtual dispatch, e.g. MallocAllocator or DefaultAllocator.
+	// Every call is served by a temporary instance, so the calls inline completely.
+	template <typename A>
+	class StaticAllocatorPolicy
+	{
+	public:
+		// Returns shared instance for code which needs IAllocator*
+		IAllocator* GetAllocator() const;
+		StaticAllocatorPolicy SelectForCopy() const;
+
+		byte_t* AllocateBlock(size_t bytes, size_t alignment);
+		void DeallocateBlock(byte_t* p, size_t bytes, size_t alignment);
+		// Returns nullptr when the block can't be resized, it stays valid then
+		byte_t* ReallocateBlock(byte_t* p, size_t bytes, size_t newBytes, size_t alignment);
+		// Blocks have default alignment and are released one by one with DeallocateBlock
+		bool AllocateBlocks(const size_t* sizes, size_t count, byte_t** blocks);
+	};
+
+	inline RuntimeAllocatorPolicy::RuntimeAllocatorPolicy(IAllocator* allocator) :
+		m_allocator(allocator ? allocator : AllocatorScope::GetCurrent())
+	{
+	}
+
+	inline IAllocator* RuntimeAllocatorPolicy::GetAllocator() const
+	{
+		return m_allocator;
+	}
+
+	inline RuntimeAllocatorPolicy RuntimeAllocatorPolicy::SelectForCopy() const
+	{
+		return RuntimeAllocatorPolicy(m_allocator);
+	}
+
+	inline byte_t* RuntimeAllocatorPolicy::AllocateBlock(size_t bytes, size_t alignment)
+	{
+		if (alignment > IAllocator::DefaultAlignment)
+			return m_allocator ? m_allocator->AllocateAligned(bytes, alignment) : static_cast<byte_t*>(operator new[](bytes, std::align_val_t(alignment)));
+		else
+			return m_allocator ? m_allocator->Allocate(bytes) : new byte_t[bytes];
+	}
+
+	inline void RuntimeAllocatorPolicy::DeallocateBlock(byte_t* p, size_t bytes, size_t alignment)
+	{
+		if (alignment > IAllocator::DefaultAlignment)
+			m_allocator ? m_allocator->DeallocateAligned(p, bytes, alignment) : operator delete[](p, std::align_val_t(alignment));
+		else
+			m_allocator ? m_allocator->Deallocate(p, bytes) : delete[] p;
+	}
+
+	inline byte_t* RuntimeAllocatorPolicy::ReallocateBlock(byte_t* p, size_t bytes, size_t newBytes, size_t alignment)
+	{
+		if (!m_allocator || alignment > IAllocator::DefaultAlignment)
+			return nullptr;
+		return m_allocator->Reallocate(p, bytes, newBytes);
+	}
+
+	inline bool RuntimeAllocatorPolicy::AllocateBlocks(const size_t* sizes, size_t count, byte_t** blocks)
+	{
+		if (m_allocator)
+			return m_allocator->AllocateBatch(sizes, count, blocks);
+
+		for (size_t i = 0; i < count; i++)
+			blocks[i] = (sizes[i] > 0) ? new byte_t[sizes[i]] : nullptr;
+		return true;
+	}
+
+	template <typename A>
+	IAllocator* StaticAllocatorPolicy<A>::GetAllocator() const
+	{
+		static A s_allocator;
+		return &s_allocator;
+	}
+
+	template <typename A>
+	StaticAllocatorPolicy<A> StaticAllocatorPolicy<A>::SelectForCopy() const
+	{
+		return *this;
+	}
+
+	template <typename A>
+	byte_t* StaticAllocatorPolicy<A>::AllocateBlock(size_t bytes, size_t alignment)
+	{
+		A allocator;
+		if (alignment > IAllocator::DefaultAlignment)
+			return allocator.A::AllocateAligned(bytes, alignment);
+		else
+			return allocator.A::Allocate(bytes);
+	}
+
+	template <typename A>
+	void StaticAllocatorPolicy<A>::DeallocateBlock(byte_t* p, size_t bytes, size_t alignment)
+	{
+		A allocator;
+		if (alignment > IAllocator::DefaultAlignment)
+			allocator.A::DeallocateAligned(p, bytes, alignment);
+		else
+			allocator.A::Deallocate(p, bytes);
+	}
+
+	template <typename A>
+	byte_t* StaticAllocatorPolicy<A>::ReallocateBlock(byte_t* p, size_t bytes, size_t newBytes, size_t alignment)
+	{
+		if (alignment > IAllocator::DefaultAlignment)
+			return nullptr;
+		A allocator;
+		return allocator.A::Reallocate(p, bytes, newBytes);
+	}
+
+	template <typename A>
+	bool StaticAllocatorPolicy<A>::AllocateBlocks(const size_t* sizes, size_t count, byte_t** blocks)
+	{
+		A allocator;
+		return allocator.A::AllocateBatch(sizes, count, blocks);
+	}
+}
@@ -0,0 +1,52 @@
+#pragma once
+#include "Neat\Allocator.h"
+
+namespace Neat
+{
+	//
+	// Installs thread default allocator for the lifetime of the scope. Buffers, strings and paths
+	// constructed on this thread without an explicit allocator take it, so do temporaries created
+	// inside Neat functions. Objects keep the allocator they were constructed with, so they must not
+	// outlive it. Scopes nest, a null allocator brings back new[]/delete[] for the inner scope.
+	//
+
+	class AllocatorScope
+	{
+	public:
+		explicit AllocatorScope(IAllocator* allocator);
+		AllocatorScope(const AllocatorScope& other) = delete;
+		AllocatorScope& operator=(const AllocatorScope& other) = delete;
+		~AllocatorScope();
+
+		// Returns allocator of the innermost scope on this thread, null when there is none
+		static IAllocator* GetCurrent();
+
+	private:
+		static IAllocator*& GetSlot();
+
+	private:
+		IAllocator* m_previous;
+	};
+
+	inline AllocatorScope::AllocatorScope(IAllocator* allocator) :
+		m_previous(GetSlot())
+	{
+		GetSlot() = allocator;
+	}
+
+	inline AllocatorScope::~AllocatorScope()
+	{
+		GetSlot() = m_previous;
+	}
+
+	inline IAllocator* AllocatorScope::GetCurrent()
+	{
+		return GetSlot();
+	}
+
+	inline IAllocator*& AllocatorScope::GetSlot()
+	{
+		thread_local IAllocator* s_allocator = nullptr;
+		return s_allocator;
+	}
+}
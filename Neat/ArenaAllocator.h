@@ -0,0 +1,274 @@
+#pragma once
+#include "Neat\Allocator.h"
+
+#include <algorithm>
+#include <cstddef>
+
+namespace Neat
+{
+	//
+	// Monotonic allocator: bumps a pointer inside chained blocks which grow geometrically.
+	// Deallocate does nothing, all memory is released at once by Reset or Release.
+	//
+
+	class ArenaAllocator : public IAllocator
+	{
+	public:
+		static constexpr size_t Alignment = alignof(std::max_align_t);
+
+		// Blocks are taken from upstream allocator, or from new[] when it's null
+		explicit ArenaAllocator(size_t blockSize = 4_kB, IAllocator* upstream = nullptr);
+		ArenaAllocator(const ArenaAllocator& other) = delete;
+		ArenaAllocator& operator=(const ArenaAllocator& other) = delete;
+		~ArenaAllocator();
+
+		byte_t* Allocate(size_t bytes) override;
+		void Deallocate(byte_t* p, size_t bytes) override;
+		bool Owns(byte_t* p, size_t bytes) override;
+
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+
+		// Carves the whole batch from a single block, growing at most once
+		bool AllocateBatch(const size_t* sizes, size_t count, byte_t** blocks) override;
+		void DeallocateBatch(byte_t* const* blocks, const size_t* sizes, size_t count) override;
+
+		// Keeps the biggest block for reuse and returns the rest to upstream allocator
+		void Reset();
+		// Returns all blocks to upstream allocator
+		void Release();
+
+		// Returns bytes handed out since the last reset
+		size_t GetUsed() const;
+		// Returns bytes held in blocks including headers
+		size_t GetReserved() const;
+		size_t GetBlockCount() const;
+
+	private:
+		struct Block
+		{
+			Block* prev;
+			size_t size;
+		};
+
+		static constexpr size_t HeaderSize = (sizeof(Block) + Alignment - 1) & ~(Alignment - 1);
+
+		bool Grow(size_t bytes);
+		void FreeBlock(Block* block);
+
+	private:
+		IAllocator* m_upstream;
+		size_t m_nextSize;
+		Block* m_block;
+		byte_t* m_next;
+		byte_t* m_end;
+		size_t m_used;
+	};
+
+	inline ArenaAllocator::ArenaAllocator(size_t blockSize, IAllocator* upstream) :
+		m_upstream(upstream),
+		m_nextSize((std::max)(blockSize, HeaderSize + Alignment)),
+		m_block(nullptr),
+		m_next(nullptr),
+		m_end(nullptr),
+		m_used(0)
+	{
+	}
+
+	inline ArenaAllocator::~ArenaAllocator()
+	{
+		Release();
+	}
+
+	inline byte_t* ArenaAllocator::Allocate(size_t bytes)
+	{
+		const auto size = ((std::max)(bytes, 1_sz) + Alignment - 1) & ~(Alignment - 1);
+		if (static_cast<size_t>(m_end - m_next) < size)
+		{
+			if (!Grow(size))
+				return nullptr;
+		}
+
+		const auto p = m_next;
+		m_next += size;
+		m_used += size;
+		return p;
+	}
+
+	inline void ArenaAllocator::Deallocate(byte_t* p, size_t bytes)
+	{
+	}
+
+	inline byte_t* ArenaAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		if (alignment <= Alignment)
+			return Allocate(bytes);
+
+		auto getPadding = [this, alignment]()
+		{
+			return (alignment - (reinterpret_cast<uintptr_t>(m_next) & (alignment - 1))) & (alignment - 1);
+		};
+
+		const auto size = ((std::max)(bytes, 1_sz) + Alignment - 1) & ~(Alignment - 1);
+		auto padding = getPadding();
+		if (static_cast<size_t>(m_end - m_next) < padding + size)
+		{
+			// Fresh block is aligned to Alignment at least, so the padding is bounded
+			if (!Grow(size + alignment - Alignment))
+				return nullptr;
+			padding = getPadding();
+		}
+
+		const auto p = m_next + padding;
+		m_next = p + size;
+		m_used += padding + size;
+		return p;
+	}
+
+	inline void ArenaAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+	}
+
+	inline bool ArenaAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		// Only the most recent block can be resized, by moving the bump pointer
+		const auto size = ((std::max)(bytes, 1_sz) + Alignment - 1) & ~(Alignment - 1);
+		if (!p || p + size != m_next)
+			return false;
+
+		const auto newSize = ((std::max)(newBytes, 1_sz) + Alignment - 1) & ~(Alignment - 1);
+		if (static_cast<size_t>(m_end - p) < newSize)
+			return false;
+
+		m_next = p + newSize;
+		m_used = m_used - size + newSize;
+		return true;
+	}
+
+	inline bool ArenaAllocator::AllocateBatch(const size_t* sizes, size_t count, byte_t** blocks)
+	{
+		size_t total = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (sizes[i] > 0)
+				total += (sizes[i] + Alignment - 1) & ~(Alignment - 1);
+		}
+
+		if (static_cast<size_t>(m_end - m_next) < total)
+		{
+			if (!Grow(total))
+			{
+				memset(blocks, 0, count * sizeof(byte_t*));
+				return false;
+			}
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			if (0 == sizes[i])
+			{
+				blocks[i] = nullptr;
+				continue;
+			}
+
+			blocks[i] = m_next;
+			m_next += (sizes[i] + Alignment - 1) & ~(Alignment - 1);
+		}
+		m_used += total;
+		return true;
+	}
+
+	inline void ArenaAllocator::DeallocateBatch(byte_t* const* blocks, const size_t* sizes, size_t count)
+	{
+	}
+
+	inline bool ArenaAllocator::Owns(byte_t* p, size_t bytes)
+	{
+		for (auto block = m_block; block; block = block->prev)
+		{
+			const auto begin = reinterpret_cast<byte_t*>(block) + HeaderSize;
+			const auto end = reinterpret_cast<byte_t*>(block) + block->size;
+			if (p >= begin && p + bytes <= end)
+				return true;
+		}
+		return false;
+	}
+
+	inline void ArenaAllocator::Reset()
+	{
+		if (!m_block)
+			return;
+
+		// The newest block is always the biggest one
+		while (m_block->prev)
+		{
+			const auto prev = m_block->prev;
+			m_block->prev = prev->prev;
+			FreeBlock(prev);
+		}
+
+		m_next = reinterpret_cast<byte_t*>(m_block) + HeaderSize;
+		m_used = 0;
+	}
+
+	inline void ArenaAllocator::Release()
+	{
+		while (m_block)
+		{
+			const auto prev = m_block->prev;
+			FreeBlock(m_block);
+			m_block = prev;
+		}
+
+		m_next = nullptr;
+		m_end = nullptr;
+		m_used = 0;
+	}
+
+	inline size_t ArenaAllocator::GetUsed() const
+	{
+		return m_used;
+	}
+
+	inline size_t ArenaAllocator::GetReserved() const
+	{
+		size_t reserved = 0;
+		for (auto block = m_block; block; block = block->prev)
+			reserved += block->size;
+		return reserved;
+	}
+
+	inline size_t ArenaAllocator::GetBlockCount() const
+	{
+		size_t count = 0;
+		for (auto block = m_block; block; block = block->prev)
+			count++;
+		return count;
+	}
+
+	inline bool ArenaAllocator::Grow(size_t bytes)
+	{
+		const auto size = (std::max)(m_nextSize, HeaderSize + bytes);
+		const auto p = m_upstream ? m_upstream->Allocate(size) : new byte_t[size];
+		if (!p)
+			return false;
+
+		const auto block = reinterpret_cast<Block*>(p);
+		block->prev = m_block;
+		block->size = size;
+
+		m_block = block;
+		m_next = p + HeaderSize;
+		m_end = p + size;
+		m_nextSize = size * 2;
+		return true;
+	}
+
+	inline void ArenaAllocator::FreeBlock(Block* block)
+	{
+		const auto p = reinterpret_cast<byte_t*>(block);
+		m_upstream ? m_upstream->Deallocate(p, block->size) : delete[] p;
+	}
+}
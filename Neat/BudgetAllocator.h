@@ -0,0 +1,313 @@
+#pragma once
+#include "Neat\Allocator.h"
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+
+namespace Neat
+{
+	//
+	// Decorator which caps bytes handed out by the wrapped allocator. A request which would exceed
+	// the budget first calls the pressure callback, which may flush, spill or shed load and free memory
+	// of this allocator. Then it waits up to the timeout for other threads to free memory and fails
+	// with nullptr when the budget is still exhausted. Requests bigger than the whole budget fail at once.
+	// Requested bytes are counted, overhead of the wrapped allocator is not.
+	//
+
+	class BudgetAllocator : public IAllocator
+	{
+	public:
+		// Receives size of the request which didn't fit, returns true when it freed some memory.
+		// It's called without any lock held, so it may free memory of this allocator.
+		typedef std::function<bool(BudgetAllocator& allocator, size_t bytes)> PressureCallback;
+
+		// Wrapped allocator must be thread safe when the budget is shared by threads
+		BudgetAllocator(IAllocator* allocator, size_t budget);
+		BudgetAllocator(const BudgetAllocator& other) = delete;
+		BudgetAllocator& operator=(const BudgetAllocator& other) = delete;
+
+		byte_t* Allocate(size_t bytes) override;
+		void Deallocate(byte_t* p, size_t bytes) override;
+		bool Owns(byte_t* p, size_t bytes) override;
+
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		// Growing in place never waits, it fails when the budget is exhausted
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+		byte_t* Reallocate(byte_t* p, size_t bytes, size_t newBytes) override;
+
+		// Whole batch is reserved at once
+		bool AllocateBatch(const size_t* sizes, size_t count, byte_t** blocks) override;
+		void DeallocateBatch(byte_t* const* blocks, const size_t* sizes, size_t count) override;
+
+		// Callback and timeout must be set before the allocator is shared by threads
+		void SetPressureCallback(PressureCallback callback);
+		// Zero timeout fails at once, without waiting for other threads
+		void SetTimeout(std::chrono::milliseconds timeout);
+
+		// Lowering the budget below current usage only affects new requests
+		void SetBudget(size_t budget);
+		size_t GetBudget() const;
+		size_t GetUsed() const;
+		size_t GetPeak() const;
+		// Returns number of requests rejected because of the budget
+		size_t GetRejected() const;
+
+	private:
+		bool Reserve(size_t bytes);
+		bool TryReserve(size_t bytes);
+		void Release(size_t bytes);
+
+	private:
+		IAllocator* m_allocator;
+		std::atomic<size_t> m_budget;
+		std::atomic<size_t> m_used;
+		std::atomic<size_t> m_peak;
+		std::atomic<size_t> m_rejected;
+		PressureCallback m_callback;
+		std::chrono::milliseconds m_timeout;
+
+		std::mutex m_mutex;
+		std::condition_variable m_released;
+		std::atomic<size_t> m_waiters;
+	};
+
+	inline BudgetAllocator::BudgetAllocator(IAllocator* allocator, size_t budget) :
+		m_allocator(allocator),
+		m_budget(budget),
+		m_used(0),
+		m_peak(0),
+		m_rejected(0),
+		m_timeout(0),
+		m_waiters(0)
+	{
+	}
+
+	inline byte_t* BudgetAllocator::Allocate(size_t bytes)
+	{
+		if (!Reserve(bytes))
+			return nullptr;
+
+		const auto p = m_allocator->Allocate(bytes);
+		if (!p)
+			Release(bytes);
+		return p;
+	}
+
+	inline void BudgetAllocator::Deallocate(byte_t* p, size_t bytes)
+	{
+		if (!p)
+			return;
+
+		m_allocator->Deallocate(p, bytes);
+		Release(bytes);
+	}
+
+	inline bool BudgetAllocator::Owns(byte_t* p, size_t bytes)
+	{
+		return m_allocator->Owns(p, bytes);
+	}
+
+	inline byte_t* BudgetAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		if (!Reserve(bytes))
+			return nullptr;
+
+		const auto p = m_allocator->AllocateAligned(bytes, alignment);
+		if (!p)
+			Release(bytes);
+		return p;
+	}
+
+	inline void BudgetAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		if (!p)
+			return;
+
+		m_allocator->DeallocateAligned(p, bytes, alignment);
+		Release(bytes);
+	}
+
+	inline bool BudgetAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		if (newBytes <= bytes)
+		{
+			if (!m_allocator->TryExpand(p, bytes, newBytes))
+				return false;
+			Release(bytes - newBytes);
+			return true;
+		}
+
+		const auto delta = newBytes - bytes;
+		if (!TryReserve(delta))
+		{
+			m_rejected++;
+			return false;
+		}
+
+		if (!m_allocator->TryExpand(p, bytes, newBytes))
+		{
+			Release(delta);
+			return false;
+		}
+		return true;
+	}
+
+	inline byte_t* BudgetAllocator::Reallocate(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		if (!p)
+			return Allocate(newBytes);
+
+		if (newBytes <= bytes)
+		{
+			const auto q = m_allocator->Reallocate(p, bytes, newBytes);
+			if (q)
+				Release(bytes - newBytes);
+			return q;
+		}
+
+		const auto delta = newBytes - bytes;
+		if (!Reserve(delta))
+			return nullptr;
+
+		const auto q = m_allocator->Reallocate(p, bytes, newBytes);
+		if (!q)
+			Release(delta);
+		return q;
+	}
+
+	inline bool BudgetAllocator::AllocateBatch(const size_t* sizes, size_t count, byte_t** blocks)
+	{
+		size_t total = 0;
+		for (size_t i = 0; i < count; i++)
+			total += sizes[i];
+
+		if (!Reserve(total))
+		{
+			memset(blocks, 0, count * sizeof(byte_t*));
+			return false;
+		}
+
+		if (!m_allocator->AllocateBatch(sizes, count, blocks))
+		{
+			Release(total);
+			return false;
+		}
+		return true;
+	}
+
+	inline void BudgetAllocator::DeallocateBatch(byte_t* const* blocks, const size_t* sizes, size_t count)
+	{
+		size_t total = 0;
+		for (size_t i = 0; i < count; i++)
+		{
+			if (blocks[i])
+				total += sizes[i];
+		}
+
+		m_allocator->DeallocateBatch(blocks, sizes, count);
+		Release(total);
+	}
+
+	inline void BudgetAllocator::SetPressureCallback(PressureCallback callback)
+	{
+		m_callback = std::move(callback);
+	}
+
+	inline void BudgetAllocator::SetTimeout(std::chrono::milliseconds timeout)
+	{
+		m_timeout = timeout;
+	}
+
+	inline void BudgetAllocator::SetBudget(size_t budget)
+	{
+		m_budget = budget;
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_released.notify_all();
+	}
+
+	inline size_t BudgetAllocator::GetBudget() const
+	{
+		return m_budget;
+	}
+
+	inline size_t BudgetAllocator::GetUsed() const
+	{
+		return m_used;
+	}
+
+	inline size_t BudgetAllocator::GetPeak() const
+	{
+		return m_peak;
+	}
+
+	inline size_t BudgetAllocator::GetRejected() const
+	{
+		return m_rejected;
+	}
+
+	inline bool BudgetAllocator::Reserve(size_t bytes)
+	{
+		if (TryReserve(bytes))
+			return true;
+
+		if (bytes <= m_budget)
+		{
+			if (m_callback && m_callback(*this, bytes) && TryReserve(bytes))
+				return true;
+
+			if (m_timeout.count() > 0)
+			{
+				std::unique_lock<std::mutex> lock(m_mutex);
+				// Waiters are registered under the lock, so Release doesn't miss them
+				m_waiters++;
+				const auto reserved = m_released.wait_for(lock, m_timeout, [this, bytes]()
+				{
+					return TryReserve(bytes);
+				});
+				m_waiters--;
+				if (reserved)
+					return true;
+			}
+		}
+
+		m_rejected++;
+		return false;
+	}
+
+	inline bool BudgetAllocator::TryReserve(size_t bytes)
+	{
+		const size_t budget = m_budget;
+		auto used = m_used.load();
+		do
+		{
+			if (bytes > budget || used > budget - bytes)
+				return false;
+		}
+		while (!m_used.compare_exchange_weak(used, used + bytes));
+
+		const auto live = used + bytes;
+		auto peak = m_peak.load(std::memory_order_relaxed);
+		while (live > peak && !m_peak.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+		{
+		}
+		return true;
+	}
+
+	inline void BudgetAllocator::Release(size_t bytes)
+	{
+		if (0 == bytes)
+			return;
+
+		m_used -= bytes;
+		if (m_waiters > 0)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_released.notify_all();
+		}
+	}
+}
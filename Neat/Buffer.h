@@ -1,8 +1,12 @@
 #pragma once
 #include "Neat\Types.h"
 #include "Neat\Allocator.h"
+#include "Neat\AllocatorPolicy.h"
 
+#include <algorithm>
+#include <new>
 #include <type_traits>
+#include <vector>
 
 namespace Neat
 {
@@ -17,30 +21,84 @@ namespace Neat
 		virtual bool IsEmpty() const = 0;
 	};
 
-	template <typename T>
-	class BufferT : public IBuffer
+	namespace Details
+	{
+		// Policy followed by storage of small buffers, it adds nothing to the policy when size is zero
+		template <typename Policy, size_t Size>
+		class InlineStorage : public Policy
+		{
+		public:
+			InlineStorage() = default;
+			InlineStorage(const Policy& policy) : Policy(policy) {}
+
+		protected:
+			byte_t* GetStorage() { return m_storage; }
+			const byte_t* GetStorage() const { return m_storage; }
+
+		private:
+			alignas(IAllocator::DefaultAlignment) byte_t m_storage[Size];
+		};
+
+		template <typename Policy>
+		class InlineStorage<Policy, 0> : public Policy
+		{
+		public:
+			InlineStorage() = default;
+			InlineStorage(const Policy& policy) : Policy(policy) {}
+
+		protected:
+			byte_t* GetStorage() { return nullptr; }
+			const byte_t* GetStorage() const { return nullptr; }
+		};
+	}
+
+	// Policy defaults to IAllocator* chosen at run time, see AllocatorPolicy.h.
+	// Buffers up to InlineSize bytes live inside the object without calling the allocator,
+	// unless they are aligned beyond IAllocator::DefaultAlignment. Moving them copies the bytes.
+	template <typename T, typename Policy = RuntimeAllocatorPolicy, size_t InlineSize = 0>
+	class BufferT : public IBuffer, protected Details::InlineStorage<Policy, InlineSize>
 	{
 		static_assert(std::is_trivial<T>::value, "Only trivial types are allowed!");
 		// For non trivial types use std::vector to ensure constructors are called.
 
+		typedef Details::InlineStorage<Policy, InlineSize> Storage;
+
 	public:
 		typedef T Element;
 
-		explicit BufferT(IAllocator* allocator);
-		// Accepts size in bytes
-		explicit BufferT(size_t size = 0, IAllocator* allocator = nullptr);
-		// Accepts size in bytes
-		BufferT(const T* buffer, size_t size, IAllocator* allocator = nullptr);
+		explicit BufferT(const Policy& allocator);
+		// Accepts size in bytes, alignment of zero means IAllocator::DefaultAlignment
+		explicit BufferT(size_t size = 0, const Policy& allocator = Policy(), size_t alignment = 0);
+		// Accepts size in bytes, alignment of zero means IAllocator::DefaultAlignment
+		BufferT(const T* buffer, size_t size, const Policy& allocator = Policy(), size_t alignment = 0);
+		// Copy takes the allocator of other, see SelectForCopy
 		BufferT(const BufferT& other);
+		BufferT(const BufferT& other, const Policy& allocator);
 		BufferT(BufferT&& other);
 		~BufferT();
 
 		void Allocate(size_t size);
 		void Free();
 
+		// Grows capacity geometrically, so appending in small chunks costs amortized linear time.
+		// Buffer stays unchanged when the allocation fails.
 		BufferT& Append(const T* buffer, size_t size);
 
+		// Accepts capacity in bytes, allocates exactly that much when it's bigger than the current one.
+		// Returns false when the allocation fails, the buffer stays unchanged then.
+		bool Reserve(size_t capacity);
+		// Accepts size in bytes, bytes added beyond the old size are zeroed unless zeroFill is false.
+		// Grows capacity geometrically and never shrinks it. Returns false when the allocation fails.
+		bool Resize(size_t size, bool zeroFill = true);
+		// Releases capacity beyond the size, keeps the buffer when the allocation fails
+		void ShrinkToFit();
+
+		// Allocates zeroed buffers of the given sizes in bytes with one batch call to the allocator.
+		// Returns no buffers when any of the allocations fails.
+		static std::vector<BufferT> AllocateBatch(const size_t* sizes, size_t count, const Policy& allocator = Policy());
+
 		IAllocator* GetAllocator() const;
+		size_t GetAlignment() const;
 
 		operator const T*() const;
 		operator T*();
@@ -51,7 +109,13 @@ namespace Neat
 		// Returns size in bytes
 		size_t GetSize() const override;
 		bool IsEmpty() const override;
+		// Returns allocated bytes, never less than the size
+		size_t GetCapacity() const;
+		// Returns true when the buffer lives inside the object
+		bool IsInline() const;
 
+		// Copy assignment keeps the allocator of this buffer and reuses its capacity,
+		// move assignment takes the allocator of other
 		BufferT& operator=(const BufferT& other);
 		BufferT& operator=(BufferT&& other);
 
@@ -62,19 +126,37 @@ namespace Neat
 		void CopyFrom(const BufferT& other);
 		void MoveFrom(BufferT& other);
 		void DoAllocate(size_t size);
+		bool DoReallocate(size_t size);
+		bool Grow(size_t size);
+		bool SetCapacity(size_t capacity);
+		bool FitsInline(size_t size) const;
+
+		const Policy& GetPolicy() const;
 		
 	protected:
-		IAllocator* m_allocator;
+		size_t m_alignment;
 		T* m_buffer;
 		size_t m_size;
+		size_t m_capacity;
 
 	private:
 		friend void swap(BufferT& left, BufferT& right)
 		{
+			if (left.IsInline() || right.IsInline())
+			{
+				// Inline bytes can't be exchanged by pointers
+				BufferT temp(std::move(left));
+				left.MoveFrom(right);
+				right.MoveFrom(temp);
+				return;
+			}
+
 			using std::swap;
-			swap(left.m_allocator, right.m_allocator);
+			swap(static_cast<Policy&>(left), static_cast<Policy&>(right));
+			swap(left.m_alignment, right.m_alignment);
 			swap(left.m_buffer, right.m_buffer);
 			swap(left.m_size, right.m_size);
+			swap(left.m_capacity, right.m_capacity);
 		}
 
 		friend bool operator==(const BufferT& left, const T* right)
@@ -117,19 +199,23 @@ namespace Neat
 		}
 	};
 
-	template <typename T>
-	BufferT<T>::BufferT(IAllocator* allocator) :
-		m_allocator(allocator),
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>::BufferT(const Policy& allocator) :
+		Storage(allocator),
+		m_alignment(0),
 		m_buffer(nullptr),
-		m_size(0)
+		m_size(0),
+		m_capacity(0)
 	{
 	}
 
-	template <typename T>
-	BufferT<T>::BufferT(size_t size, IAllocator* allocator) :
-		m_allocator(allocator),
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>::BufferT(size_t size, const Policy& allocator, size_t alignment) :
+		Storage(allocator),
+		m_alignment(alignment),
 		m_buffer(nullptr),
-		m_size(0)
+		m_size(0),
+		m_capacity(0)
 	{
 		if (size > 0)
 			DoAllocate(size);
@@ -138,11 +224,13 @@ namespace Neat
 			memset(m_buffer, 0, m_size);
 	}
 
-	template <typename T>
-	BufferT<T>::BufferT(const T* buffer, size_t size, IAllocator* allocator) :
-		m_allocator(allocator),
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>::BufferT(const T* buffer, size_t size, const Policy& allocator, size_t alignment) :
+		Storage(allocator),
+		m_alignment(alignment),
 		m_buffer(nullptr),
-		m_size(0)
+		m_size(0),
+		m_capacity(0)
 	{
 		if (size > 0)
 			DoAllocate(size);
@@ -151,29 +239,43 @@ namespace Neat
 			memcpy(m_buffer, buffer, m_size);
 	}
 
-	template <typename T>
-	BufferT<T>::BufferT(const BufferT& other) :
-		m_allocator(nullptr),
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>::BufferT(const BufferT& other) :
+		Storage(other.GetPolicy().SelectForCopy()),
+		m_alignment(other.m_alignment),
 		m_buffer(nullptr),
-		m_size(0)
+		m_size(0),
+		m_capacity(0)
 	{
 		CopyFrom(other);
 	}
 
-	template <typename T>
-	BufferT<T>::BufferT(BufferT&& other)
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>::BufferT(const BufferT& other, const Policy& allocator) :
+		Storage(allocator),
+		m_alignment(other.m_alignment),
+		m_buffer(nullptr),
+		m_size(0),
+		m_capacity(0)
+	{
+		CopyFrom(other);
+	}
+
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>::BufferT(BufferT&& other) :
+		Storage(other.GetPolicy())
 	{
 		MoveFrom(other);
 	}
 
-	template <typename T>
-	BufferT<T>::~BufferT()
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>::~BufferT()
 	{
 		Free();
 	}
 
-	template <typename T>
-	void BufferT<T>::Allocate(size_t size)
+	template <typename T, typename Policy, size_t InlineSize>
+	void BufferT<T, Policy, InlineSize>::Allocate(size_t size)
 	{
 		Free();
 
@@ -184,91 +286,176 @@ namespace Neat
 			memset(m_buffer, 0, m_size);
 	}
 
-	template <typename T>
-	void BufferT<T>::Free()
+	template <typename T, typename Policy, size_t InlineSize>
+	void BufferT<T, Policy, InlineSize>::Free()
 	{
-		if (m_size > 0)
+		if (m_capacity > 0)
 		{
-			const auto p = reinterpret_cast<byte_t*>(m_buffer);
-			m_allocator ? m_allocator->Deallocate(p, m_size) : delete[] p;
+			if (!IsInline())
+				Policy::DeallocateBlock(reinterpret_cast<byte_t*>(m_buffer), m_capacity, m_alignment);
 			m_buffer = nullptr;
 			m_size = 0;
+			m_capacity = 0;
 		}
 	}
 
-	template <typename T>
-	BufferT<T>& BufferT<T>::Append(const T* buffer, size_t size)
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>& BufferT<T, Policy, InlineSize>::Append(const T* buffer, size_t size)
 	{
-		BufferT other(m_size + size, m_allocator);
-		memcpy_s(other.m_buffer, other.m_size, m_buffer, m_size);
-		const auto p = reinterpret_cast<byte_t*>(other.m_buffer);
-		memcpy_s(p + m_size, other.m_size - m_size, buffer, size);
-		swap(*this, other);
+		if (0 == size)
+			return *this;
+
+		const auto source = reinterpret_cast<const byte_t*>(buffer);
+		const auto begin = reinterpret_cast<const byte_t*>(m_buffer);
+		// Source may point into this buffer, which moves when it can't grow in place
+		const auto inside = source >= begin && source < begin + m_size;
+		const auto offset = inside ? source - begin : 0;
+		if (m_size + size > m_capacity && !Grow(m_size + size))
+			return *this;
+
+		const auto p = reinterpret_cast<byte_t*>(m_buffer);
+		memcpy_s(p + m_size, m_capacity - m_size, inside ? p + offset : source, size);
+		m_size += size;
 		return *this;
 	}
 
-	template <typename T>
-	IAllocator* BufferT<T>::GetAllocator() const
+	template <typename T, typename Policy, size_t InlineSize>
+	bool BufferT<T, Policy, InlineSize>::Reserve(size_t capacity)
+	{
+		if (capacity <= m_capacity)
+			return true;
+
+		return SetCapacity(capacity);
+	}
+
+	template <typename T, typename Policy, size_t InlineSize>
+	bool BufferT<T, Policy, InlineSize>::Resize(size_t size, bool zeroFill)
+	{
+		if (size > m_capacity && !Grow(size))
+			return false;
+
+		if (zeroFill && size > m_size)
+			memset(reinterpret_cast<byte_t*>(m_buffer) + m_size, 0, size - m_size);
+		m_size = size;
+		return true;
+	}
+
+	template <typename T, typename Policy, size_t InlineSize>
+	void BufferT<T, Policy, InlineSize>::ShrinkToFit()
+	{
+		if (0 == m_size)
+			Free();
+		else if (m_size < m_capacity)
+			SetCapacity(m_size);
+	}
+
+	template <typename T, typename Policy, size_t InlineSize>
+	std::vector<BufferT<T, Policy, InlineSize>> BufferT<T, Policy, InlineSize>::AllocateBatch(const size_t* sizes, size_t count, const Policy& allocator)
+	{
+		std::vector<BufferT> buffers;
+		buffers.reserve(count);
+		std::vector<byte_t*> blocks(count);
+		Policy policy(allocator);
+		if (!policy.AllocateBlocks(sizes, count, blocks.data()))
+			return buffers;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			buffers.emplace_back(allocator);
+			if (blocks[i])
+			{
+				auto& buffer = buffers.back();
+				buffer.m_buffer = reinterpret_cast<T*>(blocks[i]);
+				buffer.m_size = sizes[i];
+				buffer.m_capacity = sizes[i];
+				memset(buffer.m_buffer, 0, buffer.m_size);
+			}
+		}
+		return buffers;
+	}
+
+	template <typename T, typename Policy, size_t InlineSize>
+	IAllocator* BufferT<T, Policy, InlineSize>::GetAllocator() const
 	{
-		return m_allocator;
+		return Policy::GetAllocator();
 	}
 
-	template <typename T>
-	BufferT<T>::operator const T*() const
+	template <typename T, typename Policy, size_t InlineSize>
+	size_t BufferT<T, Policy, InlineSize>::GetAlignment() const
+	{
+		return m_alignment;
+	}
+
+	template <typename T, typename Policy, size_t InlineSize>
+	bool BufferT<T, Policy, InlineSize>::IsInline() const
+	{
+		return InlineSize > 0 && m_buffer && reinterpret_cast<const byte_t*>(m_buffer) == Storage::GetStorage();
+	}
+
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>::operator const T*() const
 	{
 		return m_buffer;
 	}
 
-	template <typename T>
-	BufferT<T>::operator T*()
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>::operator T*()
 	{
 		return m_buffer;
 	}
 
-	template <typename T>
-	const byte_t* BufferT<T>::GetBuffer() const
+	template <typename T, typename Policy, size_t InlineSize>
+	const byte_t* BufferT<T, Policy, InlineSize>::GetBuffer() const
 	{
 		return reinterpret_cast<const byte_t*>(m_buffer);
 	}
 
-	template <typename T>
-	byte_t* BufferT<T>::GetBuffer()
+	template <typename T, typename Policy, size_t InlineSize>
+	byte_t* BufferT<T, Policy, InlineSize>::GetBuffer()
 	{
 		return reinterpret_cast<byte_t*>(m_buffer);
 	}
 
-	template <typename T>
-	size_t BufferT<T>::GetSize() const
+	template <typename T, typename Policy, size_t InlineSize>
+	size_t BufferT<T, Policy, InlineSize>::GetSize() const
 	{
 		return m_size;
 	}
 
-	template <typename T>
-	bool BufferT<T>::IsEmpty() const
+	template <typename T, typename Policy, size_t InlineSize>
+	bool BufferT<T, Policy, InlineSize>::IsEmpty() const
 	{
 		return 0 == m_size;
 	}
 
-	template <typename T>
-	BufferT<T>& BufferT<T>::operator=(const BufferT<T>& other)
+	template <typename T, typename Policy, size_t InlineSize>
+	size_t BufferT<T, Policy, InlineSize>::GetCapacity() const
+	{
+		return m_capacity;
+	}
+
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>& BufferT<T, Policy, InlineSize>::operator=(const BufferT& other)
 	{
 		if (this != &other)
 		{
-			if (m_size == other.m_size)
+			if (other.m_size <= m_capacity)
 			{
-				memcpy(m_buffer, other.m_buffer, m_size);
+				if (other.m_size > 0)
+					memcpy(m_buffer, other.m_buffer, other.m_size);
+				m_size = other.m_size;
 			}
 			else
 			{
-				Free(); //TODO: introduce capacity, to avoid unnecessary allocations
+				Free();
 				CopyFrom(other);
 			}
 		}
 		return *this;
 	}
 
-	template <typename T>
-	BufferT<T>& BufferT<T>::operator=(BufferT<T>&& other)
+	template <typename T, typename Policy, size_t InlineSize>
+	BufferT<T, Policy, InlineSize>& BufferT<T, Policy, InlineSize>::operator=(BufferT&& other)
 	{
 		if (this != &other)
 		{
@@ -278,20 +465,20 @@ namespace Neat
 		return *this;
 	}
 
-	template <typename T>
-	const T* BufferT<T>::operator->() const
+	template <typename T, typename Policy, size_t InlineSize>
+	const T* BufferT<T, Policy, InlineSize>::operator->() const
 	{
 		return m_buffer;
 	}
 
-	template <typename T>
-	T* BufferT<T>::operator->()
+	template <typename T, typename Policy, size_t InlineSize>
+	T* BufferT<T, Policy, InlineSize>::operator->()
 	{
 		return m_buffer;
 	}
 
-	template <typename T>
-	void BufferT<T>::CopyFrom(const BufferT& other)
+	template <typename T, typename Policy, size_t InlineSize>
+	void BufferT<T, Policy, InlineSize>::CopyFrom(const BufferT& other)
 	{
 		if (other.m_size > 0)
 		{
@@ -300,33 +487,141 @@ namespace Neat
 		}
 	}
 
-	template <typename T>
-	void BufferT<T>::MoveFrom(BufferT& other)
+	template <typename T, typename Policy, size_t InlineSize>
+	void BufferT<T, Policy, InlineSize>::MoveFrom(BufferT& other)
 	{
-		m_allocator = other.m_allocator;
-		m_buffer = other.m_buffer;
+		static_cast<Policy&>(*this) = static_cast<Policy&>(other);
+		m_alignment = other.m_alignment;
+		if (other.IsInline())
+		{
+			m_buffer = reinterpret_cast<T*>(Storage::GetStorage());
+			memcpy(m_buffer, other.m_buffer, other.m_size);
+		}
+		else
+		{
+			m_buffer = other.m_buffer;
+		}
 		m_size = other.m_size;
+		m_capacity = other.m_capacity;
 
-		other.m_allocator = nullptr;
+		// Moved-from buffer keeps its policy, a default one would pick up the current scope
+		other.m_alignment = 0;
 		other.m_buffer = nullptr;
 		other.m_size = 0;
+		other.m_capacity = 0;
 	}
 
-	template <typename T>
-	void BufferT<T>::DoAllocate(size_t size)
+	template <typename T, typename Policy, size_t InlineSize>
+	void BufferT<T, Policy, InlineSize>::DoAllocate(size_t size)
 	{
-		const auto p = m_allocator ? m_allocator->Allocate(size) : new byte_t[size];
+		if (FitsInline(size))
+		{
+			m_buffer = reinterpret_cast<T*>(Storage::GetStorage());
+			m_size = size;
+			m_capacity = InlineSize;
+			return;
+		}
+
+		const auto p = Policy::AllocateBlock(size, m_alignment);
 		if (p)
 		{
 			m_buffer = reinterpret_cast<T*>(p);
 			m_size = size;
+			m_capacity = size;
 		}
 		else
 		{
 			m_buffer = nullptr;
 			m_size = 0;
+			m_capacity = 0;
 		}
 	}
 
+	// Resizes keeping the contents, in place when allocator supports it.
+	// Returns false when policy can't reallocate, buffer is over-aligned or reallocation failed.
+	template <typename T, typename Policy, size_t InlineSize>
+	bool BufferT<T, Policy, InlineSize>::DoReallocate(size_t size)
+	{
+		if (IsInline())
+			return false;
+
+		const auto p = Policy::ReallocateBlock(reinterpret_cast<byte_t*>(m_buffer), m_capacity, size, m_alignment);
+		if (!p)
+			return false;
+
+		m_buffer = reinterpret_cast<T*>(p);
+		m_size = size;
+		m_capacity = size;
+		return true;
+	}
+
+	// Grows capacity by half at least, which is the growth factor of std::vector in MSVC.
+	// Freed blocks may then be reused by later growth, unlike with doubling.
+	template <typename T, typename Policy, size_t InlineSize>
+	bool BufferT<T, Policy, InlineSize>::Grow(size_t size)
+	{
+		const auto geometric = m_capacity + m_capacity / 2;
+		return SetCapacity((std::max)(size, geometric));
+	}
+
+	// Moves contents to a block of the given capacity, which must hold the size.
+	// Reallocates in place when allocator supports it, otherwise copies to a new block.
+	// Capacity which fits inline storage moves the contents there.
+	template <typename T, typename Policy, size_t InlineSize>
+	bool BufferT<T, Policy, InlineSize>::SetCapacity(size_t capacity)
+	{
+		const auto old = reinterpret_cast<byte_t*>(m_buffer);
+		const auto inlined = IsInline();
+		if (FitsInline(capacity))
+		{
+			if (!inlined)
+			{
+				const auto storage = Storage::GetStorage();
+				if (m_size > 0)
+					memcpy(storage, old, m_size);
+				if (m_capacity > 0)
+					Policy::DeallocateBlock(old, m_capacity, m_alignment);
+				m_buffer = reinterpret_cast<T*>(storage);
+			}
+			m_capacity = InlineSize;
+			return true;
+		}
+
+		auto p = inlined ? nullptr : Policy::ReallocateBlock(old, m_capacity, capacity, m_alignment);
+		if (!p)
+		{
+			p = Policy::AllocateBlock(capacity, m_alignment);
+			if (!p)
+				return false;
+
+			if (m_size > 0)
+				memcpy(p, old, m_size);
+			if (m_capacity > 0 && !inlined)
+				Policy::DeallocateBlock(old, m_capacity, m_alignment);
+		}
+
+		m_buffer = reinterpret_cast<T*>(p);
+		m_capacity = capacity;
+		return true;
+	}
+
+	template <typename T, typename Policy, size_t InlineSize>
+	bool BufferT<T, Policy, InlineSize>::FitsInline(size_t size) const
+	{
+		return InlineSize > 0 && size <= InlineSize && m_alignment <= IAllocator::DefaultAlignment;
+	}
+
+	template <typename T, typename Policy, size_t InlineSize>
+	const Policy& BufferT<T, Policy, InlineSize>::GetPolicy() const
+	{
+		return *this;
+	}
+
 	typedef BufferT<byte_t> Buffer;
+
+	// Keeps up to N bytes inside the object, e.g. hashes, Uuid bytes or protocol headers
+	template <typename T, size_t N, typename Policy = RuntimeAllocatorPolicy>
+	using SmallBufferT = BufferT<T, Policy, N>;
+
+	typedef SmallBufferT<byte_t, 64> SmallBuffer;
 }
\ No newline at end of file
@@ -0,0 +1,260 @@
+#pragma once
+#include "Neat\Types.h"
+#include "Neat\AllocatorPolicy.h"
+#include "Neat\Buffer.h"
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+namespace Neat
+{
+	//
+	// Segmented buffer which appends into fixed-size segments drawn from an allocator, so building
+	// large output costs linear time without reallocating or copying what was appended before.
+	// Segments are exposed as list of pointer and size pairs for vectored writes. Contiguous view
+	// flattens the segments into one block on demand, appending continues with new segments then.
+	//
+
+	class BufferChain : public IBuffer
+	{
+	public:
+		static constexpr size_t DefaultSegmentSize = 4_kB;
+
+		// Bytes of a segment, e.g. to fill WSABUF array, data of the last one may be followed by
+		// unused capacity
+		struct Segment
+		{
+			byte_t* data;
+			size_t size;
+		};
+
+		// Allocator is chosen like by RuntimeAllocatorPolicy
+		explicit BufferChain(IAllocator* allocator = nullptr, size_t segmentSize = DefaultSegmentSize);
+		BufferChain(const BufferChain& other) = delete;
+		BufferChain(BufferChain&& other);
+		~BufferChain();
+
+		BufferChain& operator=(const BufferChain& other) = delete;
+		BufferChain& operator=(BufferChain&& other);
+
+		// Returns false when a segment can't be allocated, nothing is appended then
+		bool Append(const byte_t* buffer, size_t size);
+		bool Append(const IBuffer& buffer);
+		void Clear();
+
+		const Segment* GetSegments() const;
+		size_t GetSegmentCount() const;
+		size_t GetSegmentSize() const;
+		IAllocator* GetAllocator() const;
+
+		// Copies contents into one block unless they already are contiguous.
+		// Returns nullptr when the block can't be allocated, segments stay as they were then.
+		byte_t* Flatten();
+
+		// Contiguous view flattens the segments, see Flatten. Flattening keeps the contents, so
+		// const chains flatten too, but it replaces the segments and invalidates what GetSegments
+		// returned before, so even const access must not be shared by threads. Throws
+		// std::bad_alloc when a chain with contents can't be flattened.
+		const byte_t* GetBuffer() const override;
+		byte_t* GetBuffer() override;
+
+		// Returns size in bytes
+		size_t GetSize() const override;
+		bool IsEmpty() const override;
+
+	private:
+		byte_t* FlattenSegments() const;
+		void FreeSegments() const;
+
+	private:
+		// Allocator and segments change when a const chain is flattened, see GetBuffer
+		mutable RuntimeAllocatorPolicy m_policy;
+		size_t m_segmentSize;
+		size_t m_size;
+		mutable std::vector<Segment> m_segments;
+		// Allocated bytes of each segment
+		mutable std::vector<size_t> m_capacities;
+	};
+
+	inline BufferChain::BufferChain(IAllocator* allocator, size_t segmentSize) :
+		m_policy(allocator),
+		m_segmentSize(segmentSize > 0 ? segmentSize : DefaultSegmentSize),
+		m_size(0)
+	{
+	}
+
+	inline BufferChain::BufferChain(BufferChain&& other) :
+		m_policy(other.m_policy),
+		m_segmentSize(other.m_segmentSize),
+		m_size(other.m_size),
+		m_segments(std::move(other.m_segments)),
+		m_capacities(std::move(other.m_capacities))
+	{
+		other.m_size = 0;
+		other.m_segments.clear();
+		other.m_capacities.clear();
+	}
+
+	inline BufferChain::~BufferChain()
+	{
+		FreeSegments();
+	}
+
+	inline BufferChain& BufferChain::operator=(BufferChain&& other)
+	{
+		if (this != &other)
+		{
+			FreeSegments();
+			m_policy = other.m_policy;
+			m_segmentSize = other.m_segmentSize;
+			m_size = other.m_size;
+			m_segments = std::move(other.m_segments);
+			m_capacities = std::move(other.m_capacities);
+			other.m_size = 0;
+			other.m_segments.clear();
+			other.m_capacities.clear();
+		}
+		return *this;
+	}
+
+	inline bool BufferChain::Append(const byte_t* buffer, size_t size)
+	{
+		if (0 == size)
+			return true;
+
+		const auto last = m_segments.empty() ? 0 : m_capacities.back() - m_segments.back().size;
+		const auto first = m_segments.size();
+		if (size > last)
+		{
+			// All segments are allocated before copying, so failure leaves the chain unchanged
+			const auto count = (size - last + m_segmentSize - 1) / m_segmentSize;
+			m_segments.reserve(first + count);
+			m_capacities.reserve(first + count);
+			for (size_t i = 0; i < count; i++)
+			{
+				const auto p = m_policy.AllocateBlock(m_segmentSize, 0);
+				if (!p)
+				{
+					for (auto j = m_segments.size(); j > first; j--)
+						m_policy.DeallocateBlock(m_segments[j - 1].data, m_capacities[j - 1], 0);
+					m_segments.resize(first);
+					m_capacities.resize(first);
+					return false;
+				}
+				m_segments.push_back({ p, 0 });
+				m_capacities.push_back(m_segmentSize);
+			}
+		}
+
+		// Fills the free space of the last segment, then the new ones
+		auto source = buffer;
+		auto rest = size;
+		for (auto i = (last > 0) ? first - 1 : first; rest > 0; i++)
+		{
+			auto& segment = m_segments[i];
+			const auto bytes = (std::min)(rest, m_capacities[i] - segment.size);
+			memcpy(segment.data + segment.size, source, bytes);
+			segment.size += bytes;
+			source += bytes;
+			rest -= bytes;
+		}
+		m_size += size;
+		return true;
+	}
+
+	inline bool BufferChain::Append(const IBuffer& buffer)
+	{
+		return Append(buffer.GetBuffer(), buffer.GetSize());
+	}
+
+	inline void BufferChain::Clear()
+	{
+		FreeSegments();
+		m_segments.clear();
+		m_capacities.clear();
+		m_size = 0;
+	}
+
+	inline const BufferChain::Segment* BufferChain::GetSegments() const
+	{
+		return m_segments.data();
+	}
+
+	inline size_t BufferChain::GetSegmentCount() const
+	{
+		return m_segments.size();
+	}
+
+	inline size_t BufferChain::GetSegmentSize() const
+	{
+		return m_segmentSize;
+	}
+
+	inline IAllocator* BufferChain::GetAllocator() const
+	{
+		return m_policy.GetAllocator();
+	}
+
+	inline byte_t* BufferChain::Flatten()
+	{
+		return FlattenSegments();
+	}
+
+	inline const byte_t* BufferChain::GetBuffer() const
+	{
+		const auto p = FlattenSegments();
+		if (!p && m_size > 0)
+			throw std::bad_alloc();
+		return p;
+	}
+
+	inline byte_t* BufferChain::GetBuffer()
+	{
+		const auto p = FlattenSegments();
+		if (!p && m_size > 0)
+			throw std::bad_alloc();
+		return p;
+	}
+
+	inline size_t BufferChain::GetSize() const
+	{
+		return m_size;
+	}
+
+	inline bool BufferChain::IsEmpty() const
+	{
+		return 0 == m_size;
+	}
+
+	inline byte_t* BufferChain::FlattenSegments() const
+	{
+		if (m_segments.empty())
+			return nullptr;
+		if (1 == m_segments.size())
+			return m_segments.front().data;
+
+		const auto p = m_policy.AllocateBlock(m_size, 0);
+		if (!p)
+			return nullptr;
+
+		auto destin = p;
+		for (const auto& segment : m_segments)
+		{
+			memcpy(destin, segment.data, segment.size);
+			destin += segment.size;
+		}
+
+		FreeSegments();
+		m_segments.assign(1, { p, m_size });
+		m_capacities.assign(1, m_size);
+		return p;
+	}
+
+	// Frees in reverse order, so stack-like allocators reclaim the memory
+	inline void BufferChain::FreeSegments() const
+	{
+		for (auto i = m_segments.size(); i > 0; i--)
+			m_policy.DeallocateBlock(m_segments[i - 1].data, m_capacities[i - 1], 0);
+	}
+}
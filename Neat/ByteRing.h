@@ -0,0 +1,212 @@
+#pragma once
+#include "Neat\Types.h"
+#include "Neat\Buffer.h"
+
+#include <algorithm>
+#include <atomic>
+#include <new>
+#include <stdexcept>
+
+namespace Neat
+{
+	//
+	// Bounded lock free ring of bytes handed from one producer thread to one consumer thread.
+	// Producer writes into contiguous spans of Reserve and publishes them by Commit, consumer reads
+	// spans of Peek and releases them by Consume, so bytes pass without allocations or locks.
+	// Indexes only grow, head and tail sit on separate cache lines and each side reads the index
+	// of the other one once per span, so the lines bounce between threads per span rather than per byte.
+	// Spans end at the end of the region, unless the region is mirrored, e.g. Win::MirroredMemory,
+	// whose second mapping follows the first one, so spans never wrap.
+	//
+
+	class ByteRing
+	{
+	public:
+		struct Span
+		{
+			byte_t* data;
+			size_t size;
+		};
+
+		// Storage is a Buffer of the allocator, capacity is rounded up to a power of two.
+		// Throws std::bad_alloc when the storage can't be allocated.
+		explicit ByteRing(size_t capacity, IAllocator* allocator = nullptr);
+		// Uses region of the caller which must outlive the ring. Mirrored region is capacity bytes
+		// mapped twice back to back. Throws std::invalid_argument unless capacity is a power of two.
+		ByteRing(byte_t* region, size_t capacity, bool mirrored);
+		ByteRing(const ByteRing& other) = delete;
+		ByteRing& operator=(const ByteRing& other) = delete;
+
+		// Producer side
+
+		// Returns contiguous free bytes at the write position, empty span when the ring is full
+		Span Reserve();
+		// Publishes size bytes written to the span of Reserve, commits may split the span.
+		// Throws std::out_of_range when size exceeds the rest of the span.
+		void Commit(size_t size);
+		// Copies as many bytes as fit, returns their count
+		size_t Write(const byte_t* buffer, size_t size);
+
+		// Consumer side
+
+		// Returns contiguous bytes at the read position, empty span when the ring is empty
+		Span Peek();
+		// Releases size bytes read from the span of Peek, consumes may split the span.
+		// Throws std::out_of_range when size exceeds the rest of the span.
+		void Consume(size_t size);
+		// Copies as many bytes as are available, returns their count
+		size_t Read(byte_t* buffer, size_t size);
+
+		size_t GetCapacity() const;
+		// Returns bytes committed but not consumed yet, it's a snapshot when the ring is in use
+		size_t GetSize() const;
+		bool IsMirrored() const;
+
+		// Throws std::length_error when no power of two size_t holds the capacity
+		static size_t RoundUpCapacity(size_t capacity);
+
+	private:
+		static constexpr size_t CacheLine = 64;
+
+		Buffer m_storage;
+		byte_t* m_region;
+		size_t m_capacity;
+		bool m_mirrored;
+
+		// Read position, written by the consumer, with the rest of the span of the last Peek
+		alignas(CacheLine) std::atomic<size_t> m_head;
+		size_t m_peeked;
+
+		// Write position, written by the producer, with the rest of the span of the last Reserve
+		alignas(CacheLine) std::atomic<size_t> m_tail;
+		size_t m_reserved;
+	};
+
+	inline ByteRing::ByteRing(size_t capacity, IAllocator* allocator) :
+		m_storage(RoundUpCapacity(capacity), allocator, CacheLine),
+		m_region(m_storage.GetBuffer()),
+		m_capacity(m_storage.GetSize()),
+		m_mirrored(false),
+		m_head(0),
+		m_peeked(0),
+		m_tail(0),
+		m_reserved(0)
+	{
+		if (!m_region)
+			throw std::bad_alloc();
+	}
+
+	inline ByteRing::ByteRing(byte_t* region, size_t capacity, bool mirrored) :
+		m_region(region),
+		m_capacity(capacity),
+		m_mirrored(mirrored),
+		m_head(0),
+		m_peeked(0),
+		m_tail(0),
+		m_reserved(0)
+	{
+		if (0 == capacity || 0 != (capacity & (capacity - 1)))
+			throw std::invalid_argument("Ring capacity must be a power of two");
+	}
+
+	inline ByteRing::Span ByteRing::Reserve()
+	{
+		const auto tail = m_tail.load(std::memory_order_relaxed);
+		const auto free = m_capacity - (tail - m_head.load(std::memory_order_acquire));
+		const auto offset = tail & (m_capacity - 1);
+		m_reserved = m_mirrored ? free : (std::min)(free, m_capacity - offset);
+		return { m_reserved > 0 ? m_region + offset : nullptr, m_reserved };
+	}
+
+	inline void ByteRing::Commit(size_t size)
+	{
+		// Span ends at the end of the region, bytes past it weren't written into the ring
+		if (size > m_reserved)
+			throw std::out_of_range("size > reserved");
+
+		m_reserved -= size;
+		// Release makes the written bytes visible before the new tail
+		m_tail.store(m_tail.load(std::memory_order_relaxed) + size, std::memory_order_release);
+	}
+
+	inline size_t ByteRing::Write(const byte_t* buffer, size_t size)
+	{
+		size_t written = 0;
+		while (written < size)
+		{
+			const auto span = Reserve();
+			if (0 == span.size)
+				break;
+
+			const auto bytes = (std::min)(span.size, size - written);
+			memcpy(span.data, buffer + written, bytes);
+			Commit(bytes);
+			written += bytes;
+		}
+		return written;
+	}
+
+	inline ByteRing::Span ByteRing::Peek()
+	{
+		const auto head = m_head.load(std::memory_order_relaxed);
+		const auto available = m_tail.load(std::memory_order_acquire) - head;
+		const auto offset = head & (m_capacity - 1);
+		m_peeked = m_mirrored ? available : (std::min)(available, m_capacity - offset);
+		return { m_peeked > 0 ? m_region + offset : nullptr, m_peeked };
+	}
+
+	inline void ByteRing::Consume(size_t size)
+	{
+		if (size > m_peeked)
+			throw std::out_of_range("size > peeked");
+
+		m_peeked -= size;
+		// Release keeps reads of the bytes before the producer may overwrite them
+		m_head.store(m_head.load(std::memory_order_relaxed) + size, std::memory_order_release);
+	}
+
+	inline size_t ByteRing::Read(byte_t* buffer, size_t size)
+	{
+		size_t read = 0;
+		while (read < size)
+		{
+			const auto span = Peek();
+			if (0 == span.size)
+				break;
+
+			const auto bytes = (std::min)(span.size, size - read);
+			memcpy(buffer + read, span.data, bytes);
+			Consume(bytes);
+			read += bytes;
+		}
+		return read;
+	}
+
+	inline size_t ByteRing::GetCapacity() const
+	{
+		return m_capacity;
+	}
+
+	inline size_t ByteRing::GetSize() const
+	{
+		const auto head = m_head.load(std::memory_order_acquire);
+		return m_tail.load(std::memory_order_acquire) - head;
+	}
+
+	inline bool ByteRing::IsMirrored() const
+	{
+		return m_mirrored;
+	}
+
+	inline size_t ByteRing::RoundUpCapacity(size_t capacity)
+	{
+		const auto largest = ~(SIZE_MAX >> 1);
+		if (capacity > largest)
+			throw std::length_error("Ring capacity is too large");
+
+		size_t rounded = CacheLine;
+		while (rounded < capacity)
+			rounded <<= 1;
+		return rounded;
+	}
+}
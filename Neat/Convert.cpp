@@ -119,127 +119,178 @@ namespace Neat::Convert
 		return byte;
 	}
 
+	//
+	// UTF-8 <-> UTF-16
+	//
+
+	typedef std::codecvt_utf8_utf16<wchar_t> Utf8Utf16;
+
+	// Converts chunk by chunk into a small buffer just to count code units of the result
+	size_t CountUtf8(const Utf8Utf16& codec, const wchar_t* begin, const wchar_t* end)
+	{
+		std::mbstate_t state = {};
+		char chunk[256];
+		size_t count = 0;
+		while (begin != end)
+		{
+			const wchar_t* from = nullptr;
+			char* to = nullptr;
+			const auto result = codec.out(state, begin, end, from, chunk, chunk + _countof(chunk), to);
+			if (std::codecvt_base::error == result || (from == begin && to == chunk))
+				throw std::range_error("Invalid UTF-16");
+			count += to - chunk;
+			begin = from;
+		}
+		return count;
+	}
+
+	size_t CountUtf16(const Utf8Utf16& codec, const char* begin, const char* end)
+	{
+		std::mbstate_t state = {};
+		wchar_t chunk[256];
+		size_t count = 0;
+		while (begin != end)
+		{
+			const char* from = nullptr;
+			wchar_t* to = nullptr;
+			const auto result = codec.in(state, begin, end, from, chunk, chunk + _countof(chunk), to);
+			if (std::codecvt_base::error == result || (from == begin && to == chunk))
+				throw std::range_error("Invalid UTF-8");
+			count += to - chunk;
+			begin = from;
+		}
+		return count;
+	}
+
 	//
 	// ToUtf8
 	//
 
-	Utf8 ToUtf8(const char* value)
+	Utf8 ToUtf8(const char* value, IAllocator* allocator)
 	{
-		return Utf8(value);
+		return Utf8(value, Utf8::End, allocator);
 	}
 
-	Utf8 ToUtf8(const wchar_t* value)
+	Utf8 ToUtf8(const wchar_t* value, IAllocator* allocator)
 	{
-		std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> convert;
-		const auto result = convert.to_bytes(value);
-		return Utf8{ result.c_str(), result.size() };
+		if (nullptr == value)
+			return Utf8(allocator);
+
+		// Length is counted first, so the result is the only allocation
+		Utf8Utf16 codec;
+		const auto end = value + Utf16::GetLength(value);
+		const auto length = CountUtf8(codec, value, end);
+		Utf8 result(length, allocator);
+		if (nullptr != result.GetString())
+		{
+			std::mbstate_t state = {};
+			const wchar_t* from = nullptr;
+			char* to = nullptr;
+			codec.out(state, value, end, from, result.GetString(), result.GetString() + length, to);
+		}
+		return result;
 	}
 
-	Utf8 ToUtf8(const Utf8& value)
+	Utf8 ToUtf8(const Utf8& value, IAllocator* allocator)
 	{
-		return Utf8(value);
+		return Utf8(value, allocator ? allocator : value.GetAllocator());
 	}
 
-	Utf8 ToUtf8(const Utf16& value)
+	Utf8 ToUtf8(const Utf16& value, IAllocator* allocator)
 	{
-		return ToUtf8(value.operator const wchar_t*());
+		return ToUtf8(value.operator const wchar_t*(), allocator ? allocator : value.GetAllocator());
 	}
 
-	Utf8 ToUtf8(const std::string& value)
+	Utf8 ToUtf8(const std::string& value, IAllocator* allocator)
 	{
-		return Utf8(value.c_str());
+		return Utf8(value.c_str(), Utf8::End, allocator);
 	}
 
-	Utf8 ToUtf8(const std::wstring& value)
+	Utf8 ToUtf8(const std::wstring& value, IAllocator* allocator)
 	{
-		return ToUtf8(value.c_str());
+		return ToUtf8(value.c_str(), allocator);
 	}
 
-	Utf8 ToUtf8(const int32_t value)
+	Utf8 ToUtf8(const int32_t value, IAllocator* allocator)
 	{
-		return Utf8::Format("%i", value);
+		return Utf8::Format(allocator, "%i", value);
 	}
 
-	Utf8 ToUtf8(const int64_t value)
+	Utf8 ToUtf8(const int64_t value, IAllocator* allocator)
 	{
-		return Utf8::Format("%lli", value);
+		return Utf8::Format(allocator, "%lli", value);
 	}
 
-	Utf8 ToUtf8(const uint8_t value, Base base)
+	Utf8 ToUtf8(const uint8_t value, Base base, IAllocator* allocator)
 	{
 		switch (base)
 		{
 		case Base::Dec:
-			return Utf8::Format("%u", value);
+			return Utf8::Format(allocator, "%u", value);
 		}
 
-		Utf8 result;
-		result.Reserve(2);
+		Utf8 result(2, allocator);
 		ToHex(result.GetString(), value, base);
 		return result;
 	}
 
-	Utf8 ToUtf8(const uint16_t value, Base base)
+	Utf8 ToUtf8(const uint16_t value, Base base, IAllocator* allocator)
 	{
 		switch (base)
 		{
 		case Base::Dec:
-			return Utf8::Format("%hu", value);
+			return Utf8::Format(allocator, "%hu", value);
 		}
 
-		Utf8 result;
-		result.Reserve(4);
+		Utf8 result(4, allocator);
 		ToHex(result.GetString(), value, base);
 		return result;
 	}
 
-	Utf8 ToUtf8(const uint32_t value, Base base)
+	Utf8 ToUtf8(const uint32_t value, Base base, IAllocator* allocator)
 	{
 		switch (base)
 		{
 		case Base::Dec:
-			return Utf8::Format("%u", value);
+			return Utf8::Format(allocator, "%u", value);
 		}
 
-		Utf8 result;
-		result.Reserve(8);
+		Utf8 result(8, allocator);
 		ToHex(result.GetString(), value, base);
 		return result;
 	}
 
-	Utf8 ToUtf8(const uint64_t value, Base base)
+	Utf8 ToUtf8(const uint64_t value, Base base, IAllocator* allocator)
 	{
 		switch (base)
 		{
 		case Base::Dec:
-			return Utf8::Format("%llu", value);
+			return Utf8::Format(allocator, "%llu", value);
 		}
 
-		Utf8 result;
-		result.Reserve(16);
+		Utf8 result(16, allocator);
 		ToHex(result.GetString(), value, base);
 		return result;
 	}
 
-	Utf8 ToUtf8(const double value)
+	Utf8 ToUtf8(const double value, IAllocator* allocator)
 	{
-		return Utf8::Format("%f", value);
+		return Utf8::Format(allocator, "%f", value);
 	}
 
-	Utf8 ToUtf8(const IBuffer& value, Base base)
+	Utf8 ToUtf8(const IBuffer& value, Base base, IAllocator* allocator)
 	{
 		const auto buffer = value.GetBuffer();
 		const auto size = value.GetSize();
 
-		Utf8 result;
-		result.Reserve(size * 2);
+		Utf8 result(size * 2, allocator);
 		for (size_t i = 0; i < size; i++)
 			ToHex(result + i * 2, buffer[i], base);
 
 		return result;
 	}
 
-	Utf8 ToUtf8(const Uuid& value, Base base)
+	Utf8 ToUtf8(const Uuid& value, Base base, IAllocator* allocator)
 	{
 		switch (base)
 		{
@@ -247,7 +298,7 @@ namespace Neat::Convert
 			throw std::runtime_error("Not implemented");
 		}
 
-		Utf8 result = "00000000-0000-0000-0000-000000000000";
+		Utf8 result("00000000-0000-0000-0000-000000000000", Utf8::End, allocator);
 		auto buffer = result.GetString();
 
 		const auto& data1 = value.GetData1();
@@ -278,123 +329,131 @@ namespace Neat::Convert
 	// ToUtf16
 	//
 
-	Utf16 ToUtf16(const char* value)
+	Utf16 ToUtf16(const char* value, IAllocator* allocator)
 	{
-		std::wstring_convert<std::codecvt_utf8_utf16<wchar_t>> convert;
-		const auto result = convert.from_bytes(value);
-		return Utf16{ result.c_str(), result.size() };
+		if (nullptr == value)
+			return Utf16(allocator);
+
+		// Length is counted first, so the result is the only allocation
+		Utf8Utf16 codec;
+		const auto end = value + strlen(value);
+		const auto length = CountUtf16(codec, value, end);
+		Utf16 result(length, allocator);
+		if (nullptr != result.GetString())
+		{
+			std::mbstate_t state = {};
+			const char* from = nullptr;
+			wchar_t* to = nullptr;
+			codec.in(state, value, end, from, result.GetString(), result.GetString() + length, to);
+		}
+		return result;
 	}
 
-	Utf16 ToUtf16(const wchar_t* value)
+	Utf16 ToUtf16(const wchar_t* value, IAllocator* allocator)
 	{
-		return Utf16(value);
+		return Utf16(value, Utf16::End, allocator);
 	}
 
-	Utf16 ToUtf16(const Utf8& value)
+	Utf16 ToUtf16(const Utf8& value, IAllocator* allocator)
 	{
-		return ToUtf16(value.operator const char*());
+		return ToUtf16(value.operator const char*(), allocator ? allocator : value.GetAllocator());
 	}
 
-	Utf16 ToUtf16(const Utf16& value)
+	Utf16 ToUtf16(const Utf16& value, IAllocator* allocator)
 	{
-		return Utf16(value);
+		return Utf16(value, allocator ? allocator : value.GetAllocator());
 	}
 
-	Utf16 ToUtf16(const std::string& value)
+	Utf16 ToUtf16(const std::string& value, IAllocator* allocator)
 	{
-		return ToUtf16(value.c_str());
+		return ToUtf16(value.c_str(), allocator);
 	}
 
-	Utf16 ToUtf16(const std::wstring& value)
+	Utf16 ToUtf16(const std::wstring& value, IAllocator* allocator)
 	{
-		return Utf16(value.c_str());
+		return Utf16(value.c_str(), Utf16::End, allocator);
 	}
 
-	Utf16 ToUtf16(const int32_t value)
+	Utf16 ToUtf16(const int32_t value, IAllocator* allocator)
 	{
-		return Utf16::Format(L"%i", value);
+		return Utf16::Format(allocator, L"%i", value);
 	}
 
-	Utf16 ToUtf16(const int64_t value)
+	Utf16 ToUtf16(const int64_t value, IAllocator* allocator)
 	{
-		return Utf16::Format(L"%lli", value);
+		return Utf16::Format(allocator, L"%lli", value);
 	}
 
-	Utf16 ToUtf16(const uint8_t value, Base base)
+	Utf16 ToUtf16(const uint8_t value, Base base, IAllocator* allocator)
 	{
 		switch (base)
 		{
 		case Base::Dec:
-			return Utf16::Format(L"%u", value);
+			return Utf16::Format(allocator, L"%u", value);
 		}
 
-		Utf16 result;
-		result.Reserve(2);
+		Utf16 result(2, allocator);
 		ToHex(result.GetString(), value, base);
 		return result;
 	}
 	
-	Utf16 ToUtf16(const uint16_t value, Base base)
+	Utf16 ToUtf16(const uint16_t value, Base base, IAllocator* allocator)
 	{
 		switch (base)
 		{
 		case Base::Dec:
-			return Utf16::Format(L"%hu", value);
+			return Utf16::Format(allocator, L"%hu", value);
 		}
 
-		Utf16 result;
-		result.Reserve(4);
+		Utf16 result(4, allocator);
 		ToHex(result.GetString(), value, base);
 		return result;
 	}
 
-	Utf16 ToUtf16(const uint32_t value, Base base)
+	Utf16 ToUtf16(const uint32_t value, Base base, IAllocator* allocator)
 	{
 		switch (base)
 		{
 		case Base::Dec:
-			return Utf16::Format(L"%u", value);
+			return Utf16::Format(allocator, L"%u", value);
 		}
 
-		Utf16 result;
-		result.Reserve(8);
+		Utf16 result(8, allocator);
 		ToHex(result.GetString(), value, base);
 		return result;
 	}
 
-	Utf16 ToUtf16(const uint64_t value, Base base)
+	Utf16 ToUtf16(const uint64_t value, Base base, IAllocator* allocator)
 	{
 		switch (base)
 		{
 		case Base::Dec:
-			return Utf16::Format(L"%llu", value);
+			return Utf16::Format(allocator, L"%llu", value);
 		}
 
-		Utf16 result;
-		result.Reserve(16);
+		Utf16 result(16, allocator);
 		ToHex(result.GetString(), value, base);
 		return result;
 	}
 
-	Utf16 ToUtf16(const double value)
+	Utf16 ToUtf16(const double value, IAllocator* allocator)
 	{
-		return Utf16::Format(L"%f", value);
+		return Utf16::Format(allocator, L"%f", value);
 	}
 
-	Utf16 ToUtf16(const IBuffer& value, Base base)
+	Utf16 ToUtf16(const IBuffer& value, Base base, IAllocator* allocator)
 	{
 		const auto buffer = value.GetBuffer();
 		const auto size = value.GetSize();
 
-		Utf16 result;
-		result.Reserve(size * 2);
+		Utf16 result(size * 2, allocator);
 		for (size_t i = 0; i < size; i++)
 			ToHex(result + i * 2, buffer[i], base);
 
 		return result;
 	}
 
-	Utf16 ToUtf16(const Uuid& value, Base base)
+	Utf16 ToUtf16(const Uuid& value, Base base, IAllocator* allocator)
 	{
 		switch (base)
 		{
@@ -402,7 +461,7 @@ namespace Neat::Convert
 			throw std::runtime_error("Not implemented");
 		}
 
-		Utf16 result = L"00000000-0000-0000-0000-000000000000";
+		Utf16 result(L"00000000-0000-0000-0000-000000000000", Utf16::End, allocator);
 		auto buffer = result.GetString();
 
 		const auto& data1 = value.GetData1();
@@ -434,25 +493,25 @@ namespace Neat::Convert
 	//
 
 	template <typename T>
-	Buffer ToBufferT(const T* value)
+	Buffer ToBufferT(const T* value, IAllocator* allocator)
 	{
 		const auto size = StringT<T>::GetLength(value) / 2;
 
-		Buffer buffer(size);
+		Buffer buffer(size, allocator);
 		for (size_t i = 0; i < size; i++)
 			buffer[i] = ToByte(value[i * 2], value[i * 2 + 1]);
 
 		return buffer;
 	}
 
-	Buffer ToBuffer(const char* value)
+	Buffer ToBuffer(const char* value, IAllocator* allocator)
 	{
-		return ToBufferT(value);
+		return ToBufferT(value, allocator);
 	}
 
-	Buffer ToBuffer(const wchar_t* value)
+	Buffer ToBuffer(const wchar_t* value, IAllocator* allocator)
 	{
-		return ToBufferT(value);
+		return ToBufferT(value, allocator);
 	}
 
 	//
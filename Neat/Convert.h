@@ -14,58 +14,63 @@ namespace Neat::Convert
 		HexUp
 	};
 
+	//
+	// Results take the given allocator, null means the one of a converted Neat string,
+	// otherwise the one of the current scope or the heap
+	//
+
 	//
 	// ToUtf8
 	//
 
-	Utf8 ToUtf8(const char* value);
-	Utf8 ToUtf8(const wchar_t* value);
-	Utf8 ToUtf8(const Utf8& value);
-	Utf8 ToUtf8(const Utf16& value);
-	Utf8 ToUtf8(const std::string& value);
-	Utf8 ToUtf8(const std::wstring& value);
+	Utf8 ToUtf8(const char* value, IAllocator* allocator = nullptr);
+	Utf8 ToUtf8(const wchar_t* value, IAllocator* allocator = nullptr);
+	Utf8 ToUtf8(const Utf8& value, IAllocator* allocator = nullptr);
+	Utf8 ToUtf8(const Utf16& value, IAllocator* allocator = nullptr);
+	Utf8 ToUtf8(const std::string& value, IAllocator* allocator = nullptr);
+	Utf8 ToUtf8(const std::wstring& value, IAllocator* allocator = nullptr);
 
-	Utf8 ToUtf8(const int32_t value);
-	Utf8 ToUtf8(const int64_t value);
+	Utf8 ToUtf8(const int32_t value, IAllocator* allocator = nullptr);
+	Utf8 ToUtf8(const int64_t value, IAllocator* allocator = nullptr);
 
-	Utf8 ToUtf8(const uint8_t value, Base base = Base::Dec);
-	Utf8 ToUtf8(const uint16_t value, Base base = Base::Dec);
-	Utf8 ToUtf8(const uint32_t value, Base base = Base::Dec);
-	Utf8 ToUtf8(const uint64_t value, Base base = Base::Dec);
+	Utf8 ToUtf8(const uint8_t value, Base base = Base::Dec, IAllocator* allocator = nullptr);
+	Utf8 ToUtf8(const uint16_t value, Base base = Base::Dec, IAllocator* allocator = nullptr);
+	Utf8 ToUtf8(const uint32_t value, Base base = Base::Dec, IAllocator* allocator = nullptr);
+	Utf8 ToUtf8(const uint64_t value, Base base = Base::Dec, IAllocator* allocator = nullptr);
 
-	Utf8 ToUtf8(const double value);
-	Utf8 ToUtf8(const IBuffer& value, Base base = Base::HexUp);
-	Utf8 ToUtf8(const Uuid& value, Base base = Base::HexUp);
+	Utf8 ToUtf8(const double value, IAllocator* allocator = nullptr);
+	Utf8 ToUtf8(const IBuffer& value, Base base = Base::HexUp, IAllocator* allocator = nullptr);
+	Utf8 ToUtf8(const Uuid& value, Base base = Base::HexUp, IAllocator* allocator = nullptr);
 
 	//
 	// ToUtf16
 	//
 
-	Utf16 ToUtf16(const char* value);
-	Utf16 ToUtf16(const wchar_t* value);
-	Utf16 ToUtf16(const Utf8& value);
-	Utf16 ToUtf16(const Utf16& value);
-	Utf16 ToUtf16(const std::string& value);
-	Utf16 ToUtf16(const std::wstring& value);
+	Utf16 ToUtf16(const char* value, IAllocator* allocator = nullptr);
+	Utf16 ToUtf16(const wchar_t* value, IAllocator* allocator = nullptr);
+	Utf16 ToUtf16(const Utf8& value, IAllocator* allocator = nullptr);
+	Utf16 ToUtf16(const Utf16& value, IAllocator* allocator = nullptr);
+	Utf16 ToUtf16(const std::string& value, IAllocator* allocator = nullptr);
+	Utf16 ToUtf16(const std::wstring& value, IAllocator* allocator = nullptr);
 
-	Utf16 ToUtf16(const int32_t value);
-	Utf16 ToUtf16(const int64_t value);
+	Utf16 ToUtf16(const int32_t value, IAllocator* allocator = nullptr);
+	Utf16 ToUtf16(const int64_t value, IAllocator* allocator = nullptr);
 
-	Utf16 ToUtf16(const uint8_t value, Base base = Base::Dec);
-	Utf16 ToUtf16(const uint16_t value, Base base = Base::Dec);
-	Utf16 ToUtf16(const uint32_t value, Base base = Base::Dec);
-	Utf16 ToUtf16(const uint64_t value, Base base = Base::Dec);
+	Utf16 ToUtf16(const uint8_t value, Base base = Base::Dec, IAllocator* allocator = nullptr);
+	Utf16 ToUtf16(const uint16_t value, Base base = Base::Dec, IAllocator* allocator = nullptr);
+	Utf16 ToUtf16(const uint32_t value, Base base = Base::Dec, IAllocator* allocator = nullptr);
+	Utf16 ToUtf16(const uint64_t value, Base base = Base::Dec, IAllocator* allocator = nullptr);
 
-	Utf16 ToUtf16(const double value);
-	Utf16 ToUtf16(const IBuffer& value, Base base = Base::HexUp);
-	Utf16 ToUtf16(const Uuid& value, Base base = Base::HexUp);
+	Utf16 ToUtf16(const double value, IAllocator* allocator = nullptr);
+	Utf16 ToUtf16(const IBuffer& value, Base base = Base::HexUp, IAllocator* allocator = nullptr);
+	Utf16 ToUtf16(const Uuid& value, Base base = Base::HexUp, IAllocator* allocator = nullptr);
 
 	//
 	// ToBuffer
 	//
 
-	Buffer ToBuffer(const char* value);
-	Buffer ToBuffer(const wchar_t* value);
+	Buffer ToBuffer(const char* value, IAllocator* allocator = nullptr);
+	Buffer ToBuffer(const wchar_t* value, IAllocator* allocator = nullptr);
 
 	//
 	// ToUuid
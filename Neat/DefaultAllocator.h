@@ -1,6 +1,8 @@
 #pragma once
 #include "Neat\Allocator.h"
 
+#include <new>
+
 namespace Neat
 {
 	class DefaultAllocator : public IAllocator
@@ -11,6 +13,9 @@ namespace Neat
 		byte_t* Allocate(size_t bytes) override;
 		void Deallocate(byte_t* p, size_t bytes) override;
 		bool Owns(byte_t* p, size_t bytes) override;
+
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
 	};
 
 	inline DefaultAllocator::DefaultAllocator()
@@ -31,4 +36,14 @@ namespace Neat
 	{
 		return true;
 	}
+
+	inline byte_t* DefaultAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		return static_cast<byte_t*>(operator new[](bytes, std::align_val_t(alignment)));
+	}
+
+	inline void DefaultAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		operator delete[](p, bytes, std::align_val_t(alignment));
+	}
 }
@@ -14,6 +14,13 @@ namespace Neat
 		void Deallocate(byte_t* p, size_t bytes) override;
 		bool Owns(byte_t* p, size_t bytes) override;
 
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+		// Block of the primary allocator moves to the fallback one when the primary can't resize it
+		byte_t* Reallocate(byte_t* p, size_t bytes, size_t newBytes) override;
+
 	private:
 		IAllocator* m_primary;
 		IAllocator* m_fallback;
@@ -48,4 +55,42 @@ namespace Neat
 		return m_primary->Owns(p, bytes) ||
 			m_fallback->Owns(p, bytes);
 	}
+
+	inline byte_t* FallbackAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		auto p = m_primary->AllocateAligned(bytes, alignment);
+		if (!p)
+			p = m_fallback->AllocateAligned(bytes, alignment);
+		return p;
+	}
+
+	inline void FallbackAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		if (m_primary->Owns(p, bytes))
+			m_primary->DeallocateAligned(p, bytes, alignment);
+		else
+			m_fallback->DeallocateAligned(p, bytes, alignment);
+	}
+
+	inline bool FallbackAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		if (m_primary->Owns(p, bytes))
+			return m_primary->TryExpand(p, bytes, newBytes);
+		else
+			return m_fallback->TryExpand(p, bytes, newBytes);
+	}
+
+	inline byte_t* FallbackAllocator::Reallocate(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		if (!p)
+			return Allocate(newBytes);
+
+		if (!m_primary->Owns(p, bytes))
+			return m_fallback->Reallocate(p, bytes, newBytes);
+
+		const auto q = m_primary->Reallocate(p, bytes, newBytes);
+		if (q)
+			return q;
+		return IAllocator::Reallocate(p, bytes, newBytes);
+	}
 }
@@ -11,6 +11,12 @@ namespace Neat
 		byte_t* Allocate(size_t bytes) override;
 		void Deallocate(byte_t* p, size_t bytes) override;
 		bool Owns(byte_t* p, size_t bytes) override;
+
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+		byte_t* Reallocate(byte_t* p, size_t bytes, size_t newBytes) override;
 	};
 
 	inline MallocAllocator::MallocAllocator()
@@ -31,4 +37,25 @@ namespace Neat
 	{
 		return true;
 	}
+
+	inline byte_t* MallocAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		return static_cast<byte_t*>(::_aligned_malloc(bytes, alignment));
+	}
+
+	inline void MallocAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		::_aligned_free(p);
+	}
+
+	inline bool MallocAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		// CRT resizes the heap block only when it can do so in place
+		return p && newBytes > 0 && ::_expand(p, newBytes);
+	}
+
+	inline byte_t* MallocAllocator::Reallocate(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		return static_cast<byte_t*>(::realloc(p, (std::max)(newBytes, 1_sz)));
+	}
 }
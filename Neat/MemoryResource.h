@@ -0,0 +1,129 @@
+#pragma once
+#include "Neat\Allocator.h"
+
+#include <memory_resource>
+#include <new>
+
+namespace Neat
+{
+	//
+	// Bridges between IAllocator and std::pmr::memory_resource in both directions,
+	// so std::pmr containers and Neat buffers can draw from the same arena.
+	//
+
+	// IAllocator over memory_resource, failures are reported with nullptr instead of std::bad_alloc
+	class MemoryResourceAllocator : public IAllocator
+	{
+	public:
+		explicit MemoryResourceAllocator(std::pmr::memory_resource* resource = std::pmr::get_default_resource());
+
+		byte_t* Allocate(size_t bytes) override;
+		void Deallocate(byte_t* p, size_t bytes) override;
+		// memory_resource can't tell its blocks, so every block is assumed to be owned
+		bool Owns(byte_t* p, size_t bytes) override;
+
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		std::pmr::memory_resource* GetResource() const;
+
+	private:
+		std::pmr::memory_resource* m_resource;
+	};
+
+	// memory_resource over IAllocator, failures are reported with std::bad_alloc
+	class AllocatorMemoryResource : public std::pmr::memory_resource
+	{
+	public:
+		explicit AllocatorMemoryResource(IAllocator* allocator);
+
+		IAllocator* GetAllocator() const;
+
+	protected:
+		void* do_allocate(size_t bytes, size_t alignment) override;
+		void do_deallocate(void* p, size_t bytes, size_t alignment) override;
+		bool do_is_equal(const std::pmr::memory_resource& other) const noexcept override;
+
+	private:
+		IAllocator* m_allocator;
+	};
+
+	inline MemoryResourceAllocator::MemoryResourceAllocator(std::pmr::memory_resource* resource) :
+		m_resource(resource)
+	{
+	}
+
+	inline byte_t* MemoryResourceAllocator::Allocate(size_t bytes)
+	{
+		return AllocateAligned(bytes, DefaultAlignment);
+	}
+
+	inline void MemoryResourceAllocator::Deallocate(byte_t* p, size_t bytes)
+	{
+		DeallocateAligned(p, bytes, DefaultAlignment);
+	}
+
+	inline bool MemoryResourceAllocator::Owns(byte_t* p, size_t bytes)
+	{
+		return true;
+	}
+
+	inline byte_t* MemoryResourceAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		try
+		{
+			return static_cast<byte_t*>(m_resource->allocate(bytes, alignment));
+		}
+		catch (const std::bad_alloc&)
+		{
+			return nullptr;
+		}
+	}
+
+	inline void MemoryResourceAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		if (p)
+			m_resource->deallocate(p, bytes, alignment);
+	}
+
+	inline std::pmr::memory_resource* MemoryResourceAllocator::GetResource() const
+	{
+		return m_resource;
+	}
+
+	inline AllocatorMemoryResource::AllocatorMemoryResource(IAllocator* allocator) :
+		m_allocator(allocator)
+	{
+	}
+
+	inline IAllocator* AllocatorMemoryResource::GetAllocator() const
+	{
+		return m_allocator;
+	}
+
+	inline void* AllocatorMemoryResource::do_allocate(size_t bytes, size_t alignment)
+	{
+		const auto p = (alignment > IAllocator::DefaultAlignment) ?
+			m_allocator->AllocateAligned(bytes, alignment) :
+			m_allocator->Allocate(bytes);
+		if (!p)
+			throw std::bad_alloc();
+		return p;
+	}
+
+	inline void AllocatorMemoryResource::do_deallocate(void* p, size_t bytes, size_t alignment)
+	{
+		if (alignment > IAllocator::DefaultAlignment)
+			m_allocator->DeallocateAligned(static_cast<byte_t*>(p), bytes, alignment);
+		else
+			m_allocator->Deallocate(static_cast<byte_t*>(p), bytes);
+	}
+
+	inline bool AllocatorMemoryResource::do_is_equal(const std::pmr::memory_resource& other) const noexcept
+	{
+		if (this == &other)
+			return true;
+		const auto resource = dynamic_cast<const AllocatorMemoryResource*>(&other);
+		return resource && resource->m_allocator == m_allocator;
+	}
+}
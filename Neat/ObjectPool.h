@@ -0,0 +1,182 @@
+#pragma once
+#include "Neat\Allocator.h"
+
+#include <new>
+#include <utility>
+#include <vector>
+
+namespace Neat
+{
+	//
+	// Typed pool of equal-sized slots carved from slabs, free slots are threaded
+	// through an intrusive list. Objects are constructed in place by Create and
+	// destroyed by Destroy, so they stay densely packed without per-object heap traffic.
+	//
+
+	template <typename T>
+	class ObjectPool
+	{
+	public:
+		// Slabs hold slabCapacity objects each, they are taken from upstream allocator or from new[] when it's null
+		explicit ObjectPool(size_t slabCapacity = 64, IAllocator* upstream = nullptr);
+		ObjectPool(const ObjectPool& other) = delete;
+		ObjectPool& operator=(const ObjectPool& other) = delete;
+		// Objects must be destroyed before the pool, their slabs are released without calling destructors
+		~ObjectPool();
+
+		// Returns nullptr when upstream allocator is out of memory
+		template <typename... Args>
+		T* Create(Args&&... args);
+		void Destroy(T* p);
+
+		bool Owns(const T* p) const;
+
+		// Returns number of live objects
+		size_t GetSize() const;
+		size_t GetSlabCapacity() const;
+		size_t GetSlabCount() const;
+
+	private:
+		union Slot
+		{
+			Slot* next;
+			alignas(T) byte_t storage[sizeof(T)];
+		};
+
+		static constexpr size_t Alignment = alignof(Slot);
+
+		bool Grow();
+		void FreeSlab(Slot* slab);
+
+	private:
+		IAllocator* m_upstream;
+		size_t m_slabCapacity;
+		Slot* m_free;
+		// Fresh slots of the newest slab are handed out before they're put on the free list
+		Slot* m_next;
+		Slot* m_end;
+		size_t m_size;
+		std::vector<Slot*> m_slabs;
+	};
+
+	template <typename T>
+	ObjectPool<T>::ObjectPool(size_t slabCapacity, IAllocator* upstream) :
+		m_upstream(upstream),
+		m_slabCapacity((std::max)(slabCapacity, 1_sz)),
+		m_free(nullptr),
+		m_next(nullptr),
+		m_end(nullptr),
+		m_size(0)
+	{
+	}
+
+	template <typename T>
+	ObjectPool<T>::~ObjectPool()
+	{
+		for (auto slab : m_slabs)
+			FreeSlab(slab);
+	}
+
+	template <typename T>
+	template <typename... Args>
+	T* ObjectPool<T>::Create(Args&&... args)
+	{
+		auto slot = m_free;
+		if (slot)
+		{
+			m_free = slot->next;
+		}
+		else
+		{
+			if (m_next == m_end && !Grow())
+				return nullptr;
+			slot = m_next++;
+		}
+
+		try
+		{
+			const auto p = new (slot->storage) T(std::forward<Args>(args)...);
+			m_size++;
+			return p;
+		}
+		catch (...)
+		{
+			slot->next = m_free;
+			m_free = slot;
+			throw;
+		}
+	}
+
+	template <typename T>
+	void ObjectPool<T>::Destroy(T* p)
+	{
+		if (!p)
+			return;
+
+		p->~T();
+		const auto slot = reinterpret_cast<Slot*>(p);
+		slot->next = m_free;
+		m_free = slot;
+		m_size--;
+	}
+
+	template <typename T>
+	bool ObjectPool<T>::Owns(const T* p) const
+	{
+		const auto slot = reinterpret_cast<const Slot*>(p);
+		for (auto slab : m_slabs)
+		{
+			if (slot >= slab && slot < slab + m_slabCapacity)
+				return true;
+		}
+		return false;
+	}
+
+	template <typename T>
+	size_t ObjectPool<T>::GetSize() const
+	{
+		return m_size;
+	}
+
+	template <typename T>
+	size_t ObjectPool<T>::GetSlabCapacity() const
+	{
+		return m_slabCapacity;
+	}
+
+	template <typename T>
+	size_t ObjectPool<T>::GetSlabCount() const
+	{
+		return m_slabs.size();
+	}
+
+	template <typename T>
+	bool ObjectPool<T>::Grow()
+	{
+		const auto bytes = sizeof(Slot) * m_slabCapacity;
+		byte_t* p = nullptr;
+		if (Alignment > IAllocator::DefaultAlignment)
+			p = m_upstream ? m_upstream->AllocateAligned(bytes, Alignment) : static_cast<byte_t*>(operator new[](bytes, std::align_val_t(Alignment)));
+		else
+			p = m_upstream ? m_upstream->Allocate(bytes) : new byte_t[bytes];
+		if (!p)
+			return false;
+
+		const auto slab = reinterpret_cast<Slot*>(p);
+		m_slabs.push_back(slab);
+		m_next = slab;
+		m_end = slab + m_slabCapacity;
+		return true;
+	}
+
+	template <typename T>
+	void ObjectPool<T>::FreeSlab(Slot* slab)
+	{
+		const auto p = reinterpret_cast<byte_t*>(slab);
+		const auto bytes = sizeof(Slot) * m_slabCapacity;
+		if (Alignment > IAllocator::DefaultAlignment)
+			m_upstream ? m_upstream->DeallocateAligned(p, bytes, Alignment) : operator delete[](p, std::align_val_t(Alignment));
+		else
+			m_upstream ? m_upstream->Deallocate(p, bytes) : delete[] p;
+	}
+}
@@ -0,0 +1,255 @@
+#pragma once
+#include "Neat\Allocator.h"
+
+#include <algorithm>
+#include <new>
+#include <vector>
+
+namespace Neat
+{
+	//
+	// Carves large slabs into power-of-two size classes and keeps a free list per class.
+	// Requests larger than the biggest class are rejected with nullptr, so the pool
+	// is meant to be used as a primary allocator together with FallbackAllocator.
+	// Slabs are aligned to the biggest class, so every block is aligned to its class size.
+	//
+
+	class PoolAllocator : public IAllocator
+	{
+	public:
+		static constexpr size_t MinBlockSize = 16;
+		static constexpr size_t MaxBlockSize = 4_kB;
+		static constexpr size_t ClassCount = 9; // 16, 32, ..., 4096
+
+		// Slabs are taken from upstream allocator, or from new[] when it's null
+		explicit PoolAllocator(size_t slabSize = 64_kB, IAllocator* upstream = nullptr);
+		PoolAllocator(const PoolAllocator& other) = delete;
+		PoolAllocator& operator=(const PoolAllocator& other) = delete;
+		~PoolAllocator();
+
+		byte_t* Allocate(size_t bytes) override;
+		void Deallocate(byte_t* p, size_t bytes) override;
+		bool Owns(byte_t* p, size_t bytes) override;
+
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+
+		bool AllocateBatch(const size_t* sizes, size_t count, byte_t** blocks) override;
+		void DeallocateBatch(byte_t* const* blocks, const size_t* sizes, size_t count) override;
+
+		// Returns all slabs to upstream allocator
+		void Release();
+
+		size_t GetSlabSize() const;
+		size_t GetSlabCount() const;
+
+		static size_t GetSizeClass(size_t bytes);
+		static size_t GetClassSize(size_t sizeClass);
+
+	private:
+		struct Block
+		{
+			Block* next;
+		};
+
+		struct Slab
+		{
+			byte_t* begin;
+			byte_t* end;
+		};
+
+		struct SizeClass
+		{
+			Block* free;
+			byte_t* next;
+			byte_t* end;
+		};
+
+		bool Refill(size_t sizeClass);
+
+	private:
+		IAllocator* m_upstream;
+		size_t m_slabSize;
+		SizeClass m_classes[ClassCount];
+		std::vector<Slab> m_slabs; // Sorted by address
+	};
+
+	inline PoolAllocator::PoolAllocator(size_t slabSize, IAllocator* upstream) :
+		m_upstream(upstream),
+		m_slabSize(((std::max)(slabSize, MaxBlockSize) + MaxBlockSize - 1) & ~(MaxBlockSize - 1))
+	{
+		memset(m_classes, 0, sizeof(m_classes));
+	}
+
+	inline PoolAllocator::~PoolAllocator()
+	{
+		Release();
+	}
+
+	inline byte_t* PoolAllocator::Allocate(size_t bytes)
+	{
+		if (bytes > MaxBlockSize)
+			return nullptr;
+
+		const auto sizeClass = GetSizeClass(bytes);
+		auto& cls = m_classes[sizeClass];
+		if (cls.free)
+		{
+			const auto block = cls.free;
+			cls.free = block->next;
+			return reinterpret_cast<byte_t*>(block);
+		}
+
+		const auto blockSize = GetClassSize(sizeClass);
+		if (static_cast<size_t>(cls.end - cls.next) < blockSize)
+		{
+			if (!Refill(sizeClass))
+				return nullptr;
+		}
+
+		const auto p = cls.next;
+		cls.next += blockSize;
+		return p;
+	}
+
+	inline void PoolAllocator::Deallocate(byte_t* p, size_t bytes)
+	{
+		if (!p || bytes > MaxBlockSize)
+			return;
+
+		auto& cls = m_classes[GetSizeClass(bytes)];
+		const auto block = reinterpret_cast<Block*>(p);
+		block->next = cls.free;
+		cls.free = block;
+	}
+
+	inline byte_t* PoolAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		if (alignment > MaxBlockSize)
+			return nullptr;
+		return Allocate((std::max)(bytes, alignment));
+	}
+
+	inline void PoolAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		Deallocate(p, (std::max)(bytes, alignment));
+	}
+
+	inline bool PoolAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		// Any size within the block's class fits in place
+		return p && bytes <= MaxBlockSize && newBytes <= MaxBlockSize &&
+			GetSizeClass(bytes) == GetSizeClass(newBytes);
+	}
+
+	inline bool PoolAllocator::AllocateBatch(const size_t* sizes, size_t count, byte_t** blocks)
+	{
+		// Oversized requests fail the whole batch before anything is taken from free lists
+		for (size_t i = 0; i < count; i++)
+		{
+			if (sizes[i] > MaxBlockSize)
+			{
+				memset(blocks, 0, count * sizeof(byte_t*));
+				return false;
+			}
+		}
+
+		for (size_t i = 0; i < count; i++)
+		{
+			blocks[i] = (sizes[i] > 0) ? PoolAllocator::Allocate(sizes[i]) : nullptr;
+			if (!blocks[i] && sizes[i] > 0)
+			{
+				PoolAllocator::DeallocateBatch(blocks, sizes, i);
+				memset(blocks, 0, count * sizeof(byte_t*));
+				return false;
+			}
+		}
+		return true;
+	}
+
+	inline void PoolAllocator::DeallocateBatch(byte_t* const* blocks, const size_t* sizes, size_t count)
+	{
+		for (size_t i = 0; i < count; i++)
+			PoolAllocator::Deallocate(blocks[i], sizes[i]);
+	}
+
+	inline bool PoolAllocator::Owns(byte_t* p, size_t bytes)
+	{
+		if (bytes > MaxBlockSize)
+			return false;
+
+		auto slab = std::upper_bound(m_slabs.begin(), m_slabs.end(), p,
+			[](const byte_t* p, const Slab& slab) { return p < slab.begin; });
+		if (slab == m_slabs.begin())
+			return false;
+
+		--slab;
+		return p >= slab->begin && p + bytes <= slab->end;
+	}
+
+	inline void PoolAllocator::Release()
+	{
+		for (const auto& slab : m_slabs)
+		{
+			if (m_upstream)
+				m_upstream->DeallocateAligned(slab.begin, m_slabSize, MaxBlockSize);
+			else
+				operator delete[](slab.begin, m_slabSize, std::align_val_t(MaxBlockSize));
+		}
+
+		m_slabs.clear();
+		memset(m_classes, 0, sizeof(m_classes));
+	}
+
+	inline size_t PoolAllocator::GetSlabSize() const
+	{
+		return m_slabSize;
+	}
+
+	inline size_t PoolAllocator::GetSlabCount() const
+	{
+		return m_slabs.size();
+	}
+
+	inline size_t PoolAllocator::GetSizeClass(size_t bytes)
+	{
+		size_t sizeClass = 0;
+		size_t size = MinBlockSize;
+		while (size < bytes)
+		{
+			size <<= 1;
+			sizeClass++;
+		}
+		return sizeClass;
+	}
+
+	inline size_t PoolAllocator::GetClassSize(size_t sizeClass)
+	{
+		return MinBlockSize << sizeClass;
+	}
+
+	inline bool PoolAllocator::Refill(size_t sizeClass)
+	{
+		// Slab list grows first, so inserting the slab can't throw and leak it
+		if (m_slabs.size() == m_slabs.capacity())
+			m_slabs.reserve(m_slabs.size() * 2 + 1);
+
+		const auto p = m_upstream ?
+			m_upstream->AllocateAligned(m_slabSize, MaxBlockSize) :
+			static_cast<byte_t*>(operator new[](m_slabSize, std::align_val_t(MaxBlockSize)));
+		if (!p)
+			return false;
+
+		const Slab slab = { p, p + m_slabSize };
+		const auto where = std::upper_bound(m_slabs.begin(), m_slabs.end(), p,
+			[](const byte_t* p, const Slab& slab) { return p < slab.begin; });
+		m_slabs.insert(where, slab);
+
+		auto& cls = m_classes[sizeClass];
+		cls.next = slab.begin;
+		cls.end = slab.end;
+		return true;
+	}
+}
@@ -0,0 +1,99 @@
+#pragma once
+#include "Neat\Allocator.h"
+
+namespace Neat
+{
+	//
+	// Routes requests up to threshold bytes to the small allocator and the rest to the large one.
+	// Block size alone decides the owner, so unlike FallbackAllocator no Owns probe is needed on free.
+	//
+
+	template <size_t threshold>
+	class SegregatorAllocator : public IAllocator
+	{
+	public:
+		static constexpr size_t Threshold = threshold;
+
+		SegregatorAllocator(
+			IAllocator* small,
+			IAllocator* large);
+
+		byte_t* Allocate(size_t bytes) override;
+		void Deallocate(byte_t* p, size_t bytes) override;
+		bool Owns(byte_t* p, size_t bytes) override;
+
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+		byte_t* Reallocate(byte_t* p, size_t bytes, size_t newBytes) override;
+
+	private:
+		IAllocator* Select(size_t bytes) const;
+
+	private:
+		IAllocator* m_small;
+		IAllocator* m_large;
+	};
+
+	template <size_t threshold>
+	SegregatorAllocator<threshold>::SegregatorAllocator(
+		IAllocator* small,
+		IAllocator* large) :
+		m_small(small),
+		m_large(large)
+	{
+	}
+
+	template <size_t threshold>
+	byte_t* SegregatorAllocator<threshold>::Allocate(size_t bytes)
+	{
+		return Select(bytes)->Allocate(bytes);
+	}
+
+	template <size_t threshold>
+	void SegregatorAllocator<threshold>::Deallocate(byte_t* p, size_t bytes)
+	{
+		Select(bytes)->Deallocate(p, bytes);
+	}
+
+	template <size_t threshold>
+	bool SegregatorAllocator<threshold>::Owns(byte_t* p, size_t bytes)
+	{
+		return Select(bytes)->Owns(p, bytes);
+	}
+
+	template <size_t threshold>
+	byte_t* SegregatorAllocator<threshold>::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		return Select(bytes)->AllocateAligned(bytes, alignment);
+	}
+
+	template <size_t threshold>
+	void SegregatorAllocator<threshold>::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		Select(bytes)->DeallocateAligned(p, bytes, alignment);
+	}
+
+	template <size_t threshold>
+	bool SegregatorAllocator<threshold>::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		const auto allocator = Select(bytes);
+		return allocator == Select(newBytes) && allocator->TryExpand(p, bytes, newBytes);
+	}
+
+	template <size_t threshold>
+	byte_t* SegregatorAllocator<threshold>::Reallocate(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		const auto allocator = Select(bytes);
+		if (allocator == Select(newBytes))
+			return allocator->Reallocate(p, bytes, newBytes);
+		return IAllocator::Reallocate(p, bytes, newBytes);
+	}
+
+	template <size_t threshold>
+	IAllocator* SegregatorAllocator<threshold>::Select(size_t bytes) const
+	{
+		return bytes <= threshold ? m_small : m_large;
+	}
+}
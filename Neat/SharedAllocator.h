@@ -0,0 +1,228 @@
+#pragma once
+#include "Neat\Allocator.h"
+
+#include <atomic>
+#include <stdexcept>
+#include <thread>
+
+namespace Neat
+{
+	//
+	// Allocates blocks inside a region shared by processes, e.g. Win::SharedMemory. The region may be
+	// mapped at a different address in every process, so its header holds offsets instead of pointers
+	// and blocks are exchanged between processes by GetOffset and GetPointer.
+	// The header is lock free: blocks are bumped from the region and recycled through free lists
+	// of power-of-two size classes, whose heads are tagged against ABA. Memory is never returned
+	// to the region, so the allocator suits steady traffic of similar sizes, e.g. message payloads.
+	//
+
+	class SharedAllocator : public IAllocator
+	{
+	public:
+		static constexpr size_t Granularity = 16;
+		static constexpr size_t ClassCount = 28; // 16 bytes, 32 bytes, ..., 2 GB
+		// Offsets are 32 bits wide to fit tagged list heads
+		static constexpr size_t MaxRegionSize = UINT32_MAX & ~(Granularity - 1);
+
+		// Formats the region when it's not formatted yet, otherwise attaches to it. The region must be
+		// zero filled before the first attach, as fresh shared memory is.
+		// Throws std::invalid_argument when the region is too small or too big.
+		SharedAllocator(byte_t* region, size_t size);
+		SharedAllocator(const SharedAllocator& other) = delete;
+		SharedAllocator& operator=(const SharedAllocator& other) = delete;
+
+		byte_t* Allocate(size_t bytes) override;
+		void Deallocate(byte_t* p, size_t bytes) override;
+		bool Owns(byte_t* p, size_t bytes) override;
+
+		// Blocks are aligned to Granularity, larger alignment is not supported
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+
+		// Offsets are valid in every process, zero stands for null
+		size_t GetOffset(const byte_t* p) const;
+		byte_t* GetPointer(size_t offset) const;
+
+		// Root is a single offset published to other processes, e.g. of a queue of messages
+		void SetRoot(size_t offset);
+		size_t GetRoot() const;
+
+		size_t GetSize() const;
+		// Returns bytes bumped from the region so far, including blocks in free lists
+		size_t GetReserved() const;
+
+		static size_t GetSizeClass(size_t bytes);
+		static size_t GetClassSize(size_t sizeClass);
+
+	private:
+		struct Header
+		{
+			std::atomic<uint32_t> state;
+			uint32_t size;
+			std::atomic<uint32_t> next;
+			std::atomic<uint32_t> root;
+			// Offset in low half, tag in high half
+			std::atomic<uint64_t> free[ClassCount];
+		};
+
+		static_assert(std::atomic<uint64_t>::is_always_lock_free, "Shared header must be lock free!");
+
+		static constexpr uint32_t Formatting = 1;
+		static constexpr uint32_t Formatted = 0x4E534841; // "NSHA"
+		static constexpr size_t HeaderSize = (sizeof(Header) + 63) & ~63_sz;
+
+		Header* GetHeader() const;
+
+	private:
+		byte_t* m_region;
+	};
+
+	inline SharedAllocator::SharedAllocator(byte_t* region, size_t size) :
+		m_region(region)
+	{
+		if (size < HeaderSize + Granularity || size > MaxRegionSize)
+			throw std::invalid_argument("Shared region size is out of range");
+
+		// The first process formats the header, others wait until it's done
+		const auto header = GetHeader();
+		uint32_t state = 0;
+		if (header->state.compare_exchange_strong(state, Formatting))
+		{
+			header->size = static_cast<uint32_t>(size & ~(Granularity - 1));
+			header->next = static_cast<uint32_t>(HeaderSize);
+			header->root = 0;
+			for (auto& head : header->free)
+				head = 0;
+			header->state.store(Formatted, std::memory_order_release);
+		}
+		else
+		{
+			while (Formatted != header->state.load(std::memory_order_acquire))
+				std::this_thread::yield();
+		}
+	}
+
+	inline byte_t* SharedAllocator::Allocate(size_t bytes)
+	{
+		const auto sizeClass = GetSizeClass(bytes);
+		if (sizeClass >= ClassCount)
+			return nullptr;
+
+		const auto header = GetHeader();
+		auto& free = header->free[sizeClass];
+		auto head = free.load(std::memory_order_acquire);
+		while (0 != static_cast<uint32_t>(head))
+		{
+			// The block may be taken and reused meanwhile, then the tag makes the exchange fail
+			const auto p = m_region + static_cast<uint32_t>(head);
+			const auto next = reinterpret_cast<std::atomic<uint32_t>*>(p)->load(std::memory_order_relaxed);
+			const auto tagged = ((head >> 32) + 1) << 32 | next;
+			if (free.compare_exchange_weak(head, tagged, std::memory_order_acquire))
+				return p;
+		}
+
+		const auto size = GetClassSize(sizeClass);
+		auto next = header->next.load(std::memory_order_relaxed);
+		do
+		{
+			if (size > header->size - next)
+				return nullptr;
+		}
+		while (!header->next.compare_exchange_weak(next, static_cast<uint32_t>(next + size), std::memory_order_relaxed));
+		return m_region + next;
+	}
+
+	inline void SharedAllocator::Deallocate(byte_t* p, size_t bytes)
+	{
+		if (!p)
+			return;
+
+		auto& free = GetHeader()->free[GetSizeClass(bytes)];
+		const auto offset = static_cast<uint32_t>(p - m_region);
+		auto head = free.load(std::memory_order_relaxed);
+		uint64_t tagged;
+		do
+		{
+			reinterpret_cast<std::atomic<uint32_t>*>(p)->store(static_cast<uint32_t>(head), std::memory_order_relaxed);
+			tagged = ((head >> 32) + 1) << 32 | offset;
+		}
+		while (!free.compare_exchange_weak(head, tagged, std::memory_order_release, std::memory_order_relaxed));
+	}
+
+	inline bool SharedAllocator::Owns(byte_t* p, size_t bytes)
+	{
+		return p >= m_region + HeaderSize && p + bytes <= m_region + GetHeader()->size;
+	}
+
+	inline byte_t* SharedAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		if (alignment > Granularity)
+			return nullptr;
+		return Allocate(bytes);
+	}
+
+	inline void SharedAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		Deallocate(p, bytes);
+	}
+
+	inline bool SharedAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		// Any size within the block's class fits in place
+		return p && GetSizeClass(bytes) == GetSizeClass(newBytes);
+	}
+
+	inline size_t SharedAllocator::GetOffset(const byte_t* p) const
+	{
+		return p ? p - m_region : 0;
+	}
+
+	inline byte_t* SharedAllocator::GetPointer(size_t offset) const
+	{
+		return offset ? m_region + offset : nullptr;
+	}
+
+	inline void SharedAllocator::SetRoot(size_t offset)
+	{
+		GetHeader()->root.store(static_cast<uint32_t>(offset), std::memory_order_release);
+	}
+
+	inline size_t SharedAllocator::GetRoot() const
+	{
+		return GetHeader()->root.load(std::memory_order_acquire);
+	}
+
+	inline size_t SharedAllocator::GetSize() const
+	{
+		return GetHeader()->size;
+	}
+
+	inline size_t SharedAllocator::GetReserved() const
+	{
+		return GetHeader()->next.load(std::memory_order_relaxed) - HeaderSize;
+	}
+
+	inline size_t SharedAllocator::GetSizeClass(size_t bytes)
+	{
+		size_t sizeClass = 0;
+		size_t size = Granularity;
+		while (size < bytes && sizeClass < ClassCount)
+		{
+			size <<= 1;
+			sizeClass++;
+		}
+		return sizeClass;
+	}
+
+	inline size_t SharedAllocator::GetClassSize(size_t sizeClass)
+	{
+		return Granularity << sizeClass;
+	}
+
+	inline SharedAllocator::Header* SharedAllocator::GetHeader() const
+	{
+		return reinterpret_cast<Header*>(m_region);
+	}
+}
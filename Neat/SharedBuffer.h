@@ -0,0 +1,263 @@
+#pragma once
+#include "Neat\Types.h"
+#include "Neat\AllocatorPolicy.h"
+#include "Neat\Buffer.h"
+
+#include <atomic>
+#include <stdexcept>
+
+namespace Neat
+{
+	//
+	// Immutable bytes shared by reference counting, so copies and slices cost no allocation.
+	// Slices are views into the same block and keep it alive, the block is freed with its last view.
+	// Counting is atomic, so views of one block may be passed to and released by other threads,
+	// a single SharedBuffer object is no more thread safe than any other object though.
+	// Writable access through IBuffer copies contents shared with other views first and makes
+	// the block private to the view, later copies and slices of it copy the bytes, so writes
+	// through the pointer never reach other views.
+	//
+
+	class SharedBuffer : public IBuffer
+	{
+	public:
+		static const auto End = static_cast<size_t>(-1);
+
+		SharedBuffer();
+		// Copies the bytes into a block allocated by allocator, see RuntimeAllocatorPolicy
+		SharedBuffer(const byte_t* buffer, size_t size, IAllocator* allocator = nullptr);
+		explicit SharedBuffer(const IBuffer& buffer, IAllocator* allocator = nullptr);
+		SharedBuffer(const SharedBuffer& other);
+		SharedBuffer(SharedBuffer&& other);
+		~SharedBuffer();
+
+		SharedBuffer& operator=(const SharedBuffer& other);
+		SharedBuffer& operator=(SharedBuffer&& other);
+
+		// Returns view of length bytes from offset which shares the block of this buffer.
+		// Throws std::out_of_range when the range doesn't fit this buffer.
+		SharedBuffer Slice(size_t offset, size_t length = End) const;
+
+		const byte_t* GetBuffer() const override;
+		// Copies contents shared with other views first, returns nullptr when the copy fails.
+		// Copies and slices of this view allocate and copy their bytes from now on.
+		byte_t* GetBuffer() override;
+
+		// Returns size of this view in bytes
+		size_t GetSize() const override;
+		bool IsEmpty() const override;
+
+		// Returns number of views sharing the block, zero for empty buffers
+		size_t GetUseCount() const;
+		IAllocator* GetAllocator() const;
+
+		void Reset();
+
+	private:
+		struct Block
+		{
+			std::atomic<size_t> references;
+			RuntimeAllocatorPolicy policy;
+			size_t bytes;
+			// Set once a writable pointer was handed out, the block has a single view then
+			bool exclusive;
+		};
+
+		// Keeps the bytes aligned like blocks of the allocator
+		static constexpr size_t HeaderSize = (sizeof(Block) + IAllocator::DefaultAlignment - 1) & ~(IAllocator::DefaultAlignment - 1);
+
+		void Create(const byte_t* buffer, size_t size, IAllocator* allocator);
+		// Shares the block of other, or copies the bytes when it's exclusive
+		void Assign(const SharedBuffer& other, size_t offset, size_t length);
+		void AddReference() const;
+		void Release();
+
+	private:
+		Block* m_block;
+		const byte_t* m_data;
+		size_t m_size;
+	};
+
+	inline SharedBuffer::SharedBuffer() :
+		m_block(nullptr),
+		m_data(nullptr),
+		m_size(0)
+	{
+	}
+
+	inline SharedBuffer::SharedBuffer(const byte_t* buffer, size_t size, IAllocator* allocator) :
+		SharedBuffer()
+	{
+		Create(buffer, size, allocator);
+	}
+
+	inline SharedBuffer::SharedBuffer(const IBuffer& buffer, IAllocator* allocator) :
+		SharedBuffer()
+	{
+		Create(buffer.GetBuffer(), buffer.GetSize(), allocator);
+	}
+
+	inline SharedBuffer::SharedBuffer(const SharedBuffer& other) :
+		SharedBuffer()
+	{
+		Assign(other, 0, other.m_size);
+	}
+
+	inline SharedBuffer::SharedBuffer(SharedBuffer&& other) :
+		m_block(other.m_block),
+		m_data(other.m_data),
+		m_size(other.m_size)
+	{
+		other.m_block = nullptr;
+		other.m_data = nullptr;
+		other.m_size = 0;
+	}
+
+	inline SharedBuffer::~SharedBuffer()
+	{
+		Release();
+	}
+
+	inline SharedBuffer& SharedBuffer::operator=(const SharedBuffer& other)
+	{
+		if (this != &other)
+		{
+			// Other may be a slice of this buffer, so it's taken before this one is released
+			SharedBuffer copy(other);
+			*this = std::move(copy);
+		}
+		return *this;
+	}
+
+	inline SharedBuffer& SharedBuffer::operator=(SharedBuffer&& other)
+	{
+		if (this != &other)
+		{
+			Release();
+			m_block = other.m_block;
+			m_data = other.m_data;
+			m_size = other.m_size;
+			other.m_block = nullptr;
+			other.m_data = nullptr;
+			other.m_size = 0;
+		}
+		return *this;
+	}
+
+	inline SharedBuffer SharedBuffer::Slice(size_t offset, size_t length) const
+	{
+		if (offset > m_size)
+			throw std::out_of_range("offset > m_size");
+		if (End == length)
+			length = m_size - offset;
+		else if (length > m_size - offset)
+			throw std::out_of_range("offset + length > m_size");
+
+		SharedBuffer slice;
+		if (length > 0)
+			slice.Assign(*this, offset, length);
+		return slice;
+	}
+
+	inline const byte_t* SharedBuffer::GetBuffer() const
+	{
+		return m_data;
+	}
+
+	inline byte_t* SharedBuffer::GetBuffer()
+	{
+		if (m_block && m_block->references.load(std::memory_order_acquire) > 1)
+		{
+			SharedBuffer copy;
+			copy.Create(m_data, m_size, m_block->policy.GetAllocator());
+			if (!copy.m_block)
+				return nullptr;
+			*this = std::move(copy);
+		}
+		if (m_block)
+			m_block->exclusive = true;
+		return const_cast<byte_t*>(m_data);
+	}
+
+	inline size_t SharedBuffer::GetSize() const
+	{
+		return m_size;
+	}
+
+	inline bool SharedBuffer::IsEmpty() const
+	{
+		return 0 == m_size;
+	}
+
+	inline size_t SharedBuffer::GetUseCount() const
+	{
+		return m_block ? m_block->references.load(std::memory_order_relaxed) : 0;
+	}
+
+	inline IAllocator* SharedBuffer::GetAllocator() const
+	{
+		return m_block ? m_block->policy.GetAllocator() : nullptr;
+	}
+
+	inline void SharedBuffer::Reset()
+	{
+		Release();
+		m_block = nullptr;
+		m_data = nullptr;
+		m_size = 0;
+	}
+
+	// Leaves the buffer empty when the allocation fails
+	inline void SharedBuffer::Create(const byte_t* buffer, size_t size, IAllocator* allocator)
+	{
+		if (0 == size)
+			return;
+
+		RuntimeAllocatorPolicy policy(allocator);
+		const auto bytes = HeaderSize + size;
+		const auto p = policy.AllocateBlock(bytes, 0);
+		if (!p)
+			return;
+
+		m_block = new (p) Block{ { 1 }, policy, bytes, false };
+		m_data = p + HeaderSize;
+		m_size = size;
+		memcpy(p + HeaderSize, buffer, size);
+	}
+
+	// Expects an empty buffer, leaves it empty when the copy fails
+	inline void SharedBuffer::Assign(const SharedBuffer& other, size_t offset, size_t length)
+	{
+		if (!other.m_block)
+			return;
+
+		if (other.m_block->exclusive)
+		{
+			Create(other.m_data + offset, length, other.m_block->policy.GetAllocator());
+			return;
+		}
+
+		other.AddReference();
+		m_block = other.m_block;
+		m_data = other.m_data + offset;
+		m_size = length;
+	}
+
+	inline void SharedBuffer::AddReference() const
+	{
+		if (m_block)
+			m_block->references.fetch_add(1, std::memory_order_relaxed);
+	}
+
+	inline void SharedBuffer::Release()
+	{
+		// The last owner must see writes of the others before the block is freed
+		if (m_block && 1 == m_block->references.fetch_sub(1, std::memory_order_acq_rel))
+		{
+			auto policy = m_block->policy;
+			const auto bytes = m_block->bytes;
+			m_block->~Block();
+			policy.DeallocateBlock(reinterpret_cast<byte_t*>(m_block), bytes, 0);
+		}
+	}
+}
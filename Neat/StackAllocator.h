@@ -3,6 +3,13 @@
 
 namespace Neat
 {
+	//
+	// Bump allocator over a fixed buffer which grows downwards.
+	// Blocks are aligned to DefaultAlignment at least and their sizes are rounded up to it.
+	// Freeing the most recent block gives its memory back, Rewind drops everything
+	// allocated after the given Mark at once.
+	//
+
 	template <size_t size>
 	class StackAllocator : public IAllocator
 	{
@@ -13,10 +20,23 @@ namespace Neat
 		void Deallocate(byte_t* p, size_t bytes) override;
 		bool Owns(byte_t* p, size_t bytes) override;
 
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		byte_t* Reallocate(byte_t* p, size_t bytes, size_t newBytes) override;
+
 		size_t GetCapacity() const;
 
+		size_t Mark() const;
+		void Rewind(size_t mark);
+
+	private:
+		static size_t RoundUp(size_t bytes);
+		// Returns top moved down by bytes and aligned, null when it doesn't fit
+		byte_t* GetBelowTop(size_t bytes, size_t alignment) const;
+
 	private:
-		byte_t m_buffer[size];
+		alignas(DefaultAlignment) byte_t m_buffer[size];
 		byte_t* m_next;
 	};
 
@@ -30,16 +50,54 @@ namespace Neat
 	template <size_t size>
 	byte_t* StackAllocator<size>::Allocate(size_t bytes)
 	{
-		const auto capacity = GetCapacity();
-		if (bytes > capacity)
-			return nullptr;
-		m_next -= bytes;
-		return m_next;
+		const auto p = GetBelowTop(RoundUp(bytes), DefaultAlignment);
+		if (p)
+			m_next = p;
+		return p;
 	}
 
 	template <size_t size>
 	void StackAllocator<size>::Deallocate(byte_t* p, size_t bytes)
 	{
+		// Rounded size ends at or below the top seen by Allocate
+		if (p == m_next)
+			m_next += RoundUp(bytes);
+	}
+
+	template <size_t size>
+	byte_t* StackAllocator<size>::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		const auto p = GetBelowTop(RoundUp(bytes), (std::max)(alignment, DefaultAlignment));
+		if (p)
+			m_next = p;
+		return p;
+	}
+
+	template <size_t size>
+	void StackAllocator<size>::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		// Alignment padding above the block stays allocated until Rewind
+		Deallocate(p, bytes);
+	}
+
+	template <size_t size>
+	byte_t* StackAllocator<size>::Reallocate(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		if (!p || p != m_next)
+			return IAllocator::Reallocate(p, bytes, newBytes);
+
+		// Stack grows downwards, so the top block is resized by moving its start. Its contents are
+		// copied every time, only no space is needed for a second block. Rounded sizes keep its
+		// start aligned like Allocate does.
+		const auto end = p + RoundUp(bytes);
+		const auto newSize = RoundUp(newBytes);
+		if (newSize > static_cast<size_t>(end - m_buffer))
+			return nullptr;
+		const auto q = end - newSize;
+		if (q != p)
+			memmove(q, p, (std::min)(bytes, newBytes));
+		m_next = q;
+		return q;
 	}
 
 	template <size_t size>
@@ -53,4 +111,35 @@ namespace Neat
 	{
 		return static_cast<size_t>(m_next - m_buffer);
 	}
+
+	template <size_t size>
+	size_t StackAllocator<size>::Mark() const
+	{
+		return GetCapacity();
+	}
+
+	template <size_t size>
+	size_t StackAllocator<size>::RoundUp(size_t bytes)
+	{
+		return ((std::max)(bytes, 1_sz) + DefaultAlignment - 1) & ~(DefaultAlignment - 1);
+	}
+
+	template <size_t size>
+	byte_t* StackAllocator<size>::GetBelowTop(size_t bytes, size_t alignment) const
+	{
+		if (bytes > GetCapacity())
+			return nullptr;
+		const auto p = reinterpret_cast<uintptr_t>(m_next - bytes) & ~(alignment - 1);
+		if (p < reinterpret_cast<uintptr_t>(m_buffer))
+			return nullptr;
+		return reinterpret_cast<byte_t*>(p);
+	}
+
+	template <size_t size>
+	void StackAllocator<size>::Rewind(size_t mark)
+	{
+		// Marks taken before the current top only move it back up
+		if (mark > GetCapacity() && mark <= size)
+			m_next = m_buffer + mark;
+	}
 }
@@ -0,0 +1,257 @@
+#pragma once
+#include "Neat\Allocator.h"
+#include "Neat\ThreadLocal.h"
+
+#include <atomic>
+#include <string>
+
+namespace Neat
+{
+	//
+	// Decorator which records usage statistics of the wrapped allocator.
+	// Counters are kept per thread and only written by their owner thread,
+	// live and peak bytes are shared atomics since peak is a global property.
+	// Wrap the primary of FallbackAllocator to measure its fallback-hit rate:
+	// every failed allocation of the primary is served by the fallback.
+	//
+
+	class StatsAllocator : public IAllocator
+	{
+	public:
+		// Histogram bucket N counts sizes in [2^(N-1), 2^N), the last bucket counts the rest
+		static constexpr size_t BucketCount = 24;
+
+		struct Snapshot
+		{
+			const char* tag;
+			size_t allocations;
+			size_t deallocations;
+			size_t failures;
+			size_t allocatedBytes;
+			size_t deallocatedBytes;
+			size_t liveBytes;
+			size_t peakBytes;
+			size_t histogram[BucketCount];
+
+			// Share of allocations the wrapped allocator couldn't serve
+			double GetFailureRate() const;
+		};
+
+		// Tag attributes usage to a subsystem, the string must outlive the allocator
+		explicit StatsAllocator(IAllocator* allocator, const char* tag = nullptr);
+		StatsAllocator(const StatsAllocator& other) = delete;
+		StatsAllocator& operator=(const StatsAllocator& other) = delete;
+
+		byte_t* Allocate(size_t bytes) override;
+		void Deallocate(byte_t* p, size_t bytes) override;
+		bool Owns(byte_t* p, size_t bytes) override;
+
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+		byte_t* Reallocate(byte_t* p, size_t bytes, size_t newBytes) override;
+
+		const char* GetTag() const;
+		Snapshot GetSnapshot();
+		// Returns human readable multi-line report
+		std::string GetReport();
+
+		static size_t GetBucket(size_t bytes);
+
+	private:
+		struct Counters
+		{
+			std::atomic<size_t> allocations;
+			std::atomic<size_t> deallocations;
+			std::atomic<size_t> failures;
+			std::atomic<size_t> allocatedBytes;
+			std::atomic<size_t> deallocatedBytes;
+			std::atomic<size_t> histogram[BucketCount];
+		};
+
+		void OnAllocate(byte_t* p, size_t bytes);
+		void OnDeallocate(byte_t* p, size_t bytes);
+
+		// Single writer, so there is no need for interlocked increment
+		static void Increment(std::atomic<size_t>& counter, size_t value = 1);
+
+	private:
+		IAllocator* m_allocator;
+		const char* m_tag;
+		std::atomic<size_t> m_liveBytes;
+		std::atomic<size_t> m_peakBytes;
+		ThreadLocal<Counters> m_counters;
+	};
+
+	inline double StatsAllocator::Snapshot::GetFailureRate() const
+	{
+		if (0 == allocations)
+			return 0.0;
+		return static_cast<double>(failures) / static_cast<double>(allocations);
+	}
+
+	inline StatsAllocator::StatsAllocator(IAllocator* allocator, const char* tag) :
+		m_allocator(allocator),
+		m_tag(tag),
+		m_liveBytes(0),
+		m_peakBytes(0)
+	{
+	}
+
+	inline byte_t* StatsAllocator::Allocate(size_t bytes)
+	{
+		const auto p = m_allocator->Allocate(bytes);
+		OnAllocate(p, bytes);
+		return p;
+	}
+
+	inline void StatsAllocator::Deallocate(byte_t* p, size_t bytes)
+	{
+		m_allocator->Deallocate(p, bytes);
+		OnDeallocate(p, bytes);
+	}
+
+	inline bool StatsAllocator::Owns(byte_t* p, size_t bytes)
+	{
+		return m_allocator->Owns(p, bytes);
+	}
+
+	inline byte_t* StatsAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		const auto p = m_allocator->AllocateAligned(bytes, alignment);
+		OnAllocate(p, bytes);
+		return p;
+	}
+
+	inline void StatsAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		m_allocator->DeallocateAligned(p, bytes, alignment);
+		OnDeallocate(p, bytes);
+	}
+
+	// Resizing is recorded as deallocation of the old block and allocation of the new one
+	inline bool StatsAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		if (!m_allocator->TryExpand(p, bytes, newBytes))
+			return false;
+
+		OnDeallocate(p, bytes);
+		OnAllocate(p, newBytes);
+		return true;
+	}
+
+	inline byte_t* StatsAllocator::Reallocate(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		const auto q = m_allocator->Reallocate(p, bytes, newBytes);
+		if (q)
+			OnDeallocate(p, bytes);
+		OnAllocate(q, newBytes);
+		return q;
+	}
+
+	inline const char* StatsAllocator::GetTag() const
+	{
+		return m_tag;
+	}
+
+	inline StatsAllocator::Snapshot StatsAllocator::GetSnapshot()
+	{
+		Snapshot snapshot = {};
+		snapshot.tag = m_tag;
+		m_counters.ForEach([&snapshot](const Counters& counters)
+		{
+			snapshot.allocations += counters.allocations.load(std::memory_order_relaxed);
+			snapshot.deallocations += counters.deallocations.load(std::memory_order_relaxed);
+			snapshot.failures += counters.failures.load(std::memory_order_relaxed);
+			snapshot.allocatedBytes += counters.allocatedBytes.load(std::memory_order_relaxed);
+			snapshot.deallocatedBytes += counters.deallocatedBytes.load(std::memory_order_relaxed);
+			for (size_t i = 0; i < BucketCount; i++)
+				snapshot.histogram[i] += counters.histogram[i].load(std::memory_order_relaxed);
+		});
+		snapshot.liveBytes = m_liveBytes.load(std::memory_order_relaxed);
+		snapshot.peakBytes = m_peakBytes.load(std::memory_order_relaxed);
+		return snapshot;
+	}
+
+	inline std::string StatsAllocator::GetReport()
+	{
+		const auto snapshot = GetSnapshot();
+
+		char line[128];
+		std::string report;
+		sprintf_s(line, "[%s]\n", m_tag ? m_tag : "untagged");
+		report += line;
+		sprintf_s(line, "allocations: %zu (%zu failed, %.2f%%)\n",
+			snapshot.allocations, snapshot.failures, snapshot.GetFailureRate() * 100.0);
+		report += line;
+		sprintf_s(line, "deallocations: %zu\n", snapshot.deallocations);
+		report += line;
+		sprintf_s(line, "live bytes: %zu\n", snapshot.liveBytes);
+		report += line;
+		sprintf_s(line, "peak bytes: %zu\n", snapshot.peakBytes);
+		report += line;
+		sprintf_s(line, "total bytes: %zu\n", snapshot.allocatedBytes);
+		report += line;
+
+		for (size_t i = 0; i < BucketCount; i++)
+		{
+			if (0 == snapshot.histogram[i])
+				continue;
+			const auto from = (0 == i) ? 0_sz : (1_sz << (i - 1));
+			if (i + 1 < BucketCount)
+				sprintf_s(line, "  %zu..%zu: %zu\n", from, (1_sz << i) - 1, snapshot.histogram[i]);
+			else
+				sprintf_s(line, "  %zu..: %zu\n", from, snapshot.histogram[i]);
+			report += line;
+		}
+		return report;
+	}
+
+	inline size_t StatsAllocator::GetBucket(size_t bytes)
+	{
+		size_t bucket = 0;
+		while (bytes > 0 && bucket + 1 < BucketCount)
+		{
+			bytes >>= 1;
+			bucket++;
+		}
+		return bucket;
+	}
+
+	inline void StatsAllocator::OnAllocate(byte_t* p, size_t bytes)
+	{
+		auto& counters = m_counters.Get();
+		Increment(counters.allocations);
+		if (!p)
+		{
+			Increment(counters.failures);
+			return;
+		}
+
+		Increment(counters.allocatedBytes, bytes);
+		Increment(counters.histogram[GetBucket(bytes)]);
+
+		const auto live = m_liveBytes.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+		auto peak = m_peakBytes.load(std::memory_order_relaxed);
+		while (live > peak && !m_peakBytes.compare_exchange_weak(peak, live, std::memory_order_relaxed))
+		{
+		}
+	}
+
+	inline void StatsAllocator::OnDeallocate(byte_t* p, size_t bytes)
+	{
+		if (!p)
+			return;
+
+		auto& counters = m_counters.Get();
+		Increment(counters.deallocations);
+		Increment(counters.deallocatedBytes, bytes);
+		m_liveBytes.fetch_sub(bytes, std::memory_order_relaxed);
+	}
+
+	inline void StatsAllocator::Increment(std::atomic<size_t>& counter, size_t value)
+	{
+		counter.store(counter.load(std::memory_order_relaxed) + value, std::memory_order_relaxed);
+	}
+}
@@ -0,0 +1,282 @@
+#pragma once
+#include "Neat\Allocator.h"
+#include "Neat\PoolAllocator.h"
+#include "Neat\ThreadLocal.h"
+
+#include <mutex>
+
+namespace Neat
+{
+	//
+	// Keeps small per-thread magazines of freed blocks by size class in front of a shared allocator.
+	// Magazines are refilled and drained in batches, so the backing allocator is locked once per batch.
+	// Requests larger than MaxBlockSize and over-aligned requests go to the backing allocator directly.
+	//
+
+	class ThreadCachingAllocator : public IAllocator
+	{
+	public:
+		static constexpr size_t MaxBlockSize = PoolAllocator::MaxBlockSize;
+		static constexpr size_t BatchSize = 32;
+
+		// Backing allocator is only called under the lock, it doesn't need to be thread safe
+		explicit ThreadCachingAllocator(IAllocator* backing);
+		ThreadCachingAllocator(const ThreadCachingAllocator& other) = delete;
+		ThreadCachingAllocator& operator=(const ThreadCachingAllocator& other) = delete;
+		~ThreadCachingAllocator();
+
+		byte_t* Allocate(size_t bytes) override;
+		void Deallocate(byte_t* p, size_t bytes) override;
+		bool Owns(byte_t* p, size_t bytes) override;
+
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+		byte_t* Reallocate(byte_t* p, size_t bytes, size_t newBytes) override;
+
+		// Thread cache is looked up once and backing allocator is locked once per batch
+		bool AllocateBatch(const size_t* sizes, size_t count, byte_t** blocks) override;
+		void DeallocateBatch(byte_t* const* blocks, const size_t* sizes, size_t count) override;
+
+		// Returns blocks cached by the calling thread to backing allocator
+		void Flush();
+
+	private:
+		struct Magazine
+		{
+			size_t count;
+			byte_t* blocks[BatchSize * 2];
+		};
+
+		struct Cache
+		{
+			Magazine magazines[PoolAllocator::ClassCount];
+		};
+
+		bool Refill(Magazine& magazine, size_t sizeClass);
+		void Drain(Magazine& magazine, size_t sizeClass, size_t count);
+
+	private:
+		IAllocator* m_backing;
+		std::mutex m_mutex;
+		// Caches of exited threads are adopted by new threads, so their blocks are not lost
+		ThreadLocal<Cache> m_caches;
+	};
+
+	inline ThreadCachingAllocator::ThreadCachingAllocator(IAllocator* backing) :
+		m_backing(backing)
+	{
+	}
+
+	inline ThreadCachingAllocator::~ThreadCachingAllocator()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_caches.ForEach([this](Cache& cache)
+		{
+			for (size_t sizeClass = 0; sizeClass < PoolAllocator::ClassCount; sizeClass++)
+			{
+				auto& magazine = cache.magazines[sizeClass];
+				Drain(magazine, sizeClass, magazine.count);
+			}
+		});
+	}
+
+	inline byte_t* ThreadCachingAllocator::Allocate(size_t bytes)
+	{
+		if (bytes > MaxBlockSize)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_backing->Allocate(bytes);
+		}
+
+		const auto sizeClass = PoolAllocator::GetSizeClass(bytes);
+		auto& magazine = m_caches.Get().magazines[sizeClass];
+		if (0 == magazine.count)
+		{
+			if (!Refill(magazine, sizeClass))
+				return nullptr;
+		}
+		return magazine.blocks[--magazine.count];
+	}
+
+	inline void ThreadCachingAllocator::Deallocate(byte_t* p, size_t bytes)
+	{
+		if (!p)
+			return;
+
+		if (bytes > MaxBlockSize)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			m_backing->Deallocate(p, bytes);
+			return;
+		}
+
+		const auto sizeClass = PoolAllocator::GetSizeClass(bytes);
+		auto& magazine = m_caches.Get().magazines[sizeClass];
+		if (_countof(magazine.blocks) == magazine.count)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			Drain(magazine, sizeClass, BatchSize);
+		}
+		magazine.blocks[magazine.count++] = p;
+	}
+
+	inline bool ThreadCachingAllocator::Owns(byte_t* p, size_t bytes)
+	{
+		if (bytes <= MaxBlockSize)
+			bytes = PoolAllocator::GetClassSize(PoolAllocator::GetSizeClass(bytes));
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_backing->Owns(p, bytes);
+	}
+
+	inline byte_t* ThreadCachingAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		if (alignment <= DefaultAlignment)
+			return Allocate(bytes);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_backing->AllocateAligned(bytes, alignment);
+	}
+
+	inline void ThreadCachingAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		if (alignment <= DefaultAlignment)
+			return Deallocate(p, bytes);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		m_backing->DeallocateAligned(p, bytes, alignment);
+	}
+
+	inline bool ThreadCachingAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		if (bytes <= MaxBlockSize || newBytes <= MaxBlockSize)
+		{
+			return p && bytes <= MaxBlockSize && newBytes <= MaxBlockSize &&
+				PoolAllocator::GetSizeClass(bytes) == PoolAllocator::GetSizeClass(newBytes);
+		}
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_backing->TryExpand(p, bytes, newBytes);
+	}
+
+	inline byte_t* ThreadCachingAllocator::Reallocate(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		if (p && bytes > MaxBlockSize && newBytes > MaxBlockSize)
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			return m_backing->Reallocate(p, bytes, newBytes);
+		}
+		return IAllocator::Reallocate(p, bytes, newBytes);
+	}
+
+	inline bool ThreadCachingAllocator::AllocateBatch(const size_t* sizes, size_t count, byte_t** blocks)
+	{
+		memset(blocks, 0, count * sizeof(byte_t*));
+		auto failed = false;
+		{
+			std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+			for (size_t i = 0; i < count && !failed; i++)
+			{
+				if (sizes[i] <= MaxBlockSize)
+					continue;
+
+				if (!lock.owns_lock())
+					lock.lock();
+				blocks[i] = m_backing->Allocate(sizes[i]);
+				failed = !blocks[i];
+			}
+		}
+
+		auto& cache = m_caches.Get();
+		for (size_t i = 0; i < count && !failed; i++)
+		{
+			if (0 == sizes[i] || sizes[i] > MaxBlockSize)
+				continue;
+
+			const auto sizeClass = PoolAllocator::GetSizeClass(sizes[i]);
+			auto& magazine = cache.magazines[sizeClass];
+			if (0 == magazine.count && !Refill(magazine, sizeClass))
+			{
+				failed = true;
+				break;
+			}
+			blocks[i] = magazine.blocks[--magazine.count];
+		}
+
+		if (failed)
+		{
+			ThreadCachingAllocator::DeallocateBatch(blocks, sizes, count);
+			memset(blocks, 0, count * sizeof(byte_t*));
+			return false;
+		}
+		return true;
+	}
+
+	inline void ThreadCachingAllocator::DeallocateBatch(byte_t* const* blocks, const size_t* sizes, size_t count)
+	{
+		auto& cache = m_caches.Get();
+		std::unique_lock<std::mutex> lock(m_mutex, std::defer_lock);
+		for (size_t i = 0; i < count; i++)
+		{
+			if (!blocks[i])
+				continue;
+
+			if (sizes[i] > MaxBlockSize)
+			{
+				if (!lock.owns_lock())
+					lock.lock();
+				m_backing->Deallocate(blocks[i], sizes[i]);
+				continue;
+			}
+
+			const auto sizeClass = PoolAllocator::GetSizeClass(sizes[i]);
+			auto& magazine = cache.magazines[sizeClass];
+			if (_countof(magazine.blocks) == magazine.count)
+			{
+				if (!lock.owns_lock())
+					lock.lock();
+				Drain(magazine, sizeClass, BatchSize);
+			}
+			magazine.blocks[magazine.count++] = blocks[i];
+		}
+	}
+
+	inline void ThreadCachingAllocator::Flush()
+	{
+		auto& cache = m_caches.Get();
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (size_t sizeClass = 0; sizeClass < PoolAllocator::ClassCount; sizeClass++)
+		{
+			auto& magazine = cache.magazines[sizeClass];
+			Drain(magazine, sizeClass, magazine.count);
+		}
+	}
+
+	inline bool ThreadCachingAllocator::Refill(Magazine& magazine, size_t sizeClass)
+	{
+		const auto size = PoolAllocator::GetClassSize(sizeClass);
+		std::lock_guard<std::mutex> lock(m_mutex);
+		while (magazine.count < BatchSize)
+		{
+			const auto p = m_backing->Allocate(size);
+			if (!p)
+				break;
+			magazine.blocks[magazine.count++] = p;
+		}
+		return magazine.count > 0;
+	}
+
+	// Must be called under the lock
+	inline void ThreadCachingAllocator::Drain(Magazine& magazine, size_t sizeClass, size_t count)
+	{
+		const auto size = PoolAllocator::GetClassSize(sizeClass);
+		for (size_t i = 0; i < count; i++)
+			m_backing->Deallocate(magazine.blocks[i], size);
+
+		// Recently freed blocks are kept, they are more likely to be in CPU cache
+		magazine.count -= count;
+		memmove(magazine.blocks, magazine.blocks + count, magazine.count * sizeof(byte_t*));
+	}
+}
@@ -0,0 +1,147 @@
+#pragma once
+#include "Neat\Types.h"
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace Neat
+{
+	//
+	// Per-object thread local storage. Every thread gets its own value on first Get,
+	// values of exited threads are kept and handed over to the next new thread.
+	//
+
+	template <typename T>
+	class ThreadLocal
+	{
+	public:
+		ThreadLocal();
+		ThreadLocal(const ThreadLocal& other) = delete;
+		ThreadLocal& operator=(const ThreadLocal& other) = delete;
+
+		// Lock free after the first call on each thread
+		T& Get();
+
+		// Visits values of all threads, which may be in use concurrently
+		template <typename F>
+		void ForEach(F f);
+
+	private:
+		struct Slot
+		{
+			std::atomic<bool> active;
+			T value;
+		};
+
+		struct SlotRef
+		{
+			uint64_t owner;
+			std::shared_ptr<Slot> slot;
+		};
+
+		// Slots of the current thread, they are released on thread exit
+		struct Registry
+		{
+			~Registry();
+
+			std::vector<SlotRef> refs;
+		};
+
+		T& Acquire();
+
+		static Registry& GetRegistry();
+
+	private:
+		uint64_t m_id;
+		std::mutex m_mutex;
+		std::vector<std::shared_ptr<Slot>> m_slots;
+	};
+
+	namespace Details
+	{
+		inline uint64_t GenerateThreadLocalId()
+		{
+			static std::atomic<uint64_t> s_nextId(1);
+			return s_nextId++;
+		}
+	}
+
+	template <typename T>
+	ThreadLocal<T>::ThreadLocal() :
+		m_id(Details::GenerateThreadLocalId())
+	{
+	}
+
+	template <typename T>
+	T& ThreadLocal<T>::Get()
+	{
+		for (const auto& ref : GetRegistry().refs)
+		{
+			if (ref.owner == m_id)
+				return ref.slot->value;
+		}
+		return Acquire();
+	}
+
+	template <typename T>
+	template <typename F>
+	void ThreadLocal<T>::ForEach(F f)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		for (const auto& slot : m_slots)
+			f(slot->value);
+	}
+
+	template <typename T>
+	T& ThreadLocal<T>::Acquire()
+	{
+		auto& registry = GetRegistry();
+
+		// Forget slots of destroyed objects
+		registry.refs.erase(
+			std::remove_if(registry.refs.begin(), registry.refs.end(),
+				[](const SlotRef& ref) { return 1 == ref.slot.use_count(); }),
+			registry.refs.end());
+
+		std::shared_ptr<Slot> slot;
+		{
+			std::lock_guard<std::mutex> lock(m_mutex);
+			for (const auto& candidate : m_slots)
+			{
+				auto active = false;
+				if (candidate->active.compare_exchange_strong(active, true))
+				{
+					slot = candidate;
+					break;
+				}
+			}
+
+			if (!slot)
+			{
+				slot = std::make_shared<Slot>();
+				slot->active = true;
+				m_slots.push_back(slot);
+			}
+		}
+
+		registry.refs.push_back({ m_id, slot });
+		return slot->value;
+	}
+
+	template <typename T>
+	ThreadLocal<T>::Registry::~Registry()
+	{
+		for (const auto& ref : refs)
+			ref.slot->active = false;
+	}
+
+	template <typename T>
+	typename ThreadLocal<T>::Registry& ThreadLocal<T>::GetRegistry()
+	{
+		static thread_local Registry s_registry;
+		return s_registry;
+	}
+}
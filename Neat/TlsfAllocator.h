@@ -0,0 +1,448 @@
+#pragma once
+#include "Neat\Allocator.h"
+
+#include <algorithm>
+#include <cstddef>
+#include <intrin.h>
+#include <new>
+
+namespace Neat
+{
+	//
+	// Two-Level Segregated Fit allocator over a single fixed region.
+	// Free blocks are kept in lists indexed by power-of-two range and its linear subdivision,
+	// non-empty lists are found with bitmap scans, so Allocate and Deallocate run in constant time.
+	// Neighbouring free blocks are merged on deallocation, which bounds fragmentation.
+	// The region never grows, allocation fails with nullptr when it's exhausted,
+	// so the allocator is meant to be the primary of FallbackAllocator in latency-sensitive paths.
+	//
+
+	class TlsfAllocator : public IAllocator
+	{
+	public:
+		// Block sizes are multiples of granularity, which is also the alignment of Allocate
+		static constexpr size_t Granularity = 16;
+		static constexpr size_t SecondLevelBits = 4;
+		static constexpr size_t SecondLevelCount = 1 << SecondLevelBits;
+		static constexpr size_t FirstLevelCount = 24;
+		// Sizes below are served from linear lists of the first level
+		static constexpr size_t SmallBlockSize = SecondLevelCount * Granularity;
+		static constexpr size_t MaxBlockSize = (SmallBlockSize << (FirstLevelCount - 1)) - Granularity;
+
+		// Manages region of the caller, it must outlive the allocator
+		TlsfAllocator(byte_t* region, size_t size);
+		// Region is taken from upstream allocator, or from new[] when it's null.
+		// Win::PageAllocator as upstream maps the region directly from the system.
+		explicit TlsfAllocator(size_t size, IAllocator* upstream = nullptr);
+		TlsfAllocator(const TlsfAllocator& other) = delete;
+		TlsfAllocator& operator=(const TlsfAllocator& other) = delete;
+		~TlsfAllocator();
+
+		byte_t* Allocate(size_t bytes) override;
+		void Deallocate(byte_t* p, size_t bytes) override;
+		bool Owns(byte_t* p, size_t bytes) override;
+
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+
+		// Returns usable bytes of the region
+		size_t GetCapacity() const;
+		// Returns bytes of allocated blocks, including rounding
+		size_t GetUsed() const;
+
+		static void GetIndex(size_t size, size_t& firstLevel, size_t& secondLevel);
+
+	private:
+		struct Block
+		{
+			Block* prev; // Physically previous block, null for the first one
+			size_t size; // Payload size, the lowest bit marks free block
+			// Free list links are kept in the payload of free blocks
+			Block* nextFree;
+			Block* prevFree;
+		};
+
+		static constexpr size_t HeaderSize = Granularity;
+		static constexpr size_t FreeFlag = 1;
+		static constexpr size_t FirstLevelShift = SecondLevelBits + 4; // log2(SmallBlockSize)
+
+		static_assert(2 * sizeof(size_t) <= HeaderSize, "Block header doesn't fit");
+		static_assert(sizeof(Block) <= HeaderSize + Granularity, "Free block doesn't fit");
+		static_assert(Granularity >= DefaultAlignment, "Blocks must have default alignment");
+
+		void Initialize(byte_t* region, size_t size);
+
+		Block* Find(size_t size);
+		void Insert(Block* block);
+		void Remove(Block* block);
+		void Release(Block* block);
+		void Split(Block* block, size_t size);
+		void Merge(Block* block, Block* next);
+
+		static size_t GetSize(const Block* block);
+		static bool IsFree(const Block* block);
+		static byte_t* GetPayload(Block* block);
+		static Block* GetBlock(byte_t* p);
+		static Block* GetNext(Block* block);
+		static size_t AdjustSize(size_t bytes);
+		static size_t FindFirstSet(uint32_t mask);
+		static size_t FindLastSet(size_t value);
+
+	private:
+		IAllocator* m_upstream;
+		byte_t* m_region; // Owned region, null when it belongs to the caller
+		size_t m_regionSize;
+		byte_t* m_begin;
+		byte_t* m_end;
+		size_t m_used;
+		uint32_t m_firstLevel;
+		uint32_t m_secondLevel[FirstLevelCount];
+		Block* m_free[FirstLevelCount][SecondLevelCount];
+	};
+
+	inline TlsfAllocator::TlsfAllocator(byte_t* region, size_t size) :
+		m_upstream(nullptr),
+		m_region(nullptr),
+		m_regionSize(0)
+	{
+		Initialize(region, size);
+	}
+
+	inline TlsfAllocator::TlsfAllocator(size_t size, IAllocator* upstream) :
+		m_upstream(upstream),
+		m_region(nullptr),
+		m_regionSize(size)
+	{
+		m_region = m_upstream ?
+			m_upstream->AllocateAligned(size, Granularity) :
+			static_cast<byte_t*>(operator new[](size, std::align_val_t(Granularity)));
+		Initialize(m_region, m_region ? size : 0);
+	}
+
+	inline TlsfAllocator::~TlsfAllocator()
+	{
+		if (!m_region)
+			return;
+
+		if (m_upstream)
+			m_upstream->DeallocateAligned(m_region, m_regionSize, Granularity);
+		else
+			operator delete[](m_region, m_regionSize, std::align_val_t(Granularity));
+	}
+
+	inline byte_t* TlsfAllocator::Allocate(size_t bytes)
+	{
+		if (bytes > MaxBlockSize)
+			return nullptr;
+
+		const auto size = AdjustSize(bytes);
+		const auto block = Find(size);
+		if (!block)
+			return nullptr;
+
+		Remove(block);
+		block->size &= ~FreeFlag;
+		Split(block, size);
+		m_used += GetSize(block);
+		return GetPayload(block);
+	}
+
+	inline void TlsfAllocator::Deallocate(byte_t* p, size_t bytes)
+	{
+		if (!p)
+			return;
+
+		const auto block = GetBlock(p);
+		m_used -= GetSize(block);
+		Release(block);
+	}
+
+	inline bool TlsfAllocator::Owns(byte_t* p, size_t bytes)
+	{
+		return p >= m_begin && p + bytes <= m_end;
+	}
+
+	inline byte_t* TlsfAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		if (alignment <= Granularity)
+			return Allocate(bytes);
+		if (bytes > MaxBlockSize || alignment > MaxBlockSize)
+			return nullptr;
+
+		// Leading gap must be big enough to become a free block of its own
+		const auto gapMinimum = HeaderSize + Granularity;
+		const auto size = AdjustSize(bytes);
+		auto block = Find(size + alignment + gapMinimum);
+		if (!block)
+			return nullptr;
+
+		Remove(block);
+		block->size &= ~FreeFlag;
+
+		const auto payload = GetPayload(block);
+		auto aligned = reinterpret_cast<byte_t*>((reinterpret_cast<uintptr_t>(payload) + alignment - 1) & ~(alignment - 1));
+		if (aligned != payload && static_cast<size_t>(aligned - payload) < gapMinimum)
+			aligned = reinterpret_cast<byte_t*>((reinterpret_cast<uintptr_t>(payload + gapMinimum) + alignment - 1) & ~(alignment - 1));
+
+		const auto gap = static_cast<size_t>(aligned - payload);
+		if (gap)
+		{
+			const auto rest = GetBlock(aligned);
+			rest->prev = block;
+			rest->size = GetSize(block) - gap;
+			GetNext(rest)->prev = rest;
+			block->size = gap - HeaderSize;
+			Release(block);
+			block = rest;
+		}
+
+		Split(block, size);
+		m_used += GetSize(block);
+		return GetPayload(block);
+	}
+
+	inline void TlsfAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		Deallocate(p, bytes);
+	}
+
+	inline bool TlsfAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		if (!p || newBytes > MaxBlockSize)
+			return false;
+
+		const auto block = GetBlock(p);
+		const auto size = AdjustSize(newBytes);
+		const auto current = GetSize(block);
+		if (size > current)
+		{
+			// Grows into the following free block
+			const auto next = GetNext(block);
+			if (!IsFree(next) || current + HeaderSize + GetSize(next) < size)
+				return false;
+
+			Remove(next);
+			Merge(block, next);
+		}
+
+		m_used -= current;
+		Split(block, size);
+		m_used += GetSize(block);
+		return true;
+	}
+
+	inline size_t TlsfAllocator::GetCapacity() const
+	{
+		return m_end - m_begin;
+	}
+
+	inline size_t TlsfAllocator::GetUsed() const
+	{
+		return m_used;
+	}
+
+	inline void TlsfAllocator::GetIndex(size_t size, size_t& firstLevel, size_t& secondLevel)
+	{
+		if (size < SmallBlockSize)
+		{
+			firstLevel = 0;
+			secondLevel = size / Granularity;
+			return;
+		}
+
+		const auto last = FindLastSet(size);
+		firstLevel = last - FirstLevelShift + 1;
+		secondLevel = (size >> (last - SecondLevelBits)) ^ SecondLevelCount;
+	}
+
+	inline void TlsfAllocator::Initialize(byte_t* region, size_t size)
+	{
+		m_used = 0;
+		m_firstLevel = 0;
+		memset(m_secondLevel, 0, sizeof(m_secondLevel));
+		memset(m_free, 0, sizeof(m_free));
+
+		const auto begin = (reinterpret_cast<uintptr_t>(region) + Granularity - 1) & ~(Granularity - 1);
+		const auto end = (reinterpret_cast<uintptr_t>(region) + size) & ~(Granularity - 1);
+		if (!region || end < begin + 2 * HeaderSize + Granularity)
+		{
+			m_begin = nullptr;
+			m_end = nullptr;
+			return;
+		}
+
+		// Region ends with zero-sized used block, so merging never runs past the end
+		const auto block = reinterpret_cast<Block*>(begin);
+		block->prev = nullptr;
+		block->size = (std::min)(end - begin - 2 * HeaderSize, MaxBlockSize) | FreeFlag;
+
+		const auto sentinel = GetNext(block);
+		sentinel->prev = block;
+		sentinel->size = 0;
+
+		m_begin = GetPayload(block);
+		m_end = reinterpret_cast<byte_t*>(sentinel);
+		Insert(block);
+	}
+
+	// Returns free block of at least the given size, sizes are rounded up to the next list,
+	// so any block of the list fits and no list has to be searched
+	inline TlsfAllocator::Block* TlsfAllocator::Find(size_t size)
+	{
+		if (size > MaxBlockSize)
+			return nullptr;
+		if (size >= SmallBlockSize)
+			size += (1_sz << (FindLastSet(size) - SecondLevelBits)) - 1;
+
+		size_t firstLevel;
+		size_t secondLevel;
+		GetIndex(size, firstLevel, secondLevel);
+		if (firstLevel >= FirstLevelCount)
+			return nullptr;
+
+		auto secondLevelMap = m_secondLevel[firstLevel] & (~0u << secondLevel);
+		if (!secondLevelMap)
+		{
+			const auto firstLevelMap = m_firstLevel & (~0u << (firstLevel + 1));
+			if (!firstLevelMap)
+				return nullptr;
+
+			firstLevel = FindFirstSet(firstLevelMap);
+			secondLevelMap = m_secondLevel[firstLevel];
+		}
+		return m_free[firstLevel][FindFirstSet(secondLevelMap)];
+	}
+
+	inline void TlsfAllocator::Insert(Block* block)
+	{
+		size_t firstLevel;
+		size_t secondLevel;
+		GetIndex(GetSize(block), firstLevel, secondLevel);
+
+		auto& head = m_free[firstLevel][secondLevel];
+		block->nextFree = head;
+		block->prevFree = nullptr;
+		if (head)
+			head->prevFree = block;
+		head = block;
+
+		m_firstLevel |= 1u << firstLevel;
+		m_secondLevel[firstLevel] |= 1u << secondLevel;
+	}
+
+	inline void TlsfAllocator::Remove(Block* block)
+	{
+		size_t firstLevel;
+		size_t secondLevel;
+		GetIndex(GetSize(block), firstLevel, secondLevel);
+
+		if (block->nextFree)
+			block->nextFree->prevFree = block->prevFree;
+		if (block->prevFree)
+			block->prevFree->nextFree = block->nextFree;
+
+		auto& head = m_free[firstLevel][secondLevel];
+		if (head != block)
+			return;
+
+		head = block->nextFree;
+		if (head)
+			return;
+
+		m_secondLevel[firstLevel] &= ~(1u << secondLevel);
+		if (!m_secondLevel[firstLevel])
+			m_firstLevel &= ~(1u << firstLevel);
+	}
+
+	// Marks block as free, merges it with free neighbours and puts it on its list
+	inline void TlsfAllocator::Release(Block* block)
+	{
+		block->size |= FreeFlag;
+
+		const auto prev = block->prev;
+		if (prev && IsFree(prev))
+		{
+			Remove(prev);
+			Merge(prev, block);
+			block = prev;
+		}
+
+		const auto next = GetNext(block);
+		if (IsFree(next))
+		{
+			Remove(next);
+			Merge(block, next);
+		}
+
+		Insert(block);
+	}
+
+	// Cuts used block down to the given size, the tail is released when it can hold a block
+	inline void TlsfAllocator::Split(Block* block, size_t size)
+	{
+		const auto remainder = GetSize(block) - size;
+		if (remainder < HeaderSize + Granularity)
+			return;
+
+		const auto rest = reinterpret_cast<Block*>(GetPayload(block) + size);
+		rest->prev = block;
+		rest->size = remainder - HeaderSize;
+		GetNext(rest)->prev = rest;
+		block->size = size;
+		Release(rest);
+	}
+
+	// Appends the following block to the given one, the flag of the given block is kept
+	inline void TlsfAllocator::Merge(Block* block, Block* next)
+	{
+		block->size += HeaderSize + GetSize(next);
+		GetNext(block)->prev = block;
+	}
+
+	inline size_t TlsfAllocator::GetSize(const Block* block)
+	{
+		return block->size & ~FreeFlag;
+	}
+
+	inline bool TlsfAllocator::IsFree(const Block* block)
+	{
+		return 0 != (block->size & FreeFlag);
+	}
+
+	inline byte_t* TlsfAllocator::GetPayload(Block* block)
+	{
+		return reinterpret_cast<byte_t*>(block) + HeaderSize;
+	}
+
+	inline TlsfAllocator::Block* TlsfAllocator::GetBlock(byte_t* p)
+	{
+		return reinterpret_cast<Block*>(p - HeaderSize);
+	}
+
+	inline TlsfAllocator::Block* TlsfAllocator::GetNext(Block* block)
+	{
+		return reinterpret_cast<Block*>(GetPayload(block) + GetSize(block));
+	}
+
+	inline size_t TlsfAllocator::AdjustSize(size_t bytes)
+	{
+		return (std::max)((bytes + Granularity - 1) & ~(Granularity - 1), Granularity);
+	}
+
+	inline size_t TlsfAllocator::FindFirstSet(uint32_t mask)
+	{
+		unsigned long index;
+		_BitScanForward(&index, mask);
+		return index;
+	}
+
+	// Values are bounded by MaxBlockSize, so they fit 32 bits
+	inline size_t TlsfAllocator::FindLastSet(size_t value)
+	{
+		unsigned long index;
+		_BitScanReverse(&index, static_cast<unsigned long>(value));
+		return index;
+	}
+}
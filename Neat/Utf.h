@@ -3,7 +3,9 @@
 #include "Neat\Buffer.h"
 
 #include <exception>
+#include <new>
 #include <type_traits>
+#include <utility>
 #include <vector>
 
 namespace Neat
@@ -66,24 +68,28 @@ namespace Neat
 	typedef CharTraits<wchar_t> Utf16Traits;
 
 	//
+	// Strings made from a string, e.g. its copies, substrings, case conversions and split tokens,
+	// take its allocator unless another one is passed. Copy assignment keeps the allocator of the target,
+	// moves and swaps carry the allocator along with the buffer.
 	// TODO: Consider doing strings immutable (thread safe) and sharing ref-counted buffer.
 	// TODO: Consider implementing short string optimization.
 	//
 
-	template <typename T, typename Traits = CharTraits<T>>
-	class StringT : protected BufferT<T>
+	template <typename T, typename Traits = CharTraits<T>, typename Policy = RuntimeAllocatorPolicy>
+	class StringT : protected BufferT<T, Policy>
 	{
-		typedef BufferT<T> Base;
+		typedef BufferT<T, Policy> Base;
 
 	public:
 		static const auto End = static_cast<size_t>(-1);
 
-		explicit StringT(IAllocator* allocator = nullptr);
+		explicit StringT(const Policy& allocator = Policy());
 		// Accepts length in code units
-		explicit StringT(size_t length, IAllocator* allocator = nullptr);
+		explicit StringT(size_t length, const Policy& allocator = Policy());
 		// Accepts length in code units
-		StringT(const T* string, size_t length = End, IAllocator* allocator = nullptr);
+		StringT(const T* string, size_t length = End, const Policy& allocator = Policy());
 		StringT(const StringT& other);
+		StringT(const StringT& other, const Policy& allocator);
 		StringT(StringT&& other);
 
 		Base::operator const T*;
@@ -142,7 +148,9 @@ namespace Neat
 		void ToUpper();
 
 		StringT ToLower() const;
+		StringT ToLower(const Policy& allocator) const;
 		StringT ToUpper() const;
+		StringT ToUpper(const Policy& allocator) const;
 
 		bool BeginsWith(const T what) const;
 		bool BeginsWith(const T* what) const;
@@ -153,9 +161,11 @@ namespace Neat
 		bool Match(const T* wildcard) const;
 
 		StringT Substring(size_t from, size_t length = End) const;
+		StringT Substring(size_t from, size_t length, const Policy& allocator) const;
 
 		size_t Split(const T* by, StringT& token, size_t& from) const;
 		std::vector<StringT> Split(const T* by) const;
+		std::vector<StringT> Split(const T* by, const Policy& allocator) const;
 
 		void Trim(const T* what);
 		void TrimLeft(const T* what);
@@ -165,10 +175,19 @@ namespace Neat
 		static StringT CopyBefore(
 			const T* string,
 			const T separator,
-			IAllocator* allocator = nullptr);
+			const Policy& allocator = Policy());
+		// Copies strings with one batch call to the allocator, lengths are in code units and may be
+		// null for terminated strings. Null strings give empty ones. Throws std::bad_alloc on failure.
+		static std::vector<StringT> CopyBatch(
+			const T* const* strings,
+			const size_t* lengths,
+			size_t count,
+			const Policy& allocator = Policy());
 
 		template <typename... Ts>
 		static StringT Format(const T* format, const Ts&... ts);
+		template <typename... Ts>
+		static StringT Format(const Policy& allocator, const T* format, const Ts&... ts);
 
 	protected:
 		void CopyFrom(const StringT& other);
@@ -178,29 +197,43 @@ namespace Neat
 		void DoReplace(size_t from, size_t whatLength, const T* with, size_t withLength);
 
 	private:
+		// Batches up to this count keep their bookkeeping on the stack
+		static constexpr size_t SmallBatch = 8;
+
+		// Counts the tokens of split, and stores them too when the arrays aren't null
+		size_t FindTokens(const T* by, const T** tokens, size_t* lengths) const;
+		// Fills result, which has room for count strings, sizes and blocks are scratch of count
+		// entries. Returns false when the policy can't allocate the batch.
+		static bool DoCopyBatch(
+			const T* const* strings,
+			const size_t* lengths,
+			size_t count,
+			Policy& policy,
+			size_t* sizes,
+			byte_t** blocks,
+			std::vector<StringT>& result);
+
 		friend void swap(StringT& left, StringT& right)
 		{
-			using std::swap;
-			swap(left.m_buffer, right.m_buffer);
-			swap(left.m_size, right.m_size);
+			swap(static_cast<Base&>(left), static_cast<Base&>(right));
 		}
 	};
 
-	template <typename T, typename Traits>
-	StringT<T, Traits>::StringT(IAllocator* allocator) :
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy>::StringT(const Policy& allocator) :
 		Base(allocator)
 	{
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits>::StringT(size_t length, IAllocator* allocator) :
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy>::StringT(size_t length, const Policy& allocator) :
 		Base(allocator)
 	{
 		DoReserve(length);
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits>::StringT(const T* string, size_t length, IAllocator* allocator) :
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy>::StringT(const T* string, size_t length, const Policy& allocator) :
 		Base(allocator)
 	{
 		if (string != nullptr)
@@ -211,69 +244,82 @@ namespace Neat
 		}
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits>::StringT(const StringT& other)
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy>::StringT(const StringT& other) :
+		Base(other)
 	{
-		CopyFrom(other);
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits>::StringT(StringT&& other)
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy>::StringT(const StringT& other, const Policy& allocator) :
+		Base(other, allocator)
 	{
-		MoveFrom(other);
 	}
 
-	template <typename T, typename Traits>
-	const T* StringT<T, Traits>::GetString() const
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy>::StringT(StringT&& other) :
+		Base(std::move(other))
+	{
+	}
+
+	template <typename T, typename Traits, typename Policy>
+	const T* StringT<T, Traits, Policy>::GetString() const
 	{
 		return m_buffer;
 	}
 
-	template <typename T, typename Traits>
-	T* StringT<T, Traits>::GetString()
+	template <typename T, typename Traits, typename Policy>
+	T* StringT<T, Traits, Policy>::GetString()
 	{
 		return m_buffer;
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::IsEmpty() const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::IsEmpty() const
 	{
 		return 0 == GetLength();
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::IsEqual(const T* string) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::IsEqual(const T* string) const
 	{
 		return *this == string;
 	}
 
-	template <typename T, typename Traits>
-	size_t StringT<T, Traits>::GetLength() const
+	template <typename T, typename Traits, typename Policy>
+	size_t StringT<T, Traits, Policy>::GetLength() const
 	{
 		return Traits::GetLength(m_buffer);
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::Reserve(size_t length)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::Reserve(size_t length)
 	{
 		const auto required = (length + 1) * sizeof(T);
 		if (required > m_size)
 		{
-			StringT other(length, m_allocator);
+			const auto size = m_size;
+			if (DoReallocate(required))
+			{
+				memset(reinterpret_cast<byte_t*>(m_buffer) + size, 0, m_size - size);
+				return;
+			}
+
+			StringT other(length, GetPolicy());
 			swap(*this, other);
 			if (other.m_size > 0)
 				Traits::Copy(m_buffer, m_size / sizeof(T), other.m_buffer);
 		}
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::Clear()
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::Clear()
 	{
 		Free();
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits>& StringT<T, Traits>::operator=(const T* string)
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy>& StringT<T, Traits, Policy>::operator=(const T* string)
 	{
 		const auto length = Traits::GetLength(string);
 		Reserve(length);
@@ -281,8 +327,8 @@ namespace Neat
 		return *this;
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits>& StringT<T, Traits>::operator=(const StringT& other)
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy>& StringT<T, Traits, Policy>::operator=(const StringT& other)
 	{
 		if (this != &other)
 		{
@@ -292,8 +338,8 @@ namespace Neat
 		return *this;
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits>& StringT<T, Traits>::operator=(StringT&& other)
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy>& StringT<T, Traits, Policy>::operator=(StringT&& other)
 	{
 		if (this != &other)
 		{
@@ -303,30 +349,30 @@ namespace Neat
 		return *this;
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits>& StringT<T, Traits>::operator+=(const T* string)
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy>& StringT<T, Traits, Policy>::operator+=(const T* string)
 	{
 		Append(string);
 		return *this;
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits>& StringT<T, Traits>::operator+=(const T t)
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy>& StringT<T, Traits, Policy>::operator+=(const T t)
 	{
 		Append(t);
 		return *this;
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits> StringT<T, Traits>::operator+(const T* string) const
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy> StringT<T, Traits, Policy>::operator+(const T* string) const
 	{
 		StringT result(*this);
 		result.Append(string);
 		return result;
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::operator==(const T* string) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::operator==(const T* string) const
 	{
 		if (nullptr == m_buffer)
 		{
@@ -342,26 +388,26 @@ namespace Neat
 		}
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::operator==(const StringT& other) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::operator==(const StringT& other) const
 	{
 		return operator==(other.operator const T*());
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::operator!=(const T* string) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::operator!=(const T* string) const
 	{
 		return !operator==(string);
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::operator!=(const StringT& other) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::operator!=(const StringT& other) const
 	{
 		return operator!=(other.operator const T*());
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::operator<(const StringT& other) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::operator<(const StringT& other) const
 	{
 		if (nullptr == m_buffer)
 		{
@@ -377,26 +423,28 @@ namespace Neat
 		}
 	}
 	
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::Attach(const T* string)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::Attach(const T* string)
 	{
 		Free();
 		const auto length = Traits::GetLength(string);
 		m_buffer = string;
 		m_size = (length + 1) * sizeof(T);
+		m_capacity = m_size;
 	}
 
-	template <typename T, typename Traits>
-	T* StringT<T, Traits>::Detach()
+	template <typename T, typename Traits, typename Policy>
+	T* StringT<T, Traits, Policy>::Detach()
 	{
 		const auto string = m_buffer;
 		m_buffer = nullptr;
 		m_size = 0;
+		m_capacity = 0;
 		return string;
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::Append(const T* string, size_t length)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::Append(const T* string, size_t length)
 	{
 		const auto addLength = (length != End) ? length : Traits::GetLength(string);
 		if (0 == addLength)
@@ -411,8 +459,8 @@ namespace Neat
 		Traits::Copy(buffer, capacity, string, addLength);
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::Append(const T t)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::Append(const T t)
 	{
 		const auto length = Traits::GetLength(m_buffer);
 		Reserve(length + 1);
@@ -422,8 +470,8 @@ namespace Neat
 		Traits::Copy(buffer, capacity, &t, 1);
 	}
 
-	template <typename T, typename Traits>
-	size_t StringT<T, Traits>::Find(const T what, size_t from) const
+	template <typename T, typename Traits, typename Policy>
+	size_t StringT<T, Traits, Policy>::Find(const T what, size_t from) const
 	{
 		if (nullptr == m_buffer)
 			return End;
@@ -438,8 +486,8 @@ namespace Neat
 		return where - m_buffer;
 	}
 
-	template <typename T, typename Traits>
-	size_t StringT<T, Traits>::Find(const T* what, size_t from) const
+	template <typename T, typename Traits, typename Policy>
+	size_t StringT<T, Traits, Policy>::Find(const T* what, size_t from) const
 	{
 		if (nullptr == m_buffer)
 		{
@@ -468,8 +516,8 @@ namespace Neat
 		return where - m_buffer;
 	}
 
-	template <typename T, typename Traits>
-	size_t StringT<T, Traits>::FindLast(const T what) const
+	template <typename T, typename Traits, typename Policy>
+	size_t StringT<T, Traits, Policy>::FindLast(const T what) const
 	{
 		if (nullptr == m_buffer)
 			return End;
@@ -481,8 +529,8 @@ namespace Neat
 		return where - m_buffer;
 	}
 
-	template <typename T, typename Traits>
-	size_t StringT<T, Traits>::FindLast(const T* what) const
+	template <typename T, typename Traits, typename Policy>
+	size_t StringT<T, Traits, Policy>::FindLast(const T* what) const
 	{
 		if (nullptr == m_buffer)
 		{
@@ -508,8 +556,8 @@ namespace Neat
 		return where - m_buffer;
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::Replace(const T* what, const T* with)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::Replace(const T* what, const T* with)
 	{
 		if (!what || !with)
 			return;
@@ -528,8 +576,8 @@ namespace Neat
 		}
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::Replace(size_t from, const T* with)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::Replace(size_t from, const T* with)
 	{
 		const auto thisLength = Traits::GetLength(m_buffer);
 		if (from > thisLength)
@@ -539,8 +587,8 @@ namespace Neat
 		DoReplace(from, whatLength, with, withLength);
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::Replace(size_t from, size_t to, const T* with)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::Replace(size_t from, size_t to, const T* with)
 	{
 		if (from >= m_size)
 			throw std::out_of_range("from >= m_size");
@@ -553,38 +601,54 @@ namespace Neat
 		DoReplace(from, whatLength, with, withLength);
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::ToLower()
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::ToLower()
 	{
 		if (m_size > 0)
 			Traits::ToLower(m_buffer, m_size);
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::ToUpper()
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::ToUpper()
 	{
 		if (m_size > 0)
 			Traits::ToUpper(m_buffer, m_size);
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits> StringT<T, Traits>::ToLower() const
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy> StringT<T, Traits, Policy>::ToLower() const
 	{
 		StringT copy(*this);
 		copy.ToLower();
 		return copy;
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits> StringT<T, Traits>::ToUpper() const
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy> StringT<T, Traits, Policy>::ToLower(const Policy& allocator) const
+	{
+		StringT copy(*this, allocator);
+		copy.ToLower();
+		return copy;
+	}
+
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy> StringT<T, Traits, Policy>::ToUpper() const
 	{
 		StringT copy(*this);
 		copy.ToUpper();
 		return copy;
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::BeginsWith(const T what) const
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy> StringT<T, Traits, Policy>::ToUpper(const Policy& allocator) const
+	{
+		StringT copy(*this, allocator);
+		copy.ToUpper();
+		return copy;
+	}
+
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::BeginsWith(const T what) const
 	{
 		if (nullptr == m_buffer)
 			return false;
@@ -592,8 +656,8 @@ namespace Neat
 		return m_buffer[0] == what;
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::BeginsWith(const T* what) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::BeginsWith(const T* what) const
 	{
 		if (nullptr == what)
 		{
@@ -611,8 +675,8 @@ namespace Neat
 		return 0 == Traits::Compare(m_buffer, what, whatLength);
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::EndsWith(const T what) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::EndsWith(const T what) const
 	{
 		if (nullptr == m_buffer)
 			return false;
@@ -624,8 +688,8 @@ namespace Neat
 		return m_buffer[thisLength - 1] == what;
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::EndsWith(const T* what) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::EndsWith(const T* what) const
 	{
 		if (nullptr == what)
 		{
@@ -648,20 +712,20 @@ namespace Neat
 		return 0 == Traits::Compare(m_buffer + pos, what);
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::Contains(const T what) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::Contains(const T what) const
 	{
 		return End != Find(what);
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::Contains(const T* what) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::Contains(const T* what) const
 	{
 		return End != Find(what);
 	}
 
-	template <typename T, typename Traits>
-	bool StringT<T, Traits>::Match(const T* wild) const
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::Match(const T* wild) const
 	{
 		auto equal = [](const T* wild, const T* string)
 		{
@@ -727,8 +791,14 @@ namespace Neat
 		return true;
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits> StringT<T, Traits>::Substring(size_t from, size_t length) const
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy> StringT<T, Traits, Policy>::Substring(size_t from, size_t length) const
+	{
+		return Substring(from, length, Policy::SelectForCopy());
+	}
+
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy> StringT<T, Traits, Policy>::Substring(size_t from, size_t length, const Policy& allocator) const
 	{
 		const auto capacity = (m_size > 0) ? m_size / sizeof(T) - 1 : 0;
 		if (from > capacity)
@@ -736,11 +806,11 @@ namespace Neat
 		length = (length != End) ? length : Traits::GetLength(m_buffer + from);
 		if (from + length > capacity)
 			length = capacity - from;
-		return StringT(m_buffer + from, length);
+		return StringT(m_buffer + from, length, allocator);
 	}
 
-	template <typename T, typename Traits>
-	size_t StringT<T, Traits>::Split(const T* by, StringT& token, size_t& from) const
+	template <typename T, typename Traits, typename Policy>
+	size_t StringT<T, Traits, Policy>::Split(const T* by, StringT& token, size_t& from) const
 	{
 		const auto capacity = (m_size > 0) ? m_size / sizeof(T) - 1 : 0;
 		if (from >= capacity)
@@ -761,32 +831,90 @@ namespace Neat
 		}
 	}
 
-	template <typename T, typename Traits>
-	std::vector<StringT<T, Traits>> StringT<T, Traits>::Split(const T* by) const
+	template <typename T, typename Traits, typename Policy>
+	std::vector<StringT<T, Traits, Policy>> StringT<T, Traits, Policy>::Split(const T* by) const
+	{
+		return Split(by, Policy::SelectForCopy());
+	}
+
+	template <typename T, typename Traits, typename Policy>
+	std::vector<StringT<T, Traits, Policy>> StringT<T, Traits, Policy>::Split(const T* by, const Policy& allocator) const
+	{
+		// Tokens are located first, so they are copied with a single batch allocation
+		const auto count = FindTokens(by, nullptr, nullptr);
+		std::vector<StringT> result;
+		result.reserve(count);
+
+		// Tokens and the bookkeeping of the batch share one scratch block, small splits keep them
+		// on the stack
+		const T* smallTokens[SmallBatch];
+		size_t smallLengths[SmallBatch];
+		size_t smallSizes[SmallBatch];
+		byte_t* smallBlocks[SmallBatch];
+		Policy policy(allocator);
+		const auto scratchSize = count * (sizeof(const T*) + sizeof(size_t) * 2 + sizeof(byte_t*));
+		const auto scratch = (count > SmallBatch) ? policy.AllocateBlock(scratchSize, 0) : nullptr;
+		if (count > SmallBatch && nullptr == scratch)
+			throw std::bad_alloc();
+
+		const auto tokens = scratch ? reinterpret_cast<const T**>(scratch) : smallTokens;
+		const auto lengths = scratch ? reinterpret_cast<size_t*>(tokens + count) : smallLengths;
+		const auto sizes = scratch ? lengths + count : smallSizes;
+		const auto blocks = scratch ? reinterpret_cast<byte_t**>(sizes + count) : smallBlocks;
+		FindTokens(by, tokens, lengths);
+		const auto copied = DoCopyBatch(tokens, lengths, count, policy, sizes, blocks, result);
+		if (scratch)
+			policy.DeallocateBlock(scratch, scratchSize, 0);
+		if (!copied)
+			throw std::bad_alloc();
+		return result;
+	}
+
+	template <typename T, typename Traits, typename Policy>
+	size_t StringT<T, Traits, Policy>::FindTokens(const T* by, const T** tokens, size_t* lengths) const
 	{
-		std::vector<StringT> tokenList;
-		StringT token;
+		const auto capacity = (m_size > 0) ? m_size / sizeof(T) - 1 : 0;
+		const auto byLength = Traits::GetLength(by);
+		size_t count = 0;
 		size_t from = 0;
-
-		auto pos = Split(by, token, from);
-		while (-1 != pos)
+		while (from < capacity)
 		{
-			if (!token.IsEmpty())
-				tokenList.push_back(token);
-			pos = Split(by, token, from);
+			const auto begin = from;
+			size_t length = 0;
+			const auto pos = Find(by, from);
+			if (End != pos)
+			{
+				length = pos - from;
+				from += length + byLength;
+			}
+			else
+			{
+				length = (std::min)(Traits::GetLength(m_buffer + from), capacity - from);
+				from = capacity;
+			}
+
+			if (length > 0)
+			{
+				if (tokens)
+				{
+					tokens[count] = m_buffer + begin;
+					lengths[count] = length;
+				}
+				count++;
+			}
 		}
-		return tokenList;
+		return count;
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::Trim(const T* what)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::Trim(const T* what)
 	{
 		TrimLeft(what);
 		TrimRight(what);
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::TrimLeft(const T* what)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::TrimLeft(const T* what)
 	{
 		if (0 == m_size)
 			return;
@@ -805,12 +933,12 @@ namespace Neat
 		if (0 == i)
 			return;
 
-		StringT other(m_buffer + i, length - i, m_allocator);
+		StringT other(m_buffer + i, length - i, GetPolicy());
 		swap(*this, other);
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::TrimRight(const T* what)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::TrimRight(const T* what)
 	{
 		if (0 == m_size)
 			return;
@@ -829,20 +957,20 @@ namespace Neat
 		*++ptr = 0;
 	}
 
-	template <typename T, typename Traits>
-	size_t StringT<T, Traits>::GetLength(const T* string)
+	template <typename T, typename Traits, typename Policy>
+	size_t StringT<T, Traits, Policy>::GetLength(const T* string)
 	{
 		return Traits::GetLength(string);
 	}
 
-	template <typename T, typename Traits>
-	StringT<T, Traits> StringT<T, Traits>::CopyBefore(
+	template <typename T, typename Traits, typename Policy>
+	StringT<T, Traits, Policy> StringT<T, Traits, Policy>::CopyBefore(
 		const T* string,
 		const T separator,
-		IAllocator* allocator)
+		const Policy& allocator)
 	{
 		if (nullptr == string)
-			return StringT();
+			return StringT(allocator);
 
 		const auto pos = Traits::Find(string, separator);
 		if (nullptr == pos)
@@ -852,45 +980,116 @@ namespace Neat
 		return StringT(string, length, allocator);
 	}
 
-	template <typename T, typename Traits>
+	template <typename T, typename Traits, typename Policy>
+	std::vector<StringT<T, Traits, Policy>> StringT<T, Traits, Policy>::CopyBatch(
+		const T* const* strings,
+		const size_t* lengths,
+		size_t count,
+		const Policy& allocator)
+	{
+		std::vector<StringT> result;
+		result.reserve(count);
+
+		// Sizes and blocks share one scratch block, small batches keep them on the stack
+		size_t smallSizes[SmallBatch];
+		byte_t* smallBlocks[SmallBatch];
+		Policy policy(allocator);
+		const auto scratchSize = count * (sizeof(size_t) + sizeof(byte_t*));
+		const auto scratch = (count > SmallBatch) ? policy.AllocateBlock(scratchSize, 0) : nullptr;
+		if (count > SmallBatch && nullptr == scratch)
+			throw std::bad_alloc();
+
+		const auto sizes = scratch ? reinterpret_cast<size_t*>(scratch) : smallSizes;
+		const auto blocks = scratch ? reinterpret_cast<byte_t**>(sizes + count) : smallBlocks;
+		const auto copied = DoCopyBatch(strings, lengths, count, policy, sizes, blocks, result);
+		if (scratch)
+			policy.DeallocateBlock(scratch, scratchSize, 0);
+		if (!copied)
+			throw std::bad_alloc();
+		return result;
+	}
+
+	template <typename T, typename Traits, typename Policy>
+	bool StringT<T, Traits, Policy>::DoCopyBatch(
+		const T* const* strings,
+		const size_t* lengths,
+		size_t count,
+		Policy& policy,
+		size_t* sizes,
+		byte_t** blocks,
+		std::vector<StringT>& result)
+	{
+		for (size_t i = 0; i < count; i++)
+		{
+			sizes[i] = 0;
+			if (strings[i])
+				sizes[i] = ((lengths ? lengths[i] : Traits::GetLength(strings[i])) + 1) * sizeof(T);
+		}
+
+		if (!policy.AllocateBlocks(sizes, count, blocks))
+			return false;
+
+		for (size_t i = 0; i < count; i++)
+		{
+			result.emplace_back(policy);
+			if (blocks[i])
+			{
+				auto& string = result.back();
+				string.m_buffer = reinterpret_cast<T*>(blocks[i]);
+				string.m_size = sizes[i];
+				string.m_capacity = sizes[i];
+				Traits::Copy(string.m_buffer, sizes[i] / sizeof(T), strings[i], sizes[i] / sizeof(T) - 1);
+			}
+		}
+		return true;
+	}
+
+	template <typename T, typename Traits, typename Policy>
+	template <typename... Ts>
+	StringT<T, Traits, Policy> StringT<T, Traits, Policy>::Format(const T* format, const Ts&... ts)
+	{
+		return Format(Policy(), format, ts...);
+	}
+
+	template <typename T, typename Traits, typename Policy>
 	template <typename... Ts>
-	StringT<T, Traits> StringT<T, Traits>::Format(const T* format, const Ts&... ts)
+	StringT<T, Traits, Policy> StringT<T, Traits, Policy>::Format(const Policy& allocator, const T* format, const Ts&... ts)
 	{
 #ifdef _DEBUG
 		Details::FormatCheck(format, Details::NormalizeArg(ts)...);
 #endif
 		const auto length = Traits::FormatCount(format, Details::NormalizeArg(ts)...);
 		if (0 == length)
-			return StringT();
+			return StringT(allocator);
 
-		StringT result(length);
+		StringT result(length, allocator);
 		if (nullptr != result.m_buffer)
 			Traits::Format(result.m_buffer, result.m_size, format, Details::NormalizeArg(ts)...);
 		return result;
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::CopyFrom(const StringT& other)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::CopyFrom(const StringT& other)
 	{
 		Base::CopyFrom(other);
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::MoveFrom(StringT& other)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::MoveFrom(StringT& other)
 	{
 		Base::MoveFrom(other);
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::DoReserve(size_t length)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::DoReserve(size_t length)
 	{
 		const auto size = (length + 1) * sizeof(T);
 		DoAllocate(size);
 		memset(m_buffer, 0, m_size);
 	}
 
-	template <typename T, typename Traits>
-	void StringT<T, Traits>::DoReplace(size_t from, size_t whatLength, const T* with, size_t withLength)
+	template <typename T, typename Traits, typename Policy>
+	void StringT<T, Traits, Policy>::DoReplace(size_t from, size_t whatLength, const T* with, size_t withLength)
 	{
 		const auto diff = static_cast<ptrdiff_t>(withLength) - static_cast<ptrdiff_t>(whatLength);
 		const auto length = Traits::GetLength(m_buffer);
@@ -900,7 +1099,7 @@ namespace Neat
 		{
 			const auto source = from + whatLength;
 			const auto destin = from + withLength;
-			StringT<T, Traits> other(required, m_allocator);
+			StringT<T, Traits, Policy> other(required, GetPolicy());
 			Traits::Copy(other.m_buffer, other.m_size / sizeof(T), m_buffer, from);
 			Traits::Copy(other.m_buffer + from, other.m_size / sizeof(T) - from, with, withLength);
 			Traits::Copy(other.m_buffer + destin, other.m_size / sizeof(T) - destin, m_buffer + source, m_size / sizeof(T) - source);
@@ -920,14 +1119,14 @@ namespace Neat
 		}
 	}
 
-	template <typename T, typename Traits>
-	bool operator==(const T* left, const StringT<T, Traits>& right)
+	template <typename T, typename Traits, typename Policy>
+	bool operator==(const T* left, const StringT<T, Traits, Policy>& right)
 	{
 		return right.IsEqual(left);
 	}
 
-	template <typename T, typename Traits>
-	bool operator!=(const T* left, const StringT<T, Traits>& right)
+	template <typename T, typename Traits, typename Policy>
+	bool operator!=(const T* left, const StringT<T, Traits, Policy>& right)
 	{
 		return !right.IsEqual(left);
 	}
@@ -968,8 +1167,8 @@ namespace Neat { namespace Details
 		return arg.c_str();
 	}
 
-	template <typename T, typename Traits>
-	const T* NormalizeArg(const Neat::StringT<T, Traits>& arg)
+	template <typename T, typename Traits, typename Policy>
+	const T* NormalizeArg(const Neat::StringT<T, Traits, Policy>& arg)
 	{
 		return arg.operator const T*();
 	}
@@ -57,20 +57,61 @@ namespace Neat::Win
 	{
 	}
 
+	FileMapping FileMapping::Create(
+		DWORD flProtect,
+		ULONGLONG ullMaximumSize,
+		LPCWSTR lpName,
+		LPSECURITY_ATTRIBUTES lpSecurityAttributes)
+	{
+		ULARGE_INTEGER size;
+		size.QuadPart = ullMaximumSize;
+
+		Handle handle = ::CreateFileMappingW(
+			INVALID_HANDLE_VALUE,
+			lpSecurityAttributes,
+			flProtect,
+			size.HighPart,
+			size.LowPart,
+			lpName);
+
+		if (!handle)
+			throw LastErrorException();
+
+		return handle;
+	}
+
+	FileMapping FileMapping::Open(
+		DWORD dwDesiredAccess,
+		LPCWSTR lpName,
+		BOOL bInheritHandle)
+	{
+		Handle handle = ::OpenFileMappingW(
+			dwDesiredAccess,
+			bInheritHandle,
+			lpName);
+
+		if (!handle)
+			throw LastErrorException();
+
+		return handle;
+	}
+
 	FileView FileMapping::MapView(
 		DWORD dwDesiredAccess,
 		ULONGLONG ullFileOffset,
-		SIZE_T dwNumberOfBytesToMap) const
+		SIZE_T dwNumberOfBytesToMap,
+		LPVOID lpBaseAddress) const
 	{
 		ULARGE_INTEGER offset;
 		offset.QuadPart = ullFileOffset;
 
-		auto base = ::MapViewOfFile(
+		auto base = ::MapViewOfFileEx(
 			m_handle,
 			dwDesiredAccess,
 			offset.HighPart,
 			offset.LowPart,
-			dwNumberOfBytesToMap);
+			dwNumberOfBytesToMap,
+			lpBaseAddress);
 
 		if (!base)
 			throw LastErrorException();
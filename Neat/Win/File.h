@@ -50,10 +50,24 @@ namespace Neat::Win
 		FileMapping(Handle&& handle);
 
 	public:
+		// Creates mapping backed by the paging file, or opens existing one of the same name
+		static FileMapping Create(
+			DWORD flProtect,
+			ULONGLONG ullMaximumSize,
+			LPCWSTR lpName = nullptr,
+			LPSECURITY_ATTRIBUTES lpSecurityAttributes = nullptr);
+
+		static FileMapping Open(
+			DWORD dwDesiredAccess,
+			LPCWSTR lpName,
+			BOOL bInheritHandle = FALSE);
+
+		// Maps at the given base address unless it's null, e.g. to place views back to back
 		FileView MapView(
 			DWORD dwDesiredAccess,
 			ULONGLONG ullFileOffset,
-			SIZE_T dwNumberOfBytesToMap) const;
+			SIZE_T dwNumberOfBytesToMap,
+			LPVOID lpBaseAddress = nullptr) const;
 
 	private:
 		Handle m_handle;
@@ -0,0 +1,48 @@
+#include "MirroredMemory.h"
+#include "Neat\Win\Exception.h"
+#include "Neat\Win\PageAllocator.h"
+
+namespace Neat::Win
+{
+	namespace
+	{
+		constexpr int MaxAttempts = 16;
+	}
+
+	MirroredMemory::MirroredMemory(FileMapping&& mapping, FileView&& view, FileView&& mirror, size_t size)
+		: m_mapping(std::move(mapping))
+		, m_view(std::move(view))
+		, m_mirror(std::move(mirror))
+		, m_size(size)
+	{
+	}
+
+	MirroredMemory MirroredMemory::Create(size_t size)
+	{
+		const auto granularity = PageAllocator::GetAllocationGranularity();
+		size = (size + granularity - 1) / granularity * granularity;
+		auto mapping = FileMapping::Create(PAGE_READWRITE, size);
+
+		for (auto attempt = 1; ; attempt++)
+		{
+			// Finds a free range for both views and releases it, so the views can take it
+			const auto base = static_cast<byte_t*>(::VirtualAlloc(nullptr, 2 * size, MEM_RESERVE, PAGE_NOACCESS));
+			if (!base)
+				throw LastErrorException();
+			::VirtualFree(base, 0, MEM_RELEASE);
+
+			try
+			{
+				auto view = mapping.MapView(FILE_MAP_ALL_ACCESS, 0, size, base);
+				auto mirror = mapping.MapView(FILE_MAP_ALL_ACCESS, 0, size, base + size);
+				return { std::move(mapping), std::move(view), std::move(mirror), size };
+			}
+			catch (const Win32Exception&)
+			{
+				// Another thread took part of the range
+				if (attempt == MaxAttempts)
+					throw;
+			}
+		}
+	}
+}
@@ -0,0 +1,55 @@
+#pragma once
+#include "Neat\Types.h"
+#include "Neat\Win\File.h"
+
+#include <Windows.h>
+
+namespace Neat::Win
+{
+	//
+	// Region backed by the paging file which is mapped twice back to back, so bytes written past
+	// its end land at its start. Rings built on it, e.g. ByteRing, get contiguous spans across
+	// the wraparound. Views can only be placed at free addresses, which another thread may take
+	// meanwhile, so placing them is retried a few times.
+	//
+
+	class MirroredMemory
+	{
+	public:
+		// Size is rounded up to the allocation granularity, see PageAllocator
+		static MirroredMemory Create(size_t size);
+
+		MirroredMemory(MirroredMemory&& other) = default;
+		MirroredMemory& operator=(MirroredMemory&& other) = default;
+
+		// Base is followed by 2 * GetSize() bytes, where the second half mirrors the first one
+		byte_t* GetBase();
+		const byte_t* GetBase() const;
+		// Returns size of the region, without the mirror
+		size_t GetSize() const;
+
+	private:
+		MirroredMemory(FileMapping&& mapping, FileView&& view, FileView&& mirror, size_t size);
+
+	private:
+		FileMapping m_mapping;
+		FileView m_view;
+		FileView m_mirror;
+		size_t m_size;
+	};
+
+	inline byte_t* MirroredMemory::GetBase()
+	{
+		return m_view.GetBase();
+	}
+
+	inline const byte_t* MirroredMemory::GetBase() const
+	{
+		return m_view.GetBase();
+	}
+
+	inline size_t MirroredMemory::GetSize() const
+	{
+		return m_size;
+	}
+}
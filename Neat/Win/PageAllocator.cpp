@@ -0,0 +1,153 @@
+#include "Neat\Win\PageAllocator.h"
+
+namespace Neat::Win
+{
+	namespace
+	{
+		size_t RoundUp(size_t bytes, size_t alignment)
+		{
+			return ((std::max)(bytes, 1_sz) + alignment - 1) & ~(alignment - 1);
+		}
+	}
+
+	PageAllocator::PageAllocator(uint32_t options) :
+		m_options(options)
+	{
+	}
+
+	byte_t* PageAllocator::Allocate(size_t bytes)
+	{
+		const auto largePageSize = GetLargePageSize();
+		if ((m_options & LargePages) && largePageSize > 0)
+		{
+			// Large pages are locked in memory, so they need no pre-faulting
+			const auto p = ::VirtualAlloc(
+				nullptr,
+				RoundUp(bytes, largePageSize),
+				MEM_RESERVE | MEM_COMMIT | MEM_LARGE_PAGES,
+				PAGE_READWRITE);
+			if (p)
+				return static_cast<byte_t*>(p);
+		}
+
+		// The whole granularity is reserved anyway, the rest of it is left for TryExpand
+		const auto p = static_cast<byte_t*>(::VirtualAlloc(
+			nullptr,
+			RoundUp(bytes, GetAllocationGranularity()),
+			MEM_RESERVE,
+			PAGE_NOACCESS));
+		if (!p)
+			return nullptr;
+
+		const auto committed = RoundUp(bytes, GetPageSize());
+		if (!::VirtualAlloc(p, committed, MEM_COMMIT, PAGE_READWRITE))
+		{
+			::VirtualFree(p, 0, MEM_RELEASE);
+			return nullptr;
+		}
+
+		if (m_options & Prefault)
+			Touch(p, committed);
+		return p;
+	}
+
+	void PageAllocator::Deallocate(byte_t* p, size_t bytes)
+	{
+		if (p)
+			::VirtualFree(p, 0, MEM_RELEASE);
+	}
+
+	bool PageAllocator::Owns(byte_t* p, size_t bytes)
+	{
+		MEMORY_BASIC_INFORMATION info = {};
+		if (!p || 0 == ::VirtualQuery(p, &info, sizeof(info)))
+			return false;
+
+		return info.AllocationBase == p &&
+			MEM_PRIVATE == info.Type &&
+			MEM_COMMIT == info.State &&
+			info.RegionSize >= bytes;
+	}
+
+	byte_t* PageAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		if (alignment > GetAllocationGranularity())
+			return nullptr;
+		return Allocate(bytes);
+	}
+
+	void PageAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		Deallocate(p, bytes);
+	}
+
+	bool PageAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		MEMORY_BASIC_INFORMATION info = {};
+		if (!p || 0 == ::VirtualQuery(p, &info, sizeof(info)) || info.AllocationBase != p)
+			return false;
+
+		// Committed pages of the block come first, the reserved ones follow
+		const auto committed = info.RegionSize;
+		const auto required = RoundUp(newBytes, GetPageSize());
+		if (required <= committed)
+		{
+			// Fails for large pages, which stay committed until the block is released
+			if (required < committed)
+				::VirtualFree(p + required, committed - required, MEM_DECOMMIT);
+			return true;
+		}
+
+		const auto tail = p + committed;
+		if (0 == ::VirtualQuery(tail, &info, sizeof(info)) ||
+			info.AllocationBase != p ||
+			MEM_RESERVE != info.State ||
+			committed + info.RegionSize < required)
+		{
+			return false;
+		}
+
+		if (!::VirtualAlloc(tail, required - committed, MEM_COMMIT, PAGE_READWRITE))
+			return false;
+
+		if (m_options & Prefault)
+			Touch(tail, required - committed);
+		return true;
+	}
+
+	size_t PageAllocator::GetPageSize()
+	{
+		static const auto s_pageSize = []()
+		{
+			SYSTEM_INFO info = {};
+			::GetSystemInfo(&info);
+			return static_cast<size_t>(info.dwPageSize);
+		}();
+		return s_pageSize;
+	}
+
+	size_t PageAllocator::GetLargePageSize()
+	{
+		static const auto s_largePageSize = static_cast<size_t>(::GetLargePageMinimum());
+		return s_largePageSize;
+	}
+
+	size_t PageAllocator::GetAllocationGranularity()
+	{
+		static const auto s_granularity = []()
+		{
+			SYSTEM_INFO info = {};
+			::GetSystemInfo(&info);
+			return static_cast<size_t>(info.dwAllocationGranularity);
+		}();
+		return s_granularity;
+	}
+
+	void PageAllocator::Touch(byte_t* p, size_t bytes)
+	{
+		const auto pageSize = GetPageSize();
+		const auto pages = static_cast<volatile byte_t*>(p);
+		for (size_t offset = 0; offset < bytes; offset += pageSize)
+			pages[offset] = 0;
+	}
+}
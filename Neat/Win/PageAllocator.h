@@ -0,0 +1,59 @@
+#pragma once
+#include "Neat\Allocator.h"
+
+namespace Neat::Win
+{
+	//
+	// Maps every block directly with VirtualAlloc, so it starts on its own pages and goes back
+	// to the OS on Deallocate. Meant for large blocks, e.g. as the fallback of FallbackAllocator
+	// or the large branch of SegregatorAllocator.
+	//
+
+	class PageAllocator : public IAllocator
+	{
+	public:
+		enum Options : uint32_t
+		{
+			None = 0,
+			// Uses large pages when the process holds SeLockMemoryPrivilege, regular pages otherwise
+			LargePages = 1,
+			// Touches every page up front, so the first access doesn't page fault
+			Prefault = 2,
+		};
+
+		explicit PageAllocator(uint32_t options = None);
+		PageAllocator(const PageAllocator& other) = delete;
+		PageAllocator& operator=(const PageAllocator& other) = delete;
+
+		byte_t* Allocate(size_t bytes) override;
+		void Deallocate(byte_t* p, size_t bytes) override;
+		// Accepts only block start addresses
+		bool Owns(byte_t* p, size_t bytes) override;
+
+		// Blocks are aligned to the allocation granularity, larger alignment is not supported
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		// Commits or decommits pages within the address range reserved for the block
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+
+		uint32_t GetOptions() const;
+
+		static size_t GetPageSize();
+		// Returns zero when large pages are not supported
+		static size_t GetLargePageSize();
+		// Returns alignment of addresses reserved by VirtualAlloc
+		static size_t GetAllocationGranularity();
+
+	private:
+		static void Touch(byte_t* p, size_t bytes);
+
+	private:
+		uint32_t m_options;
+	};
+
+	inline uint32_t PageAllocator::GetOptions() const
+	{
+		return m_options;
+	}
+}
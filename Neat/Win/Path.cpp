@@ -10,17 +10,17 @@
 
 namespace Neat::Win
 {
-	Path16 Path16::GetCurrent()
+	Path16 Path16::GetCurrent(IAllocator* allocator)
 	{
 		const auto length = ::GetCurrentDirectoryW(0, nullptr);
-		Utf16 dir(length - 1);
+		Utf16 dir(length - 1, allocator);
 		const auto success = ::GetCurrentDirectoryW(length, dir);
 		if (!success)
 			throw LastErrorException();
 		return dir;
 	}
 
-	Path16 Path16::UrlToWin32(const wchar_t* url)
+	Path16 Path16::UrlToWin32(const wchar_t* url, IAllocator* allocator)
 	{
 		DWORD length = MAX_PATH + 1;
 		wchar_t win32Path[MAX_PATH + 1] = {0};
@@ -29,7 +29,7 @@ namespace Neat::Win
 		if (hr != S_OK)
 			throw Win32Exception(hr);
 
-		return Path16(win32Path);
+		return Path16(win32Path, allocator);
 	}
 
 	Path16 Path16::GetFileName(Utf16 cmdLine)
@@ -68,7 +68,7 @@ namespace Neat::Win
 
 			if (filename)
 			{
-				cmdLine = Utf16(filename[0]);
+				cmdLine = Utf16(filename[0], Utf16::End, cmdLine.GetAllocator());
 				::LocalFree(filename);
 			}
 		}
@@ -100,12 +100,12 @@ namespace Neat::Win
 		return cmdLine;
 	}
 
-	Path16 Path16::NtToWin32(const wchar_t* ntPath, bool kernelRules)
+	Path16 Path16::NtToWin32(const wchar_t* ntPath, bool kernelRules, IAllocator* allocator)
 	{
 		static const auto systemRoot = Environment::ExpandString(L"%windir%");
 		static const auto systemDrive = Environment::ExpandString(L"%SystemDrive%");
 
-		Utf16 path(ntPath);
+		Utf16 path(ntPath, Utf16::End, allocator);
 		path.Replace(L"\\SystemRoot", systemRoot);
 
 		if (path.BeginsWith(L"\\??\\"))
@@ -115,48 +115,54 @@ namespace Neat::Win
 
 		if (kernelRules)
 		{
+			// Prefixed paths are built with the allocator of the result
 			if (path.BeginsWith(L"\\"))
 			{
-				path = systemDrive + path;
+				Utf16 prefixed(systemDrive, Utf16::End, allocator);
+				prefixed += path;
+				path = std::move(prefixed);
 			}
 
 			auto slash = path.Find(L"\\");
 			if (-1 == slash)
 			{
-				path = systemRoot + L"\\System32\\Drivers\\" + path;
+				Utf16 prefixed(systemRoot, Utf16::End, allocator);
+				prefixed += L"\\System32\\Drivers\\";
+				prefixed += path;
+				path = std::move(prefixed);
 			}
 		}
 
 		return path;
 	}
 
-	Path16 Path16::SearchFullPath(const wchar_t* fileName)
+	Path16 Path16::SearchFullPath(const wchar_t* fileName, IAllocator* allocator)
 	{
 		uint32_t length = ::SearchPathW(NULL, fileName, NULL, 0, NULL, NULL);
 		if (length > 0)
 		{
-			Utf16 string(length - 1);
+			Utf16 string(length - 1, allocator);
 			if (::SearchPathW(NULL, fileName, NULL, length, string, NULL) > 0)
 			{
 				return Path16(std::move(string));
 			}
 		}
 
-		return Path16(fileName);
+		return Path16(fileName, allocator);
 	}
 
-	Path16 Path16::GetFullPath(const wchar_t* path)
+	Path16 Path16::GetFullPath(const wchar_t* path, IAllocator* allocator)
 	{
 		auto relative = ::PathIsRelativeW(path);
 		if (relative)
 		{
-			return SearchFullPath(path);
+			return SearchFullPath(path, allocator);
 		}
 
-		return Path16(path);
+		return Path16(path, allocator);
 	}
 
-	std::pair<Utf16, Utf16> Path16::SplitCommandLine(const wchar_t* commandLine)
+	std::pair<Utf16, Utf16> Path16::SplitCommandLine(const wchar_t* commandLine, IAllocator* allocator)
 	{
 		if (nullptr == commandLine || L'\0' == *commandLine)
 			throw std::runtime_error("Bad command line");
@@ -203,22 +209,22 @@ namespace Neat::Win
 			first++;
 			auto quote = skipQuoted(first);
 			second = skipSpaces(quote + 1);
-			return std::make_pair(Utf16(first, quote - first), Utf16(second));
+			return std::make_pair(Utf16(first, quote - first, allocator), Utf16(second, Utf16::End, allocator));
 		}
 		else
 		{
 			auto space = skipWord(first);
-			Utf16 executable(first, space - first);
+			Utf16 executable(first, space - first, allocator);
 			const auto expanded = Environment::ExpandString(executable);
 			const auto found = ::SearchPathW(NULL, expanded, NULL, 0, NULL, NULL);
 			if (found)
 			{
 				second = skipSpaces(space + 1);
-				return std::make_pair(std::move(executable), Utf16(second));
+				return std::make_pair(std::move(executable), Utf16(second, Utf16::End, allocator));
 			}
 			else
 			{
-				return std::make_pair(Utf16(first), L"");
+				return std::make_pair(Utf16(first, Utf16::End, allocator), Utf16(L"", Utf16::End, allocator));
 			}
 		}
 	}
@@ -6,13 +6,18 @@
 
 namespace Neat::Win
 {
+	//
+	// Parts of a path and paths made from it take its allocator, like substrings of StringT do.
+	// Static functions take the allocator of the result, null means the current scope's or the heap.
+	//
+
 	template <typename T>
 	class PathT : public StringT<T>
 	{
 		typedef StringT<T> Base;
 
 	public:
-		PathT(const T* path = nullptr);
+		PathT(const T* path = nullptr, IAllocator* allocator = nullptr);
 		PathT(StringT<T>&& path);
 
 		PathT(PathT&& other);
@@ -33,16 +38,20 @@ namespace Neat::Win
 		void ReplaceDirectory(const StringT<T>& other);
 
 		StringT<T> GetName() const;
+		StringT<T> GetName(IAllocator* allocator) const;
 		StringT<T> GetNameWithoutExtension() const;
+		StringT<T> GetNameWithoutExtension(IAllocator* allocator) const;
 		StringT<T> GetFolder() const;
+		StringT<T> GetFolder(IAllocator* allocator) const;
 
-		static PathT GetCurrent();
-		static PathT UrlToWin32(const T* url);
+		static PathT GetCurrent(IAllocator* allocator = nullptr);
+		static PathT UrlToWin32(const T* url, IAllocator* allocator = nullptr);
+		// Result takes the allocator of cmdLine
 		static PathT GetFileName(StringT<T> cmdLine);
-		static PathT NtToWin32(const T* ntPath, bool kernelRules);
-		static PathT SearchFullPath(const T* fileName);
-		static PathT GetFullPath(const T* path);
-		static std::pair<StringT<T>, StringT<T>> SplitCommandLine(const T* commandLine);
+		static PathT NtToWin32(const T* ntPath, bool kernelRules, IAllocator* allocator = nullptr);
+		static PathT SearchFullPath(const T* fileName, IAllocator* allocator = nullptr);
+		static PathT GetFullPath(const T* path, IAllocator* allocator = nullptr);
+		static std::pair<StringT<T>, StringT<T>> SplitCommandLine(const T* commandLine, IAllocator* allocator = nullptr);
 
 	protected:
 		void MoveFrom(PathT& other);
@@ -50,8 +59,8 @@ namespace Neat::Win
 	};
 
 	template <typename T>
-	PathT<T>::PathT(const T* path)
-		: Base(path)
+	PathT<T>::PathT(const T* path, IAllocator* allocator)
+		: Base(path, Base::End, allocator)
 	{
 	}
 
@@ -68,22 +77,23 @@ namespace Neat::Win
 	}
 
 	template <typename T>
-	PathT<T>::PathT(const PathT& other)
+	PathT<T>::PathT(const PathT& other) :
+		Base(other)
 	{
-		CopyFrom(other);
 	}
 
 	template <typename T>
 	PathT<T>& PathT<T>::operator=(PathT&& other)
 	{
-		MoveFrom(other);
+		Base::operator=(std::move(other));
 		return *this;
 	}
 
 	template <typename T>
 	PathT<T>& PathT<T>::operator=(const PathT& other)
 	{
-		CopyFrom(other);
+		// Frees the old path and keeps the allocator of this one
+		Base::operator=(other);
 		return *this;
 	}
 
@@ -198,15 +208,27 @@ namespace Neat::Win
 
 	template <typename T>
 	StringT<T> PathT<T>::GetName() const
+	{
+		return GetName(GetAllocator());
+	}
+
+	template <typename T>
+	StringT<T> PathT<T>::GetName(IAllocator* allocator) const
 	{
 		auto slash = FindLast('\\');
 		if (Base::End != slash)
-			return Substring(++slash);
-		return *this;
+			return Substring(++slash, Base::End, allocator);
+		return StringT<T>(*this, allocator);
 	}
 
 	template <typename T>
 	StringT<T> PathT<T>::GetNameWithoutExtension() const
+	{
+		return GetNameWithoutExtension(GetAllocator());
+	}
+
+	template <typename T>
+	StringT<T> PathT<T>::GetNameWithoutExtension(IAllocator* allocator) const
 	{
 		auto dot = FindLast('.');
 		auto slash = FindLast('\\');
@@ -216,34 +238,40 @@ namespace Neat::Win
 			if (Base::End != dot && dot >= slash)
 			{
 				auto size = dot - slash;
-				return Substring(slash, size);
+				return Substring(slash, size, allocator);
 			}
 			else
 			{
-				return Substring(slash);
+				return Substring(slash, Base::End, allocator);
 			}
 		}
 		else if (Base::End != dot)
 		{
-			return Substring(0, dot);
+			return Substring(0, dot, allocator);
 		}
-		return *this;
+		return StringT<T>(*this, allocator);
 	}
 
 	template <typename T>
 	StringT<T> PathT<T>::GetFolder() const
+	{
+		return GetFolder(GetAllocator());
+	}
+
+	template <typename T>
+	StringT<T> PathT<T>::GetFolder(IAllocator* allocator) const
 	{
 		auto slash = FindLast('\\');
 		if (0 == slash)
-			return *this;
+			return StringT<T>(*this, allocator);
 
 		if (Base::End != slash)
 		{
 			if (m_buffer[slash - 1] == ':')
-				return Substring(0, slash + 1);
-			return Substring(0, slash);
+				return Substring(0, slash + 1, allocator);
+			return Substring(0, slash, allocator);
 		}
-		return StringT<T>(0, nullptr);
+		return StringT<T>(0, allocator);
 	}
 
 	template <typename T>
@@ -0,0 +1,228 @@
+#include "Neat\Win\ProfilingAllocator.h"
+#include "Neat\Convert.h"
+
+#include <Windows.h>
+#include <TlHelp32.h>
+
+#include <cmath>
+
+namespace Neat::Win
+{
+	ProfilingAllocator::ProfilingAllocator(IAllocator* allocator, size_t samplingInterval) :
+		m_allocator(allocator),
+		m_samplingInterval(samplingInterval)
+	{
+		for (auto& counter : m_filter)
+			counter.store(0, std::memory_order_relaxed);
+	}
+
+	byte_t* ProfilingAllocator::Allocate(size_t bytes)
+	{
+		const auto p = m_allocator->Allocate(bytes);
+		if (p && ShouldSample(bytes))
+			OnAllocate(p, bytes);
+		return p;
+	}
+
+	void ProfilingAllocator::Deallocate(byte_t* p, size_t bytes)
+	{
+		OnDeallocate(p);
+		m_allocator->Deallocate(p, bytes);
+	}
+
+	bool ProfilingAllocator::Owns(byte_t* p, size_t bytes)
+	{
+		return m_allocator->Owns(p, bytes);
+	}
+
+	byte_t* ProfilingAllocator::AllocateAligned(size_t bytes, size_t alignment)
+	{
+		const auto p = m_allocator->AllocateAligned(bytes, alignment);
+		if (p && ShouldSample(bytes))
+			OnAllocate(p, bytes);
+		return p;
+	}
+
+	void ProfilingAllocator::DeallocateAligned(byte_t* p, size_t bytes, size_t alignment)
+	{
+		OnDeallocate(p);
+		m_allocator->DeallocateAligned(p, bytes, alignment);
+	}
+
+	// Resizing is profiled as deallocation of the old block and allocation of the new one
+	bool ProfilingAllocator::TryExpand(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		if (!m_allocator->TryExpand(p, bytes, newBytes))
+			return false;
+
+		OnDeallocate(p);
+		if (ShouldSample(newBytes))
+			OnAllocate(p, newBytes);
+		return true;
+	}
+
+	byte_t* ProfilingAllocator::Reallocate(byte_t* p, size_t bytes, size_t newBytes)
+	{
+		// Old block may be reused by another thread as soon as it's released
+		const auto sample = OnDeallocate(p);
+		const auto q = m_allocator->Reallocate(p, bytes, newBytes);
+		if (!q)
+		{
+			// Old block stays valid, so its sample is live again
+			if (sample.counters)
+				OnRestore(p, sample);
+			return nullptr;
+		}
+
+		if (ShouldSample(newBytes))
+			OnAllocate(q, newBytes);
+		return q;
+	}
+
+	size_t ProfilingAllocator::GetLiveSampleCount()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		return m_samples.size();
+	}
+
+	std::string ProfilingAllocator::GetProfile()
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+
+		Counters total = {};
+		for (const auto& stack : m_stacks)
+		{
+			total.liveCount += stack.second.liveCount;
+			total.liveBytes += stack.second.liveBytes;
+			total.totalCount += stack.second.totalCount;
+			total.totalBytes += stack.second.totalBytes;
+		}
+
+		// pprof scales raw samples back by the interval given in the header
+		char line[256];
+		std::string profile;
+		sprintf_s(line, "heap profile: %zu: %zu [%zu: %zu] @ heap_v2/%zu\n",
+			total.liveCount, total.liveBytes, total.totalCount, total.totalBytes, m_samplingInterval);
+		profile += line;
+
+		for (const auto& stack : m_stacks)
+		{
+			const auto& counters = stack.second;
+			sprintf_s(line, "%zu: %zu [%zu: %zu] @",
+				counters.liveCount, counters.liveBytes, counters.totalCount, counters.totalBytes);
+			profile += line;
+			for (const auto frame : stack.first)
+			{
+				sprintf_s(line, " 0x%016llx", static_cast<unsigned long long>(reinterpret_cast<uintptr_t>(frame)));
+				profile += line;
+			}
+			profile += "\n";
+		}
+
+		// Module ranges let pprof map addresses to binaries for symbolization
+		profile += "\nMAPPED_LIBRARIES:\n";
+		const auto snapshot = ::CreateToolhelp32Snapshot(TH32CS_SNAPMODULE, 0);
+		if (INVALID_HANDLE_VALUE == snapshot)
+			return profile;
+
+		MODULEENTRY32W module = {};
+		module.dwSize = sizeof(module);
+		for (auto found = ::Module32FirstW(snapshot, &module); found; found = ::Module32NextW(snapshot, &module))
+		{
+			const auto begin = reinterpret_cast<uintptr_t>(module.modBaseAddr);
+			sprintf_s(line, "%016llx-%016llx r-xp 00000000 00:00 0 ",
+				static_cast<unsigned long long>(begin),
+				static_cast<unsigned long long>(begin + module.modBaseSize));
+			profile += line;
+			profile += Convert::ToUtf8(module.szExePath).GetString();
+			profile += "\n";
+		}
+		::CloseHandle(snapshot);
+		return profile;
+	}
+
+	bool ProfilingAllocator::ShouldSample(size_t bytes)
+	{
+		auto& sampler = m_samplers.Get();
+		if (0 == sampler.random)
+		{
+			// Seeds differ between threads, so they don't sample in lockstep
+			sampler.random = (reinterpret_cast<uintptr_t>(&sampler) ^ ::GetTickCount64()) | 1;
+			sampler.bytesUntilSample = GetNextInterval(sampler.random);
+		}
+
+		if (static_cast<int64_t>(bytes) < sampler.bytesUntilSample)
+		{
+			sampler.bytesUntilSample -= bytes;
+			return false;
+		}
+
+		sampler.bytesUntilSample = GetNextInterval(sampler.random);
+		return true;
+	}
+
+	void ProfilingAllocator::OnAllocate(byte_t* p, size_t bytes)
+	{
+		void* frames[MaxFrames];
+		// Skips this function and the allocating one
+		const auto count = ::RtlCaptureStackBackTrace(2, MaxFrames, frames, nullptr);
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		auto& counters = m_stacks[std::vector<void*>(frames, frames + count)];
+		counters.liveCount++;
+		counters.liveBytes += bytes;
+		counters.totalCount++;
+		counters.totalBytes += bytes;
+
+		m_samples[p] = { bytes, &counters };
+		m_filter[GetFilterIndex(p)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	ProfilingAllocator::Sample ProfilingAllocator::OnDeallocate(byte_t* p)
+	{
+		// Block is sampled before it's handed out, so a zero counter proves it wasn't
+		if (!p || 0 == m_filter[GetFilterIndex(p)].load(std::memory_order_relaxed))
+			return {};
+
+		std::lock_guard<std::mutex> lock(m_mutex);
+		const auto sample = m_samples.find(p);
+		if (sample == m_samples.end())
+			return {};
+
+		const auto removed = sample->second;
+		removed.counters->liveCount--;
+		removed.counters->liveBytes -= removed.bytes;
+		m_samples.erase(sample);
+		m_filter[GetFilterIndex(p)].fetch_sub(1, std::memory_order_relaxed);
+		return removed;
+	}
+
+	// Counters of the sample stay in m_stacks, which never shrinks
+	void ProfilingAllocator::OnRestore(byte_t* p, const Sample& sample)
+	{
+		std::lock_guard<std::mutex> lock(m_mutex);
+		sample.counters->liveCount++;
+		sample.counters->liveBytes += sample.bytes;
+		m_samples[p] = sample;
+		m_filter[GetFilterIndex(p)].fetch_add(1, std::memory_order_relaxed);
+	}
+
+	int64_t ProfilingAllocator::GetNextInterval(uint64_t& random) const
+	{
+		if (0 == m_samplingInterval)
+			return 0;
+
+		// xorshift64*, top 53 bits give uniform value in (0, 1]
+		random ^= random >> 12;
+		random ^= random << 25;
+		random ^= random >> 27;
+		const auto uniform = static_cast<double>(((random * 0x2545F4914F6CDD1Dull) >> 11) + 1) / 9007199254740992.0;
+		return static_cast<int64_t>(-std::log(uniform) * static_cast<double>(m_samplingInterval));
+	}
+
+	size_t ProfilingAllocator::GetFilterIndex(byte_t* p)
+	{
+		const auto address = static_cast<uint64_t>(reinterpret_cast<uintptr_t>(p));
+		return static_cast<size_t>((address * 0x9E3779B97F4A7C15ull) >> 40) & (FilterSize - 1);
+	}
+}
@@ -0,0 +1,96 @@
+#pragma once
+#include "Neat\Allocator.h"
+#include "Neat\ThreadLocal.h"
+
+#include <atomic>
+#include <map>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace Neat::Win
+{
+	//
+	// Sampling heap profiler decorator. Distances between sampled bytes are drawn from exponential
+	// distribution with the given mean, so every byte has the same chance to be sampled whatever
+	// the allocation sizes are. Unsampled allocations only decrement a per-thread counter,
+	// sampled ones capture their call stack. Profiles are written in the heap profile format
+	// of gperftools, which pprof reads and unsamples.
+	//
+
+	class ProfilingAllocator : public IAllocator
+	{
+	public:
+		static constexpr size_t MaxFrames = 32;
+
+		// Interval of zero samples every allocation
+		explicit ProfilingAllocator(IAllocator* allocator, size_t samplingInterval = 512_kB);
+		ProfilingAllocator(const ProfilingAllocator& other) = delete;
+		ProfilingAllocator& operator=(const ProfilingAllocator& other) = delete;
+
+		byte_t* Allocate(size_t bytes) override;
+		void Deallocate(byte_t* p, size_t bytes) override;
+		bool Owns(byte_t* p, size_t bytes) override;
+
+		byte_t* AllocateAligned(size_t bytes, size_t alignment) override;
+		void DeallocateAligned(byte_t* p, size_t bytes, size_t alignment) override;
+
+		bool TryExpand(byte_t* p, size_t bytes, size_t newBytes) override;
+		byte_t* Reallocate(byte_t* p, size_t bytes, size_t newBytes) override;
+
+		size_t GetSamplingInterval() const;
+		// Returns number of sampled blocks which are not deallocated yet
+		size_t GetLiveSampleCount();
+		// Returns live and cumulative samples by call stack followed by loaded modules
+		std::string GetProfile();
+
+	private:
+		struct Counters
+		{
+			size_t liveCount;
+			size_t liveBytes;
+			size_t totalCount;
+			size_t totalBytes;
+		};
+
+		struct Sample
+		{
+			size_t bytes;
+			Counters* counters;
+		};
+
+		struct Sampler
+		{
+			int64_t bytesUntilSample;
+			uint64_t random;
+		};
+
+		static constexpr size_t FilterSize = 1 << 14;
+
+		bool ShouldSample(size_t bytes);
+		void OnAllocate(byte_t* p, size_t bytes);
+		// Returns the removed sample, its counters are null when the block wasn't sampled
+		Sample OnDeallocate(byte_t* p);
+		void OnRestore(byte_t* p, const Sample& sample);
+		int64_t GetNextInterval(uint64_t& random) const;
+
+		static size_t GetFilterIndex(byte_t* p);
+
+	private:
+		IAllocator* m_allocator;
+		size_t m_samplingInterval;
+		ThreadLocal<Sampler> m_samplers;
+		// Counts sampled blocks by address hash, so most deallocations don't need the lock
+		std::atomic<uint32_t> m_filter[FilterSize];
+		// Profile data lives on the process heap, not in the profiled allocator
+		std::mutex m_mutex;
+		std::map<std::vector<void*>, Counters> m_stacks;
+		std::unordered_map<byte_t*, Sample> m_samples;
+	};
+
+	inline size_t ProfilingAllocator::GetSamplingInterval() const
+	{
+		return m_samplingInterval;
+	}
+}
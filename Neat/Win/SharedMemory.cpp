@@ -0,0 +1,35 @@
+#include "SharedMemory.h"
+#include "Neat\Win\Exception.h"
+
+namespace Neat::Win
+{
+	SharedMemory::SharedMemory(FileMapping&& mapping, FileView&& view, size_t size)
+		: m_mapping(std::move(mapping))
+		, m_view(std::move(view))
+		, m_size(size)
+	{
+	}
+
+	SharedMemory SharedMemory::Create(
+		LPCWSTR name,
+		size_t size,
+		LPSECURITY_ATTRIBUTES security)
+	{
+		auto mapping = FileMapping::Create(PAGE_READWRITE, size, name, security);
+		auto view = mapping.MapView(FILE_MAP_ALL_ACCESS, 0, size);
+		return { std::move(mapping), std::move(view), size };
+	}
+
+	SharedMemory SharedMemory::Open(LPCWSTR name)
+	{
+		auto mapping = FileMapping::Open(FILE_MAP_ALL_ACCESS, name);
+		auto view = mapping.MapView(FILE_MAP_ALL_ACCESS, 0, 0);
+
+		// Zero size maps the whole section, its size is known to the memory manager only
+		MEMORY_BASIC_INFORMATION info = { 0 };
+		if (0 == ::VirtualQuery(view.GetBase(), &info, sizeof(info)))
+			throw LastErrorException();
+
+		return { std::move(mapping), std::move(view), info.RegionSize };
+	}
+}
@@ -0,0 +1,58 @@
+#pragma once
+#include "Neat\Types.h"
+#include "Neat\Win\File.h"
+
+#include <Windows.h>
+
+namespace Neat::Win
+{
+	//
+	// Named region backed by the paging file, which cooperating processes map by its name.
+	// The region is zero filled when created and lives until the last process unmaps it.
+	// Views land at different addresses in every process, SharedAllocator hands out blocks in it.
+	//
+
+	class SharedMemory
+	{
+	public:
+		// Creates the region, or opens existing one of the same name
+		static SharedMemory Create(
+			LPCWSTR name,
+			size_t size,
+			LPSECURITY_ATTRIBUTES security = nullptr);
+
+		// Opens region created by another process, throws when there is none
+		static SharedMemory Open(LPCWSTR name);
+
+		SharedMemory(SharedMemory&& other) = default;
+		SharedMemory& operator=(SharedMemory&& other) = default;
+
+		byte_t* GetBase();
+		const byte_t* GetBase() const;
+		// Size of an opened region is rounded up to whole pages
+		size_t GetSize() const;
+
+	private:
+		SharedMemory(FileMapping&& mapping, FileView&& view, size_t size);
+
+	private:
+		FileMapping m_mapping;
+		FileView m_view;
+		size_t m_size;
+	};
+
+	inline byte_t* SharedMemory::GetBase()
+	{
+		return m_view.GetBase();
+	}
+
+	inline const byte_t* SharedMemory::GetBase() const
+	{
+		return m_view.GetBase();
+	}
+
+	inline size_t SharedMemory::GetSize() const
+	{
+		return m_size;
+	}
+}
@@ -0,0 +1,85 @@
+#include "Allocators.h"
+
+#include <Neat\ArenaAllocator.h>
+#include <Neat\DefaultAllocator.h>
+#include <Neat\FallbackAllocator.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\PoolAllocator.h>
+#include <Neat\SegregatorAllocator.h>
+#include <Neat\StackAllocator.h>
+#include <Neat\StatsAllocator.h>
+#include <Neat\ThreadCachingAllocator.h>
+#include <Neat\TlsfAllocator.h>
+#include <Neat\Win\PageAllocator.h>
+#include <Neat\Win\ProfilingAllocator.h>
+
+namespace Neat::Benchmarks
+{
+	std::vector<AllocatorFactory> GetAllocatorFactories()
+	{
+		return
+		{
+			{ "DefaultAllocator", true, false, [](AllocatorStack& stack)
+				{
+					stack.Add<DefaultAllocator>();
+				} },
+			{ "MallocAllocator", true, false, [](AllocatorStack& stack)
+				{
+					stack.Add<MallocAllocator>();
+				} },
+			{ "StackAllocator<1 MB>", false, true, [](AllocatorStack& stack)
+				{
+					stack.Add<StackAllocator<1_MB>>();
+				} },
+			{ "FallbackAllocator(Stack<1 MB>, Malloc)", false, false, [](AllocatorStack& stack)
+				{
+					const auto primary = stack.Add<StackAllocator<1_MB>>();
+					const auto fallback = stack.Add<MallocAllocator>();
+					stack.Add<FallbackAllocator>(primary, fallback);
+				} },
+			{ "FallbackAllocator(Pool, Malloc)", false, false, [](AllocatorStack& stack)
+				{
+					const auto primary = stack.Add<PoolAllocator>();
+					const auto fallback = stack.Add<MallocAllocator>();
+					stack.Add<FallbackAllocator>(primary, fallback);
+				} },
+			{ "SegregatorAllocator<4 kB>(Pool, Malloc)", false, false, [](AllocatorStack& stack)
+				{
+					const auto small = stack.Add<PoolAllocator>();
+					const auto large = stack.Add<MallocAllocator>();
+					stack.Add<SegregatorAllocator<4_kB>>(small, large);
+				} },
+			{ "FallbackAllocator(Tlsf<64 MB>, Malloc)", false, false, [](AllocatorStack& stack)
+				{
+					const auto primary = stack.Add<TlsfAllocator>(64_MB);
+					const auto fallback = stack.Add<MallocAllocator>();
+					stack.Add<FallbackAllocator>(primary, fallback);
+				} },
+			{ "ArenaAllocator", false, false, [](AllocatorStack& stack)
+				{
+					stack.Add<ArenaAllocator>(64_kB);
+				} },
+			{ "ThreadCachingAllocator(Malloc)", true, false, [](AllocatorStack& stack)
+				{
+					const auto backing = stack.Add<MallocAllocator>();
+					stack.Add<ThreadCachingAllocator>(backing);
+				} },
+			{ "SegregatorAllocator<64 kB>(Malloc, Page)", true, false, [](AllocatorStack& stack)
+				{
+					const auto small = stack.Add<MallocAllocator>();
+					const auto large = stack.Add<Win::PageAllocator>();
+					stack.Add<SegregatorAllocator<64_kB>>(small, large);
+				} },
+			{ "StatsAllocator(Malloc)", true, false, [](AllocatorStack& stack)
+				{
+					const auto allocator = stack.Add<MallocAllocator>();
+					stack.Add<StatsAllocator>(allocator);
+				} },
+			{ "ProfilingAllocator(Malloc)", true, false, [](AllocatorStack& stack)
+				{
+					const auto allocator = stack.Add<MallocAllocator>();
+					stack.Add<Win::ProfilingAllocator>(allocator);
+				} },
+		};
+	}
+}
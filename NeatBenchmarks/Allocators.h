@@ -0,0 +1,10 @@
+#pragma once
+#include "Benchmark.h"
+
+#include <vector>
+
+namespace Neat::Benchmarks
+{
+	// Every IAllocator implementation, alone or in the stack it's meant for
+	std::vector<AllocatorFactory> GetAllocatorFactories();
+}
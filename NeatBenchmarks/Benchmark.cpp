@@ -0,0 +1,99 @@
+#include "Benchmark.h"
+#include "Platform.h"
+
+#include <algorithm>
+
+namespace Neat::Benchmarks
+{
+	LatencyRecorder::LatencyRecorder(size_t capacity) :
+		m_failures(0),
+		m_sorted(true)
+	{
+		m_latencies.reserve(capacity);
+	}
+
+	void LatencyRecorder::AddFailure()
+	{
+		m_failures++;
+	}
+
+	void LatencyRecorder::Merge(const LatencyRecorder& other)
+	{
+		m_latencies.insert(m_latencies.end(), other.m_latencies.begin(), other.m_latencies.end());
+		m_failures += other.m_failures;
+		m_sorted = false;
+	}
+
+	size_t LatencyRecorder::GetCount() const
+	{
+		return m_latencies.size();
+	}
+
+	size_t LatencyRecorder::GetFailures() const
+	{
+		return m_failures;
+	}
+
+	int64_t LatencyRecorder::GetPercentile(double percentile)
+	{
+		if (m_latencies.empty())
+			return 0;
+
+		if (!m_sorted)
+		{
+			std::sort(m_latencies.begin(), m_latencies.end());
+			m_sorted = true;
+		}
+
+		const auto index = static_cast<size_t>(percentile / 100.0 * static_cast<double>(m_latencies.size() - 1));
+		return m_latencies[index];
+	}
+
+	AllocatorStack::~AllocatorStack()
+	{
+		while (!m_parts.empty())
+			m_parts.pop_back();
+	}
+
+	IAllocator* AllocatorStack::GetTop() const
+	{
+		return m_parts.empty() ? nullptr : m_parts.back().get();
+	}
+
+	double Result::GetOpsPerSecond() const
+	{
+		return (seconds > 0.0) ? static_cast<double>(operations) / seconds : 0.0;
+	}
+
+	Result Run(const Workload& workload, const AllocatorFactory& factory)
+	{
+		using namespace std::chrono;
+
+		Result result = {};
+		result.workload = workload.name;
+		result.allocator = factory.name;
+
+		LatencyRecorder recorder;
+		const auto baseline = GetWorkingSet();
+		{
+			AllocatorStack stack;
+			factory.build(stack);
+
+			const auto start = steady_clock::now();
+			workload.run(*stack.GetTop(), recorder);
+			const auto end = steady_clock::now();
+
+			// Measured before the stack releases what it holds
+			const auto rss = GetWorkingSet();
+			result.rssBytes = (rss > baseline) ? rss - baseline : 0;
+			result.seconds = duration_cast<duration<double>>(end - start).count();
+		}
+
+		result.operations = recorder.GetCount();
+		result.failures = recorder.GetFailures();
+		result.p50 = recorder.GetPercentile(50.0);
+		result.p99 = recorder.GetPercentile(99.0);
+		result.p999 = recorder.GetPercentile(99.9);
+		return result;
+	}
+}
@@ -0,0 +1,116 @@
+#pragma once
+#include <Neat\Allocator.h>
+
+#include <chrono>
+#include <functional>
+#include <memory>
+#include <vector>
+
+namespace Neat::Benchmarks
+{
+	//
+	// Collects latencies of individual operations, one recorder per thread.
+	//
+
+	class LatencyRecorder
+	{
+	public:
+		explicit LatencyRecorder(size_t capacity = 0);
+
+		// Times the call, allocation failures are counted separately
+		template <typename F>
+		void Measure(F f);
+		void AddFailure();
+		void Merge(const LatencyRecorder& other);
+
+		size_t GetCount() const;
+		size_t GetFailures() const;
+		// Percentile in [0, 100] of recorded latencies in nanoseconds
+		int64_t GetPercentile(double percentile);
+
+	private:
+		std::vector<int64_t> m_latencies;
+		size_t m_failures;
+		bool m_sorted;
+	};
+
+	//
+	// Owns allocators of a stack, the last added one is the top which workloads use.
+	// Parts are destroyed in reverse order, so wrappers go before what they wrap.
+	//
+
+	class AllocatorStack
+	{
+	public:
+		AllocatorStack() = default;
+		AllocatorStack(const AllocatorStack& other) = delete;
+		AllocatorStack& operator=(const AllocatorStack& other) = delete;
+		~AllocatorStack();
+
+		template <typename T, typename... Args>
+		T* Add(Args&&... args);
+
+		IAllocator* GetTop() const;
+
+	private:
+		std::vector<std::unique_ptr<IAllocator>> m_parts;
+	};
+
+	struct AllocatorFactory
+	{
+		const char* name;
+		// Only thread safe stacks run multi-threaded workloads
+		bool threadSafe;
+		// Bounded stacks can run out of memory
+		bool bounded;
+		std::function<void(AllocatorStack&)> build;
+	};
+
+	struct Workload
+	{
+		const char* name;
+		bool multiThreaded;
+		// BufferT and StringT don't survive allocation failures, so bounded stacks skip these
+		bool usesBuffers;
+		std::function<void(IAllocator&, LatencyRecorder&)> run;
+	};
+
+	struct Result
+	{
+		const char* workload;
+		const char* allocator;
+		size_t operations;
+		size_t failures;
+		double seconds;
+		// Growth of the working set while the allocator stack was alive
+		size_t rssBytes;
+		int64_t p50;
+		int64_t p99;
+		int64_t p999;
+
+		double GetOpsPerSecond() const;
+	};
+
+	// Builds a fresh stack for the workload and measures it
+	Result Run(const Workload& workload, const AllocatorFactory& factory);
+
+	template <typename F>
+	void LatencyRecorder::Measure(F f)
+	{
+		using namespace std::chrono;
+		const auto start = steady_clock::now();
+		f();
+		const auto end = steady_clock::now();
+		m_latencies.push_back(duration_cast<nanoseconds>(end - start).count());
+		m_sorted = false;
+	}
+
+	template <typename T, typename... Args>
+	T* AllocatorStack::Add(Args&&... args)
+	{
+		auto part = std::make_unique<T>(std::forward<Args>(args)...);
+		const auto p = part.get();
+		m_parts.push_back(std::move(part));
+		return p;
+	}
+}
@@ -0,0 +1,153 @@
+#include "Handoff.h"
+
+#include <Neat\SharedAllocator.h>
+#include <Neat\Utf.h>
+#include <Neat\Win\Exception.h>
+#include <Neat\Win\Handle.h>
+#include <Neat\Win\SharedMemory.h>
+
+#include <atomic>
+#include <chrono>
+#include <cstdlib>
+#include <thread>
+
+namespace Neat::Benchmarks
+{
+	namespace
+	{
+		constexpr size_t RegionSize = 64_MB;
+		constexpr uint32_t Count = 1000000;
+
+		//
+		// Single producer single consumer queue of block offsets, it lives in the shared region.
+		// Indexes only grow, head and tail sit on separate cache lines.
+		//
+
+		struct Channel
+		{
+			static constexpr uint32_t Capacity = 4096;
+
+			alignas(64) std::atomic<uint32_t> head;
+			alignas(64) std::atomic<uint32_t> tail;
+			alignas(64) std::atomic<uint32_t> done;
+			uint32_t offsets[Capacity];
+		};
+
+		// Payload starts with its sequence number and size, the rest is filled with the low byte of the number
+		struct Payload
+		{
+			uint32_t sequence;
+			uint32_t size;
+		};
+
+		Utf16 GetRegionName(unsigned long producerId)
+		{
+			return Utf16::Format(L"Local\\NeatBenchmarks.Handoff.%lu", producerId);
+		}
+
+		Win::Handle StartConsumer()
+		{
+			wchar_t program[MAX_PATH];
+			if (0 == ::GetModuleFileNameW(nullptr, program, _countof(program)))
+				throw Win::LastErrorException();
+
+			auto commandLine = Utf16::Format(L"\"%ls\" handoff-consumer %lu", program, ::GetCurrentProcessId());
+			STARTUPINFOW startup = { sizeof(startup) };
+			PROCESS_INFORMATION info = { 0 };
+			if (!::CreateProcessW(program, commandLine.GetString(), nullptr, nullptr, FALSE, 0, nullptr, nullptr, &startup, &info))
+				throw Win::LastErrorException();
+
+			::CloseHandle(info.hThread);
+			return info.hProcess;
+		}
+	}
+
+	int RunHandoff()
+	{
+		auto memory = Win::SharedMemory::Create(GetRegionName(::GetCurrentProcessId()), RegionSize);
+		SharedAllocator alloc(memory.GetBase(), memory.GetSize());
+
+		// The first block follows the header, so it's cache line aligned
+		const auto channel = reinterpret_cast<Channel*>(alloc.Allocate(sizeof(Channel)));
+		memset(channel, 0, sizeof(Channel));
+		alloc.SetRoot(alloc.GetOffset(reinterpret_cast<byte_t*>(channel)));
+
+		auto consumer = StartConsumer();
+
+		size_t stalls = 0;
+		const auto start = std::chrono::steady_clock::now();
+		for (uint32_t i = 0; i < Count; i++)
+		{
+			// Sizes from 64 bytes to 4 kB
+			const auto size = 64u << (i % 7);
+			auto p = alloc.Allocate(size);
+			while (!p || i - channel->head.load(std::memory_order_acquire) == Channel::Capacity)
+			{
+				// Region or queue is full until the consumer catches up
+				stalls++;
+				std::this_thread::yield();
+				if (!p)
+					p = alloc.Allocate(size);
+			}
+
+			const auto payload = reinterpret_cast<Payload*>(p);
+			payload->sequence = i;
+			payload->size = size;
+			memset(p + sizeof(Payload), static_cast<int>(i & 0xFF), size - sizeof(Payload));
+
+			channel->offsets[i % Channel::Capacity] = static_cast<uint32_t>(alloc.GetOffset(p));
+			channel->tail.store(i + 1, std::memory_order_release);
+		}
+		channel->done.store(1, std::memory_order_release);
+
+		::WaitForSingleObject(consumer, INFINITE);
+		const auto elapsed = std::chrono::duration<double>(std::chrono::steady_clock::now() - start).count();
+
+		DWORD exitCode = 1;
+		::GetExitCodeProcess(consumer, &exitCode);
+
+		printf("%-18s %-42s %12.0f %9zu %10zu\n",
+			"handoff",
+			"SharedAllocator(SharedMemory<64 MB>)",
+			Count / elapsed,
+			stalls,
+			alloc.GetReserved() / 1024);
+		if (0 != exitCode)
+			printf("Consumer failed with %lu\n", exitCode);
+		return static_cast<int>(exitCode);
+	}
+
+	int RunHandoffConsumer(const char* producerId)
+	{
+		auto memory = Win::SharedMemory::Open(GetRegionName(strtoul(producerId, nullptr, 10)));
+		SharedAllocator alloc(memory.GetBase(), memory.GetSize());
+		const auto channel = reinterpret_cast<Channel*>(alloc.GetPointer(alloc.GetRoot()));
+
+		uint32_t errors = 0;
+		uint32_t head = 0;
+		for (;;)
+		{
+			// Done is checked before the tail, so the last payloads aren't missed
+			const auto done = channel->done.load(std::memory_order_acquire);
+			const auto tail = channel->tail.load(std::memory_order_acquire);
+			if (head == tail)
+			{
+				if (done)
+					break;
+				std::this_thread::yield();
+				continue;
+			}
+
+			for (; head != tail; head++)
+			{
+				const auto p = alloc.GetPointer(channel->offsets[head % Channel::Capacity]);
+				const auto payload = reinterpret_cast<const Payload*>(p);
+				if (payload->sequence != head || p[payload->size - 1] != static_cast<byte_t>(head & 0xFF))
+					errors++;
+				alloc.Deallocate(p, payload->size);
+			}
+			channel->head.store(head, std::memory_order_release);
+		}
+		return (Count == head && 0 == errors) ? 0 : 2;
+	}
+}
@@ -0,0 +1,10 @@
+#pragma once
+
+namespace Neat::Benchmarks
+{
+	// Producer allocates payloads in a shared region and hands their offsets over to a child
+	// process, which reads and frees them. Spawns the consumer by running the program again.
+	int RunHandoff();
+	// Entry of the child process, attaches to the region of the producer with given process id
+	int RunHandoffConsumer(const char* producerId);
+}
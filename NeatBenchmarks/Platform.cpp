@@ -0,0 +1,18 @@
+#include "Platform.h"
+
+#include <Windows.h>
+#include <Psapi.h>
+
+#pragma comment(lib, "Psapi.lib")
+
+namespace Neat::Benchmarks
+{
+	size_t GetWorkingSet()
+	{
+		PROCESS_MEMORY_COUNTERS counters = {};
+		counters.cb = sizeof(counters);
+		if (!::GetProcessMemoryInfo(::GetCurrentProcess(), &counters, sizeof(counters)))
+			return 0;
+		return counters.WorkingSetSize;
+	}
+}
@@ -0,0 +1,13 @@
+#pragma once
+#include <cstddef>
+
+namespace Neat::Benchmarks
+{
+	//
+	// Services of the operating system which the benchmarks need. Only Platform.cpp and
+	// the cross-process Handoff depend on Windows, workloads and their runner are plain C++.
+	//
+
+	// Returns resident set size of this process in bytes, zero when it's unknown
+	size_t GetWorkingSet();
+}
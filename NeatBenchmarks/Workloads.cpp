@@ -0,0 +1,183 @@
+#include "Workloads.h"
+
+#include <Neat\Buffer.h>
+#include <Neat\Utf.h>
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace Neat::Benchmarks
+{
+	namespace
+	{
+		// Blocks remember their size, so any slot or thread can free them
+		struct Block
+		{
+			byte_t* p;
+			size_t size;
+		};
+
+		void Allocate(IAllocator& alloc, LatencyRecorder& recorder, Block& block, size_t size)
+		{
+			recorder.Measure([&]() { block.p = alloc.Allocate(size); });
+			block.size = size;
+			if (!block.p)
+			{
+				recorder.AddFailure();
+				return;
+			}
+
+			// Touched memory counts into the working set
+			memset(block.p, 0xAB, size);
+		}
+
+		void Deallocate(IAllocator& alloc, LatencyRecorder& recorder, Block& block)
+		{
+			if (!block.p)
+				return;
+
+			recorder.Measure([&]() { alloc.Deallocate(block.p, block.size); });
+			block.p = nullptr;
+		}
+
+		// Blocks of the same size are freed and allocated again in FIFO order
+		void FixedChurn(IAllocator& alloc, LatencyRecorder& recorder)
+		{
+			const auto count = 1000000;
+			std::vector<Block> blocks(1024);
+			for (auto i = 0; i < count; i++)
+			{
+				auto& block = blocks[i % blocks.size()];
+				Deallocate(alloc, recorder, block);
+				Allocate(alloc, recorder, block, 64);
+			}
+
+			for (auto& block : blocks)
+				Deallocate(alloc, recorder, block);
+		}
+
+		// Sizes from 8 bytes to 16 kB, smaller ones are more frequent, lifetimes are random
+		void RandomSizes(IAllocator& alloc, LatencyRecorder& recorder)
+		{
+			const auto count = 500000;
+			std::mt19937 random(42);
+			std::uniform_int_distribution<size_t> bits(3, 13);
+			std::vector<Block> blocks(4096);
+			for (auto i = 0; i < count; i++)
+			{
+				const auto base = 1_sz << bits(random);
+				const auto size = base + random() % base;
+				auto& block = blocks[random() % blocks.size()];
+				Deallocate(alloc, recorder, block);
+				Allocate(alloc, recorder, block, size);
+			}
+
+			for (auto& block : blocks)
+				Deallocate(alloc, recorder, block);
+		}
+
+		// Blocks are allocated by producer threads and freed by consumer threads
+		void ProducerConsumer(IAllocator& alloc, LatencyRecorder& recorder)
+		{
+			const auto threadCount = 2;
+			const auto countPerThread = 250000;
+			const auto maxQueueSize = 4096_sz;
+
+			std::mutex mutex;
+			std::condition_variable notFull;
+			std::condition_variable notEmpty;
+			std::deque<Block> queue;
+			auto producing = threadCount;
+
+			std::vector<LatencyRecorder> recorders(2 * threadCount);
+			std::vector<std::thread> threads;
+			for (auto t = 0; t < threadCount; t++)
+			{
+				threads.emplace_back([&, t]()
+				{
+					auto& local = recorders[t];
+					std::mt19937 random(t);
+					for (auto i = 0; i < countPerThread; i++)
+					{
+						Block block = {};
+						Allocate(alloc, local, block, 16 + random() % 1008);
+						if (!block.p)
+							continue;
+
+						std::unique_lock<std::mutex> lock(mutex);
+						notFull.wait(lock, [&]() { return queue.size() < maxQueueSize; });
+						queue.push_back(block);
+						notEmpty.notify_one();
+					}
+
+					std::lock_guard<std::mutex> lock(mutex);
+					producing--;
+					notEmpty.notify_all();
+				});
+
+				threads.emplace_back([&, t]()
+				{
+					auto& local = recorders[threadCount + t];
+					for (;;)
+					{
+						std::unique_lock<std::mutex> lock(mutex);
+						notEmpty.wait(lock, [&]() { return !queue.empty() || 0 == producing; });
+						if (queue.empty())
+							return;
+
+						auto block = queue.front();
+						queue.pop_front();
+						notFull.notify_one();
+						lock.unlock();
+
+						Deallocate(alloc, local, block);
+					}
+				});
+			}
+
+			for (auto& thread : threads)
+				thread.join();
+			for (const auto& local : recorders)
+				recorder.Merge(local);
+		}
+
+		// Buffers grow by small appends, as when a stream is read into memory
+		void BufferAppend(IAllocator& alloc, LatencyRecorder& recorder)
+		{
+			byte_t chunk[64];
+			memset(chunk, 0xCD, sizeof(chunk));
+			for (auto i = 0; i < 1000; i++)
+			{
+				Buffer buffer(&alloc);
+				for (auto j = 0; j < 1024; j++)
+					recorder.Measure([&]() { buffer.Append(chunk, sizeof(chunk)); });
+			}
+		}
+
+		// Strings are built up from short pieces, as by a formatter
+		void StringAppend(IAllocator& alloc, LatencyRecorder& recorder)
+		{
+			for (auto i = 0; i < 2000; i++)
+			{
+				Utf8 string(&alloc);
+				for (auto j = 0; j < 256; j++)
+					recorder.Measure([&]() { string += "0123456789abcdef"; });
+			}
+		}
+	}
+
+	std::vector<Workload> GetWorkloads()
+	{
+		return
+		{
+			{ "fixed-churn", false, false, FixedChurn },
+			{ "random-sizes", false, false, RandomSizes },
+			{ "producer-consumer", true, false, ProducerConsumer },
+			{ "buffer-append", false, true, BufferAppend },
+			{ "string-append", false, true, StringAppend },
+		};
+	}
+}
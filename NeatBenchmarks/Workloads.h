@@ -0,0 +1,10 @@
+#pragma once
+#include "Benchmark.h"
+
+#include <vector>
+
+namespace Neat::Benchmarks
+{
+	// Standard workloads, all of them are deterministic so runs are comparable
+	std::vector<Workload> GetWorkloads();
+}
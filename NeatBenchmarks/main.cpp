@@ -0,0 +1,62 @@
+#include "Allocators.h"
+#include "Handoff.h"
+#include "Workloads.h"
+
+#include <cstring>
+
+using namespace Neat::Benchmarks;
+
+namespace
+{
+	// Names are matched by substring, no filter matches everything
+	bool Matches(const char* name, const char* filter)
+	{
+		return !filter || strstr(name, filter);
+	}
+}
+
+// Usage: NeatBenchmarks [workload filter] [allocator filter]
+//        NeatBenchmarks handoff
+int main(int argc, const char* argv[])
+{
+	// Cross-process hand-off runs apart, it needs the program to spawn itself
+	if (argc > 1 && 0 == strcmp(argv[1], "handoff"))
+		return RunHandoff();
+	if (argc > 2 && 0 == strcmp(argv[1], "handoff-consumer"))
+		return RunHandoffConsumer(argv[2]);
+
+	const auto workloadFilter = (argc > 1) ? argv[1] : nullptr;
+	const auto allocatorFilter = (argc > 2) ? argv[2] : nullptr;
+
+	printf("%-18s %-42s %12s %9s %10s %9s %9s %9s\n",
+		"workload", "allocator", "ops/s", "failures", "rss kB", "p50 ns", "p99 ns", "p99.9 ns");
+
+	for (const auto& workload : GetWorkloads())
+	{
+		if (!Matches(workload.name, workloadFilter))
+			continue;
+
+		for (const auto& factory : GetAllocatorFactories())
+		{
+			if (!Matches(factory.name, allocatorFilter) ||
+				(workload.multiThreaded && !factory.threadSafe) ||
+				(workload.usesBuffers && factory.bounded))
+			{
+				continue;
+			}
+
+			const auto result = Run(workload, factory);
+			printf("%-18s %-42s %12.0f %9zu %10zu %9lld %9lld %9lld\n",
+				result.workload,
+				result.allocator,
+				result.GetOpsPerSecond(),
+				result.failures,
+				result.rssBytes / 1024,
+				static_cast<long long>(result.p50),
+				static_cast<long long>(result.p99),
+				static_cast<long long>(result.p999));
+			fflush(stdout);
+		}
+	}
+	return 0;
+}
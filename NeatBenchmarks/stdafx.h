@@ -0,0 +1,13 @@
+#pragma once
+#include "targetver.h"
+
+// STL headers
+#include <cstdio>
+#include <exception>
+#include <string>
+
+// Exclude rarely-used stuff from Windows headers
+#define WIN32_LEAN_AND_MEAN
+
+// Windows headers
+#include <Windows.h>
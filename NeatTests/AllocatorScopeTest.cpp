@@ -0,0 +1,122 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\AllocatorScope.h>
+#include <Neat\ArenaAllocator.h>
+#include <Neat\Buffer.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\Utf.h>
+
+#include <thread>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(AllocatorScopeTest)
+	{
+	public:
+		TEST_METHOD(AllocatorScope_Basic)
+		{
+			ArenaAllocator arena;
+			Assert::IsNull(AllocatorScope::GetCurrent());
+			{
+				AllocatorScope scope(&arena);
+				Assert::IsTrue(&arena == AllocatorScope::GetCurrent());
+
+				Buffer buffer(100);
+				Utf16 string(L"text");
+				Assert::IsTrue(&arena == buffer.GetAllocator());
+				Assert::IsTrue(&arena == string.GetAllocator());
+				Assert::IsTrue(arena.Owns(buffer.GetBuffer(), buffer.GetSize()));
+
+				// Explicit allocator wins over the scope
+				MallocAllocator malloc;
+				Buffer other(10, &malloc);
+				Assert::IsTrue(&malloc == other.GetAllocator());
+			}
+			Assert::IsNull(AllocatorScope::GetCurrent());
+
+			Buffer buffer(10);
+			Assert::IsNull(buffer.GetAllocator());
+		}
+
+		TEST_METHOD(AllocatorScope_Nested)
+		{
+			ArenaAllocator outer;
+			MallocAllocator inner;
+			AllocatorScope first(&outer);
+			{
+				AllocatorScope second(&inner);
+				Assert::IsTrue(&inner == AllocatorScope::GetCurrent());
+				{
+					AllocatorScope third(nullptr);
+					Buffer buffer(10);
+					Assert::IsNull(buffer.GetAllocator());
+				}
+				Assert::IsTrue(&inner == AllocatorScope::GetCurrent());
+			}
+			Assert::IsTrue(&outer == AllocatorScope::GetCurrent());
+		}
+
+		TEST_METHOD(AllocatorScope_Temporaries)
+		{
+			ArenaAllocator arena;
+			Utf16 string(L"one two three");
+			AllocatorScope scope(&arena);
+
+			// Objects keep the allocator they were constructed with
+			Utf16 copy(string);
+			Assert::IsTrue(&arena == copy.GetAllocator());
+			Assert::IsNull(string.GetAllocator());
+
+			const auto used = arena.GetUsed();
+			const auto word = string.Substring(4, 3);
+			Assert::AreEqual(L"two", word);
+			Assert::IsTrue(&arena == word.GetAllocator());
+			Assert::IsTrue(arena.GetUsed() > used);
+		}
+
+		TEST_METHOD(AllocatorScope_MovedFrom)
+		{
+			Utf16 string(L"text");
+			Buffer buffer(10);
+			{
+				ArenaAllocator arena;
+				AllocatorScope scope(&arena);
+				const auto movedString = std::move(string);
+				const auto movedBuffer = std::move(buffer);
+				Assert::IsNull(movedString.GetAllocator());
+				Assert::IsNull(movedBuffer.GetAllocator());
+			}
+
+			// Moved-from objects don't pick up the scope, which is gone when they are reused
+			Assert::IsNull(string.GetAllocator());
+			Assert::IsNull(buffer.GetAllocator());
+			string = L"reused";
+			buffer.Allocate(20);
+			Assert::AreEqual(L"reused", string);
+			Assert::AreEqual(20_sz, buffer.GetSize());
+		}
+
+		TEST_METHOD(AllocatorScope_Threads)
+		{
+			ArenaAllocator arena;
+			AllocatorScope scope(&arena);
+
+			IAllocator* current = &arena;
+			IAllocator* allocator = &arena;
+			std::thread thread([&]()
+			{
+				current = AllocatorScope::GetCurrent();
+				Buffer buffer(10);
+				allocator = buffer.GetAllocator();
+			});
+			thread.join();
+
+			Assert::IsNull(current);
+			Assert::IsNull(allocator);
+		}
+	};
+}
@@ -0,0 +1,178 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\ArenaAllocator.h>
+#include <Neat\Buffer.h>
+#include <Neat\MallocAllocator.h>
+
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(ArenaAllocatorTest)
+	{
+	public:
+		TEST_METHOD(ArenaAllocator_Basic)
+		{
+			ArenaAllocator alloc(256);
+			Assert::AreEqual(0_sz, alloc.GetBlockCount());
+
+			auto first = alloc.Allocate(10);
+			auto second = alloc.Allocate(10);
+			Assert::IsNotNull(first);
+			Assert::IsNotNull(second);
+			Assert::IsTrue(alloc.Owns(first, 10));
+			Assert::IsTrue(alloc.Owns(second, 10));
+			Assert::IsTrue(second == first + ArenaAllocator::Alignment);
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(first) % ArenaAllocator::Alignment);
+			Assert::AreEqual(2 * ArenaAllocator::Alignment, alloc.GetUsed());
+			Assert::AreEqual(1_sz, alloc.GetBlockCount());
+
+			alloc.Deallocate(second, 10);
+			Assert::IsTrue(alloc.Owns(second, 10));
+			Assert::AreEqual(2 * ArenaAllocator::Alignment, alloc.GetUsed());
+		}
+
+		TEST_METHOD(ArenaAllocator_Grow)
+		{
+			ArenaAllocator alloc(256);
+			std::vector<byte_t*> blocks;
+			for (auto i = 0; i < 100; i++)
+			{
+				auto p = alloc.Allocate(64);
+				Assert::IsNotNull(p);
+				memset(p, i, 64);
+				blocks.push_back(p);
+			}
+			Assert::IsTrue(alloc.GetBlockCount() > 1);
+			Assert::IsTrue(alloc.GetBlockCount() < 10);
+			for (auto i = 0; i < 100; i++)
+			{
+				Assert::IsTrue(alloc.Owns(blocks[i], 64));
+				Assert::AreEqual(i, static_cast<int>(blocks[i][63]));
+			}
+
+			auto large = alloc.Allocate(64_kB);
+			Assert::IsNotNull(large);
+			Assert::IsTrue(alloc.Owns(large, 64_kB));
+		}
+
+		TEST_METHOD(ArenaAllocator_Reset)
+		{
+			ArenaAllocator alloc(256);
+			for (auto i = 0; i < 100; i++)
+				alloc.Allocate(64);
+
+			const auto reserved = alloc.GetReserved();
+			alloc.Reset();
+			Assert::AreEqual(1_sz, alloc.GetBlockCount());
+			Assert::AreEqual(0_sz, alloc.GetUsed());
+			Assert::IsTrue(alloc.GetReserved() < reserved);
+
+			// The kept block is big enough to serve the same batch again
+			const auto kept = alloc.GetReserved();
+			for (auto i = 0; i < 50; i++)
+				alloc.Allocate(64);
+			Assert::AreEqual(1_sz, alloc.GetBlockCount());
+			Assert::AreEqual(kept, alloc.GetReserved());
+
+			alloc.Release();
+			Assert::AreEqual(0_sz, alloc.GetBlockCount());
+			Assert::AreEqual(0_sz, alloc.GetReserved());
+		}
+
+		TEST_METHOD(ArenaAllocator_Upstream)
+		{
+			MallocAllocator upstream;
+			ArenaAllocator alloc(1_kB, &upstream);
+			auto p = alloc.Allocate(100);
+			Assert::IsNotNull(p);
+			Assert::IsTrue(alloc.Owns(p, 100));
+			Assert::AreEqual(1_kB, alloc.GetReserved());
+		}
+
+		TEST_METHOD(ArenaAllocator_Buffer)
+		{
+			ArenaAllocator alloc;
+			{
+				Buffer buffer(&alloc);
+				for (auto i = 0; i < 10; i++)
+				{
+					const byte_t chunk[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+					buffer.Append(chunk, sizeof(chunk));
+				}
+				Assert::AreEqual(40_sz, buffer.GetSize());
+				Assert::IsTrue(alloc.Owns(buffer.GetBuffer(), buffer.GetSize()));
+				Assert::AreEqual(0xEF, static_cast<int>(buffer[39]));
+			}
+			Assert::IsTrue(alloc.GetUsed() > 0);
+
+			alloc.Reset();
+			Assert::AreEqual(0_sz, alloc.GetUsed());
+		}
+
+		TEST_METHOD(ArenaAllocator_Aligned)
+		{
+			ArenaAllocator alloc(256);
+			Assert::IsNotNull(alloc.Allocate(8));
+
+			for (auto alignment : { 8_sz, 64_sz, 128_sz, 1_kB })
+			{
+				auto p = alloc.AllocateAligned(40, alignment);
+				Assert::IsNotNull(p);
+				Assert::IsTrue(alloc.Owns(p, 40));
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % alignment);
+				alloc.DeallocateAligned(p, 40, alignment);
+			}
+		}
+
+		TEST_METHOD(ArenaAllocator_Expand)
+		{
+			ArenaAllocator alloc(1_kB);
+			auto p = alloc.Allocate(10);
+			Assert::IsTrue(alloc.TryExpand(p, 10, 500));
+			Assert::AreEqual(512_sz, alloc.GetUsed());
+			Assert::IsTrue(alloc.TryExpand(p, 500, 100));
+			Assert::AreEqual(112_sz, alloc.GetUsed());
+
+			// Only the most recent block can grow
+			auto q = alloc.Allocate(10);
+			Assert::IsFalse(alloc.TryExpand(p, 100, 200));
+			Assert::IsFalse(alloc.TryExpand(q, 10, 2_kB));
+
+			Buffer buffer(&alloc);
+			const byte_t chunk[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+			buffer.Append(chunk, sizeof(chunk));
+			const auto begin = buffer.GetBuffer();
+			for (auto i = 1; i < 100; i++)
+				buffer.Append(chunk, sizeof(chunk));
+			Assert::IsTrue(begin == buffer.GetBuffer());
+			Assert::AreEqual(400_sz, buffer.GetSize());
+			Assert::AreEqual(0xEF, static_cast<int>(buffer[399]));
+		}
+
+		TEST_METHOD(ArenaAllocator_Batch)
+		{
+			ArenaAllocator alloc(256);
+			Assert::IsNotNull(alloc.Allocate(100));
+			Assert::AreEqual(1_sz, alloc.GetBlockCount());
+
+			// Whole batch comes from one new block
+			const size_t sizes[] = { 10, 0, 100, 200 };
+			byte_t* blocks[_countof(sizes)];
+			Assert::IsTrue(alloc.AllocateBatch(sizes, _countof(sizes), blocks));
+			Assert::AreEqual(2_sz, alloc.GetBlockCount());
+			Assert::IsNull(blocks[1]);
+			Assert::IsTrue(blocks[2] == blocks[0] + 16);
+			Assert::IsTrue(blocks[3] == blocks[2] + 112);
+			Assert::AreEqual(112_sz + 16 + 112 + 208, alloc.GetUsed());
+			memset(blocks[3], 0xAB, 200);
+
+			alloc.DeallocateBatch(blocks, sizes, _countof(sizes));
+			Assert::IsTrue(alloc.Owns(blocks[3], 200));
+		}
+	};
+}
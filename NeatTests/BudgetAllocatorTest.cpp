@@ -0,0 +1,170 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\BudgetAllocator.h>
+#include <Neat\MallocAllocator.h>
+
+#include <chrono>
+#include <deque>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(BudgetAllocatorTest)
+	{
+	public:
+		TEST_METHOD(BudgetAllocator_Basic)
+		{
+			MallocAllocator malloc;
+			BudgetAllocator alloc(&malloc, 1_kB);
+			Assert::AreEqual(1_kB, alloc.GetBudget());
+
+			auto p = alloc.Allocate(600);
+			Assert::IsNotNull(p);
+			Assert::AreEqual(600_sz, alloc.GetUsed());
+
+			Assert::IsNull(alloc.Allocate(500));
+			Assert::IsNull(alloc.Allocate(2_kB));
+			Assert::AreEqual(2_sz, alloc.GetRejected());
+
+			auto q = alloc.Allocate(424);
+			Assert::IsNotNull(q);
+			Assert::AreEqual(1_kB, alloc.GetUsed());
+
+			alloc.Deallocate(p, 600);
+			alloc.Deallocate(q, 424);
+			Assert::AreEqual(0_sz, alloc.GetUsed());
+			Assert::AreEqual(1_kB, alloc.GetPeak());
+		}
+
+		TEST_METHOD(BudgetAllocator_Resize)
+		{
+			MallocAllocator malloc;
+			BudgetAllocator alloc(&malloc, 1_kB);
+			auto p = alloc.Allocate(100);
+			p[0] = 42;
+
+			auto q = alloc.Reallocate(p, 100, 800);
+			Assert::IsNotNull(q);
+			Assert::AreEqual(42, static_cast<int>(q[0]));
+			Assert::AreEqual(800_sz, alloc.GetUsed());
+
+			Assert::IsNull(alloc.Reallocate(q, 800, 2_kB));
+			Assert::AreEqual(800_sz, alloc.GetUsed());
+
+			q = alloc.Reallocate(q, 800, 200);
+			Assert::IsNotNull(q);
+			Assert::AreEqual(200_sz, alloc.GetUsed());
+			alloc.Deallocate(q, 200);
+
+			const size_t sizes[] = { 400, 400, 400 };
+			byte_t* blocks[_countof(sizes)];
+			Assert::IsFalse(alloc.AllocateBatch(sizes, _countof(sizes), blocks));
+			Assert::AreEqual(0_sz, alloc.GetUsed());
+			Assert::IsTrue(alloc.AllocateBatch(sizes, 2, blocks));
+			Assert::AreEqual(800_sz, alloc.GetUsed());
+			alloc.DeallocateBatch(blocks, sizes, 2);
+			Assert::AreEqual(0_sz, alloc.GetUsed());
+		}
+
+		TEST_METHOD(BudgetAllocator_Callback)
+		{
+			MallocAllocator malloc;
+			BudgetAllocator alloc(&malloc, 1_kB);
+
+			// Callback spills the oldest buffer to make room
+			std::deque<Buffer> buffers;
+			size_t calls = 0;
+			alloc.SetPressureCallback([&](BudgetAllocator& allocator, size_t bytes)
+			{
+				calls++;
+				if (buffers.empty())
+					return false;
+				buffers.pop_front();
+				return true;
+			});
+
+			for (auto i = 0; i < 10; i++)
+			{
+				Buffer buffer(400, &alloc);
+				Assert::AreEqual(400_sz, buffer.GetSize());
+				buffers.push_back(std::move(buffer));
+			}
+			Assert::AreEqual(2_sz, buffers.size());
+			Assert::AreEqual(8_sz, calls);
+			Assert::AreEqual(800_sz, alloc.GetUsed());
+			Assert::AreEqual(0_sz, alloc.GetRejected());
+
+			buffers.clear();
+			Assert::IsNull(alloc.Allocate(2_kB));
+			Assert::AreEqual(8_sz, calls);
+		}
+
+		TEST_METHOD(BudgetAllocator_Timeout)
+		{
+			using namespace std::chrono;
+			MallocAllocator malloc;
+			BudgetAllocator alloc(&malloc, 1_kB);
+			alloc.SetTimeout(milliseconds(50));
+
+			auto p = alloc.Allocate(1_kB);
+			auto start = steady_clock::now();
+			Assert::IsNull(alloc.Allocate(100));
+			Assert::IsTrue(steady_clock::now() - start >= milliseconds(50));
+
+			// Blocked request proceeds when another thread frees memory
+			alloc.SetTimeout(seconds(10));
+			std::thread thread([&]()
+			{
+				std::this_thread::sleep_for(milliseconds(20));
+				alloc.Deallocate(p, 1_kB);
+			});
+			start = steady_clock::now();
+			auto q = alloc.Allocate(100);
+			thread.join();
+			Assert::IsNotNull(q);
+			Assert::IsTrue(steady_clock::now() - start < seconds(10));
+			alloc.Deallocate(q, 100);
+		}
+
+		TEST_METHOD(BudgetAllocator_Threads)
+		{
+			MallocAllocator malloc;
+			// Threads hold up to 4 blocks, so they wait for each other but can't all get stuck
+			BudgetAllocator alloc(&malloc, 13_kB);
+			alloc.SetTimeout(std::chrono::seconds(10));
+
+			std::vector<std::thread> threads;
+			for (auto t = 0; t < 4; t++)
+			{
+				threads.emplace_back([&alloc]()
+				{
+					std::vector<byte_t*> blocks;
+					for (auto i = 0; i < 2000; i++)
+					{
+						blocks.push_back(alloc.Allocate(1_kB));
+						if (blocks.size() == 4)
+						{
+							for (auto block : blocks)
+								alloc.Deallocate(block, 1_kB);
+							blocks.clear();
+						}
+					}
+					for (auto block : blocks)
+						alloc.Deallocate(block, 1_kB);
+				});
+			}
+			for (auto& thread : threads)
+				thread.join();
+
+			Assert::AreEqual(0_sz, alloc.GetUsed());
+			Assert::IsTrue(alloc.GetPeak() <= 13_kB);
+			Assert::AreEqual(0_sz, alloc.GetRejected());
+		}
+	};
+}
@@ -0,0 +1,165 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\BufferChain.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\StackAllocator.h>
+#include <Neat\StatsAllocator.h>
+#include <Neat\Utf.h>
+
+#include <chrono>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(BufferChainTest)
+	{
+	public:
+		TEST_METHOD(BufferChain_Basic)
+		{
+			MallocAllocator malloc;
+			StatsAllocator alloc(&malloc);
+			BufferChain chain(&alloc, 8);
+			Assert::IsTrue(chain.IsEmpty());
+			Assert::AreEqual(0_sz, chain.GetSegmentCount());
+			Assert::IsTrue(&alloc == chain.GetAllocator());
+
+			const byte_t foo[] = { 1, 2, 3, 4, 5 };
+			Assert::IsTrue(chain.Append(foo, sizeof(foo)));
+			Assert::IsTrue(chain.Append(foo, sizeof(foo)));
+			Assert::IsTrue(chain.Append(Buffer(foo, sizeof(foo))));
+			Assert::AreEqual(15_sz, chain.GetSize());
+			Assert::AreEqual(2_sz, chain.GetSegmentCount());
+			Assert::AreEqual(2_sz, alloc.GetSnapshot().allocations);
+
+			// Segments are full except the last one
+			const auto segments = chain.GetSegments();
+			Assert::AreEqual(8_sz, segments[0].size);
+			Assert::AreEqual(7_sz, segments[1].size);
+			const byte_t expected[] = { 1, 2, 3, 4, 5, 1, 2, 3, 4, 5, 1, 2, 3, 4, 5 };
+			Assert::AreEqual(0, memcmp(expected, segments[0].data, 8));
+			Assert::AreEqual(0, memcmp(expected + 8, segments[1].data, 7));
+
+			// Large append spans several new segments
+			byte_t large[20] = { 0x42 };
+			Assert::IsTrue(chain.Append(large, sizeof(large)));
+			Assert::AreEqual(35_sz, chain.GetSize());
+			Assert::AreEqual(5_sz, chain.GetSegmentCount());
+			Assert::AreEqual(8_sz, chain.GetSegments()[1].size);
+			Assert::AreEqual(3_sz, chain.GetSegments()[4].size);
+
+			BufferChain moved(std::move(chain));
+			Assert::IsTrue(chain.IsEmpty());
+			Assert::AreEqual(0_sz, chain.GetSegmentCount());
+			Assert::AreEqual(35_sz, moved.GetSize());
+
+			moved.Clear();
+			Assert::AreEqual(0_sz, alloc.GetSnapshot().liveBytes);
+		}
+
+		TEST_METHOD(BufferChain_Flatten)
+		{
+			BufferChain chain(nullptr, 4);
+			Assert::IsNull(chain.GetBuffer());
+
+			const byte_t foo[] = { 1, 2, 3 };
+			for (auto i = 0; i < 5; i++)
+				chain.Append(foo, sizeof(foo));
+			Assert::AreEqual(4_sz, chain.GetSegmentCount());
+
+			// Contiguous view is made once
+			const IBuffer& buffer = chain;
+			const auto p = buffer.GetBuffer();
+			Assert::AreEqual(1_sz, chain.GetSegmentCount());
+			Assert::IsTrue(p == chain.GetBuffer());
+			Assert::AreEqual(15_sz, buffer.GetSize());
+			for (auto i = 0; i < 15; i++)
+				Assert::AreEqual(static_cast<int>(foo[i % 3]), static_cast<int>(p[i]));
+
+			// Appending continues in new segments
+			chain.Append(foo, sizeof(foo));
+			Assert::AreEqual(2_sz, chain.GetSegmentCount());
+			Assert::AreEqual(18_sz, chain.GetSize());
+			Assert::IsTrue(3 == chain.GetBuffer()[17]);
+		}
+
+		TEST_METHOD(BufferChain_Failure)
+		{
+			StackAllocator<64> alloc;
+			BufferChain chain(&alloc, 16);
+			byte_t bytes[80] = { 0 };
+			Assert::IsTrue(chain.Append(bytes, 24));
+
+			// Nothing is appended when not all segments fit
+			Assert::IsFalse(chain.Append(bytes, sizeof(bytes)));
+			Assert::AreEqual(24_sz, chain.GetSize());
+			Assert::AreEqual(2_sz, chain.GetSegmentCount());
+			Assert::AreEqual(32_sz, alloc.GetCapacity());
+
+			// Flattening needs another block, segments stay when it fails
+			Assert::IsTrue(chain.Append(bytes, 24));
+			Assert::IsNull(chain.Flatten());
+			Assert::AreEqual(3_sz, chain.GetSegmentCount());
+			Assert::AreEqual(48_sz, chain.GetSize());
+
+			// Contiguous view of the contents can't be null
+			const auto& view = chain;
+			Assert::ExpectException<std::bad_alloc>([&chain]() { chain.GetBuffer(); });
+			Assert::ExpectException<std::bad_alloc>([&view]() { view.GetBuffer(); });
+			Assert::AreEqual(3_sz, chain.GetSegmentCount());
+		}
+
+		TEST_METHOD(BufferChain_Performance)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto total = 16_MB;
+			const auto piece = 100_sz;
+			std::vector<byte_t> bytes(piece, 0x42);
+			{
+				MallocAllocator malloc;
+				StatsAllocator alloc(&malloc);
+				const auto start = steady_clock::now();
+				Buffer buffer(&alloc);
+				for (size_t i = 0; i < total; i += piece)
+					buffer.Append(bytes.data(), piece);
+				const auto end = steady_clock::now();
+				const auto duration = duration_cast<microseconds>(end - start).count();
+				const auto message = Utf16::Format(
+					L"# %Iu bytes appended to Buffer in %Iu byte pieces took %llu microseconds, %Iu allocated bytes",
+					total,
+					piece,
+					duration,
+					alloc.GetSnapshot().allocatedBytes);
+				Logger::WriteMessage(message);
+			}
+			{
+				MallocAllocator malloc;
+				StatsAllocator alloc(&malloc);
+				const auto start = steady_clock::now();
+				BufferChain chain(&alloc, 64_kB);
+				for (size_t i = 0; i < total; i += piece)
+					chain.Append(bytes.data(), piece);
+				const auto end = steady_clock::now();
+				const auto duration = duration_cast<microseconds>(end - start).count();
+				const auto message = Utf16::Format(
+					L"# %Iu bytes appended to BufferChain in %Iu byte pieces took %llu microseconds, %Iu allocated bytes",
+					total,
+					piece,
+					duration,
+					alloc.GetSnapshot().allocatedBytes);
+				Logger::WriteMessage(message);
+
+				// Every byte is copied once into segments of fixed size
+				Assert::IsTrue(chain.GetSize() >= total);
+				Assert::AreEqual((chain.GetSize() + 64_kB - 1) / 64_kB, alloc.GetSnapshot().allocations);
+			}
+			Logger::WriteMessage(L"#");
+		}
+	};
+}
@@ -1,7 +1,14 @@
 #include <CppUnitTest.h>
 
+#include <Neat\ArenaAllocator.h>
 #include <Neat\Buffer.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\PoolAllocator.h>
 #include <Neat\StackAllocator.h>
+#include <Neat\StatsAllocator.h>
+#include <Neat\Utf.h>
+
+#include <chrono>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
 
@@ -173,6 +180,117 @@ namespace Neat
 			Assert::IsTrue(0x42 == buffer[5]);
 		}
 
+		TEST_METHOD(Buffer_Capacity)
+		{
+			Buffer buffer;
+			Assert::IsTrue(buffer.Reserve(100));
+			Assert::AreEqual(100_sz, buffer.GetCapacity());
+			Assert::IsTrue(buffer.IsEmpty());
+
+			// Appends within capacity keep the block
+			const auto p = buffer.GetBuffer();
+			const byte_t foo[] = { 0x0F, 0xF0, 0xFF };
+			buffer.Append(foo, sizeof(foo));
+			Assert::IsTrue(p == buffer.GetBuffer());
+			Assert::AreEqual(3_sz, buffer.GetSize());
+
+			Assert::IsTrue(buffer.Resize(10));
+			Assert::AreEqual(10_sz, buffer.GetSize());
+			Assert::IsTrue(0xFF == buffer[2]);
+			Assert::IsTrue(0 == buffer[9]);
+
+			// Resize without zero fill keeps bytes beyond the size
+			buffer[9] = 0x42;
+			Assert::IsTrue(buffer.Resize(5));
+			Assert::IsTrue(buffer.Resize(10, false));
+			Assert::IsTrue(0x42 == buffer[9]);
+			Assert::AreEqual(100_sz, buffer.GetCapacity());
+
+			// Growth beyond capacity is geometric
+			Assert::IsTrue(buffer.Resize(101));
+			Assert::AreEqual(150_sz, buffer.GetCapacity());
+			Assert::IsTrue(0x42 == buffer[9]);
+
+			buffer.ShrinkToFit();
+			Assert::AreEqual(101_sz, buffer.GetCapacity());
+			Assert::IsTrue(0xFF == buffer[2]);
+
+			// Copy assignment reuses capacity
+			Buffer small(foo, sizeof(foo));
+			const auto q = buffer.GetBuffer();
+			buffer = small;
+			Assert::IsTrue(q == buffer.GetBuffer());
+			Assert::IsTrue(buffer == small);
+			Assert::AreEqual(101_sz, buffer.GetCapacity());
+
+			Assert::IsTrue(buffer.Resize(0));
+			buffer.ShrinkToFit();
+			Assert::IsNull(buffer.GetBuffer());
+			Assert::AreEqual(0_sz, buffer.GetCapacity());
+
+			// Buffer stays unchanged when growth fails
+			StackAllocator<16> alloc;
+			Buffer bounded(foo, sizeof(foo), &alloc);
+			Assert::IsFalse(bounded.Reserve(64));
+			Assert::IsFalse(bounded.Resize(64));
+			Assert::AreEqual(3_sz, bounded.GetSize());
+			Assert::IsTrue(0xF0 == bounded[1]);
+		}
+
+		TEST_METHOD(Buffer_AppendPerformance)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto total = 256_kB;
+			const auto chunk = 16_sz;
+			byte_t bytes[chunk] = { 0 };
+			{
+				// Emulates reallocation to the exact size on every call
+				const auto start = steady_clock::now();
+				Buffer buffer;
+				for (size_t i = 0; i < total; i += chunk)
+				{
+					buffer.Reserve(buffer.GetSize() + chunk);
+					buffer.Append(bytes, chunk);
+				}
+				const auto end = steady_clock::now();
+				const auto duration = duration_cast<microseconds>(end - start).count();
+				const auto message = Utf16::Format(
+					L"# %Iu bytes appended in %Iu byte chunks with exact growth took %llu microseconds",
+					total,
+					chunk,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			{
+				const auto start = steady_clock::now();
+				Buffer buffer;
+				size_t growths = 0;
+				for (size_t i = 0; i < total; i += chunk)
+				{
+					const auto capacity = buffer.GetCapacity();
+					buffer.Append(bytes, chunk);
+					if (capacity != buffer.GetCapacity())
+						growths++;
+				}
+				const auto end = steady_clock::now();
+				const auto duration = duration_cast<microseconds>(end - start).count();
+				const auto message = Utf16::Format(
+					L"# %Iu bytes appended in %Iu byte chunks with geometric growth took %llu microseconds, %Iu growths",
+					total,
+					chunk,
+					duration,
+					growths);
+				Logger::WriteMessage(message);
+
+				Assert::AreEqual(total, buffer.GetSize());
+				// Capacity grows by half, so growths are logarithmic in the size
+				Assert::IsTrue(growths < 30);
+			}
+			Logger::WriteMessage(L"#");
+		}
+
 		TEST_METHOD(Buffer_AllocateFree)
 		{
 			BufferT<wchar_t> buffer;
@@ -196,7 +314,7 @@ namespace Neat
 
 		TEST_METHOD(Buffer_CustomAllocator)
 		{
-			StackAllocator<23> alloc;
+			StackAllocator<32> alloc;
 			BufferT<wchar_t> defaultBuffer(L"Foo", 6);
 
 			BufferT<wchar_t> customBuffer(3, &alloc);
@@ -206,8 +324,217 @@ namespace Neat
 			Assert::AreEqual(14_sz, customBuffer.GetSize());
 			Assert::AreEqual(L"FooBar", customBuffer);
 
+			// Freed 3 bytes were reused and Append grew the top block in place
 			const auto capacity = alloc.GetCapacity();
-			Assert::AreEqual(0_sz, capacity);
+			Assert::AreEqual(16_sz, capacity);
+		}
+
+		TEST_METHOD(Buffer_Aligned)
+		{
+			{
+				Buffer buffer(100, nullptr, 64);
+				Assert::AreEqual(64_sz, buffer.GetAlignment());
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(buffer.GetBuffer()) % 64);
+
+				const byte_t tail[] = { 1, 2, 3 };
+				buffer.Append(tail, sizeof(tail));
+				Assert::AreEqual(103_sz, buffer.GetSize());
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(buffer.GetBuffer()) % 64);
+
+				Buffer copy(buffer);
+				Assert::AreEqual(64_sz, copy.GetAlignment());
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(copy.GetBuffer()) % 64);
+
+				Buffer moved(std::move(copy));
+				Assert::AreEqual(64_sz, moved.GetAlignment());
+				Assert::IsTrue(moved == buffer);
+			}
+			{
+				StackAllocator<256> alloc;
+				BufferT<float> buffer(sizeof(float) * 8, &alloc, 32);
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(buffer.GetBuffer()) % 32);
+				Assert::IsTrue(alloc.Owns(buffer.GetBuffer(), buffer.GetSize()));
+			}
+		}
+
+		TEST_METHOD(Buffer_AppendSelf)
+		{
+			StackAllocator<64> alloc;
+			Buffer buffer(&alloc);
+			const byte_t foo[] = { 0x0F, 0xF0 };
+			buffer.Append(foo, sizeof(foo));
+
+			// Source points into the buffer which moves while growing
+			buffer.Append(buffer, buffer.GetSize());
+			buffer.Append(buffer + 1, 2);
+			Assert::AreEqual(6_sz, buffer.GetSize());
+			const byte_t expected[] = { 0x0F, 0xF0, 0x0F, 0xF0, 0xF0, 0x0F };
+			Assert::AreEqual(0, memcmp(expected, buffer, sizeof(expected)));
+			Assert::AreEqual(64 - IAllocator::DefaultAlignment, alloc.GetCapacity());
+		}
+
+		TEST_METHOD(Buffer_StaticPolicy)
+		{
+			typedef BufferT<byte_t, StaticAllocatorPolicy<MallocAllocator>> MallocBuffer;
+
+			// Stateless policy takes no space
+			Assert::AreEqual(sizeof(Buffer) - sizeof(IAllocator*), sizeof(MallocBuffer));
+
+			const byte_t foo[] = { 0x0F, 0xF0, 0xFF };
+			MallocBuffer buffer(foo, sizeof(foo));
+			Assert::IsNotNull(buffer.GetAllocator());
+			buffer.Append(foo, sizeof(foo));
+			Assert::AreEqual(6_sz, buffer.GetSize());
+			Assert::IsTrue(0xFF == buffer[5]);
+
+			MallocBuffer copy(buffer);
+			Assert::IsTrue(copy == buffer);
+			MallocBuffer moved(std::move(copy));
+			Assert::IsTrue(moved == buffer);
+			Assert::IsTrue(copy.IsEmpty());
+
+			MallocBuffer aligned(100, StaticAllocatorPolicy<MallocAllocator>(), 64);
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(aligned.GetBuffer()) % 64);
+		}
+
+		TEST_METHOD(Buffer_SmallBuffer)
+		{
+			typedef SmallBufferT<byte_t, 16> Small;
+
+			MallocAllocator malloc;
+			StatsAllocator alloc(&malloc);
+			const byte_t foo[] = { 0x0F, 0xF0, 0xFF };
+			Small buffer(foo, sizeof(foo), &alloc);
+			Assert::IsTrue(buffer.IsInline());
+			Assert::AreEqual(16_sz, buffer.GetCapacity());
+			Assert::IsTrue(buffer == foo);
+
+			// Copies and moves of small buffers stay inline
+			Small copy(buffer);
+			Small moved(std::move(copy));
+			Assert::IsTrue(moved.IsInline());
+			Assert::IsTrue(moved == buffer);
+			Assert::IsTrue(copy.IsEmpty());
+			Assert::IsNull(copy.GetBuffer());
+			Assert::AreEqual(0_sz, alloc.GetSnapshot().allocations);
+
+			// Growth beyond inline storage moves to the allocator and back
+			byte_t bar[20] = { 0x42 };
+			buffer.Append(bar, sizeof(bar));
+			Assert::IsFalse(buffer.IsInline());
+			Assert::AreEqual(23_sz, buffer.GetSize());
+			Assert::IsTrue(0xFF == buffer[2]);
+			Assert::IsTrue(0x42 == buffer[3]);
+			Assert::AreEqual(1_sz, alloc.GetSnapshot().allocations);
+
+			Assert::IsTrue(buffer.Resize(4));
+			buffer.ShrinkToFit();
+			Assert::IsTrue(buffer.IsInline());
+			Assert::IsTrue(0x42 == buffer[3]);
+			Assert::AreEqual(1_sz, alloc.GetSnapshot().deallocations);
+
+			// Swap exchanges inline bytes with an allocated block
+			Small large(32, &alloc);
+			large[31] = 0x18;
+			swap(buffer, large);
+			Assert::AreEqual(32_sz, buffer.GetSize());
+			Assert::IsFalse(buffer.IsInline());
+			Assert::IsTrue(0x18 == buffer[31]);
+			Assert::AreEqual(4_sz, large.GetSize());
+			Assert::IsTrue(large.IsInline());
+			Assert::IsTrue(0x42 == large[3]);
+
+			// Over-aligned buffers use the allocator
+			Small aligned(8, &alloc, 64);
+			Assert::IsFalse(aligned.IsInline());
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(aligned.GetBuffer()) % 64);
+
+			const IBuffer& base = large;
+			Assert::AreEqual(4_sz, base.GetSize());
+			Assert::IsTrue(large.GetBuffer() == base.GetBuffer());
+		}
+
+		TEST_METHOD(Buffer_PolicyPerformance)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto count = 1000000u;
+			const byte_t foo[] = { 0x0F, 0xF0, 0xFF, 0x00 };
+			{
+				MallocAllocator alloc;
+				const auto start = steady_clock::now();
+				for (auto i = 0u; i < count; i++)
+				{
+					Buffer buffer(foo, sizeof(foo), &alloc);
+					buffer[0] = static_cast<byte_t>(i);
+				}
+				const auto end = steady_clock::now();
+				const auto duration = duration_cast<microseconds>(end - start).count();
+				const auto message = Utf16::Format(
+					L"# %u short buffers with RuntimeAllocatorPolicy took %llu microseconds",
+					count,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			{
+				const auto start = steady_clock::now();
+				for (auto i = 0u; i < count; i++)
+				{
+					BufferT<byte_t, StaticAllocatorPolicy<MallocAllocator>> buffer(foo, sizeof(foo));
+					buffer[0] = static_cast<byte_t>(i);
+				}
+				const auto end = steady_clock::now();
+				const auto duration = duration_cast<microseconds>(end - start).count();
+				const auto message = Utf16::Format(
+					L"# %u short buffers with StaticAllocatorPolicy took %llu microseconds",
+					count,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			{
+				MallocAllocator alloc;
+				const auto start = steady_clock::now();
+				for (auto i = 0u; i < count; i++)
+				{
+					SmallBuffer buffer(foo, sizeof(foo), &alloc);
+					buffer[0] = static_cast<byte_t>(i);
+				}
+				const auto end = steady_clock::now();
+				const auto duration = duration_cast<microseconds>(end - start).count();
+				const auto message = Utf16::Format(
+					L"# %u short buffers with inline storage took %llu microseconds",
+					count,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			Logger::WriteMessage(L"#");
+		}
+
+		TEST_METHOD(Buffer_AllocateBatch)
+		{
+			ArenaAllocator alloc(1_kB);
+			const size_t sizes[] = { 10, 0, 100 };
+			auto buffers = Buffer::AllocateBatch(sizes, _countof(sizes), &alloc);
+			Assert::AreEqual(_countof(sizes), buffers.size());
+			Assert::AreEqual(1_sz, alloc.GetBlockCount());
+			for (auto i = 0u; i < _countof(sizes); i++)
+			{
+				Assert::AreEqual(sizes[i], buffers[i].GetSize());
+				Assert::IsTrue(&alloc == buffers[i].GetAllocator());
+			}
+			Assert::IsTrue(buffers[1].IsEmpty());
+			Assert::AreEqual(0, static_cast<int>(buffers[2][99]));
+
+			// Buffers without allocator use new[]
+			buffers = Buffer::AllocateBatch(sizes, _countof(sizes));
+			Assert::AreEqual(100_sz, buffers[2].GetSize());
+			Assert::AreEqual(0, static_cast<int>(buffers[2][0]));
+
+			// Nothing is allocated when the batch doesn't fit
+			PoolAllocator pool;
+			const size_t oversized[] = { 10, 8_kB };
+			Assert::IsTrue(Buffer::AllocateBatch(oversized, _countof(oversized), &pool).empty());
 		}
 	};
 }
\ No newline at end of file
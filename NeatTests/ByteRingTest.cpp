@@ -0,0 +1,218 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\ByteRing.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\StatsAllocator.h>
+#include <Neat\Utf.h>
+
+#include <chrono>
+#include <mutex>
+#include <queue>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(ByteRingTest)
+	{
+	public:
+		TEST_METHOD(ByteRing_Basic)
+		{
+			MallocAllocator malloc;
+			StatsAllocator alloc(&malloc);
+			ByteRing ring(100, &alloc);
+			Assert::AreEqual(128_sz, ring.GetCapacity());
+			Assert::AreEqual(0_sz, ring.GetSize());
+			Assert::IsFalse(ring.IsMirrored());
+			Assert::AreEqual(1_sz, alloc.GetSnapshot().allocations);
+
+			byte_t bytes[200];
+			for (auto i = 0; i < _countof(bytes); i++)
+				bytes[i] = static_cast<byte_t>(i);
+
+			// Writes stop when the ring is full
+			Assert::AreEqual(128_sz, ring.Write(bytes, sizeof(bytes)));
+			Assert::AreEqual(0_sz, ring.Write(bytes, 1));
+			Assert::AreEqual(0_sz, ring.Reserve().size);
+
+			byte_t read[200] = { 0 };
+			Assert::AreEqual(100_sz, ring.Read(read, 100));
+			Assert::AreEqual(0, memcmp(bytes, read, 100));
+
+			// Bytes wrap around the end of the region
+			Assert::AreEqual(72_sz, ring.Write(bytes + 128, 72));
+			Assert::AreEqual(100_sz, ring.GetSize());
+			Assert::AreEqual(100_sz, ring.Read(read, sizeof(read)));
+			Assert::AreEqual(0, memcmp(bytes + 100, read, 100));
+			Assert::AreEqual(0_sz, ring.Read(read, 1));
+
+			// Ring never allocates after construction
+			Assert::AreEqual(1_sz, alloc.GetSnapshot().allocations);
+		}
+
+		TEST_METHOD(ByteRing_Spans)
+		{
+			ByteRing ring(64);
+			auto span = ring.Reserve();
+			Assert::AreEqual(64_sz, span.size);
+			memset(span.data, 1, 40);
+			ring.Commit(40);
+
+			span = ring.Peek();
+			Assert::AreEqual(40_sz, span.size);
+			ring.Consume(30);
+
+			// Span ends at the end of the region, the rest follows from its start
+			span = ring.Reserve();
+			Assert::AreEqual(24_sz, span.size);
+			memset(span.data, 2, span.size);
+			Assert::ExpectException<std::out_of_range>([&ring]() { ring.Commit(25); });
+			ring.Commit(10);
+			ring.Commit(span.size - 10);
+			span = ring.Reserve();
+			Assert::AreEqual(30_sz, span.size);
+			span.data[0] = 3;
+			ring.Commit(1);
+
+			span = ring.Peek();
+			Assert::AreEqual(34_sz, span.size);
+			Assert::AreEqual(35_sz, ring.GetSize());
+			Assert::IsTrue(1 == span.data[9]);
+			Assert::IsTrue(2 == span.data[10]);
+			Assert::ExpectException<std::out_of_range>([&ring]() { ring.Consume(35); });
+			ring.Consume(span.size);
+			span = ring.Peek();
+			Assert::AreEqual(1_sz, span.size);
+			Assert::IsTrue(3 == span.data[0]);
+
+			Assert::ExpectException<std::out_of_range>([&ring]() { ring.Consume(2); });
+			Assert::ExpectException<std::out_of_range>([&ring]() { ring.Commit(64); });
+
+			byte_t region[48];
+			Assert::ExpectException<std::invalid_argument>([&region]() { ByteRing other(region, sizeof(region), false); });
+			Assert::ExpectException<std::length_error>([]() { ByteRing::RoundUpCapacity(SIZE_MAX); });
+			Assert::AreEqual(SIZE_MAX / 2 + 1, ByteRing::RoundUpCapacity(SIZE_MAX / 2 + 1));
+		}
+
+		TEST_METHOD(ByteRing_Threads)
+		{
+			ByteRing ring(4_kB);
+			const uint32_t count = 1000000;
+
+			// Producer writes increasing numbers in chunks of varying size, consumer checks them
+			std::thread producer([&ring, count]()
+			{
+				uint32_t next = 0;
+				while (next < count)
+				{
+					const auto span = ring.Reserve();
+					const auto fit = (std::min)(static_cast<uint32_t>(span.size / sizeof(uint32_t)), count - next);
+					const auto values = (std::min)(fit, next % 61 + 1);
+					for (uint32_t i = 0; i < values; i++)
+					{
+						const auto value = next++;
+						memcpy(span.data + i * sizeof(value), &value, sizeof(value));
+					}
+					if (values > 0)
+						ring.Commit(values * sizeof(uint32_t));
+					else
+						std::this_thread::yield();
+				}
+			});
+
+			uint32_t expected = 0;
+			uint32_t errors = 0;
+			while (expected < count)
+			{
+				uint32_t value;
+				if (sizeof(value) != ring.Read(reinterpret_cast<byte_t*>(&value), sizeof(value)))
+				{
+					std::this_thread::yield();
+					continue;
+				}
+				if (value != expected++)
+					errors++;
+			}
+			producer.join();
+			Assert::AreEqual(0u, errors);
+			Assert::AreEqual(0_sz, ring.GetSize());
+		}
+
+		TEST_METHOD(ByteRing_Performance)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto total = 64_MB;
+			const auto chunk = 4_kB;
+			std::vector<byte_t> bytes(chunk, 0x42);
+			{
+				std::mutex mutex;
+				std::queue<Buffer> queue;
+				const auto start = steady_clock::now();
+				std::thread producer([&]()
+				{
+					for (size_t i = 0; i < total; i += chunk)
+					{
+						Buffer buffer(bytes.data(), chunk);
+						std::lock_guard<std::mutex> lock(mutex);
+						queue.push(std::move(buffer));
+					}
+				});
+
+				size_t received = 0;
+				while (received < total)
+				{
+					Buffer buffer;
+					{
+						std::lock_guard<std::mutex> lock(mutex);
+						if (!queue.empty())
+						{
+							buffer = std::move(queue.front());
+							queue.pop();
+						}
+					}
+					received += buffer.GetSize();
+				}
+				producer.join();
+				const auto end = steady_clock::now();
+				const auto duration = duration_cast<microseconds>(end - start).count();
+				const auto message = Utf16::Format(
+					L"# %Iu bytes in %Iu byte chunks through mutex and std::queue<Buffer> took %llu microseconds",
+					total,
+					chunk,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			{
+				ByteRing ring(1_MB);
+				const auto start = steady_clock::now();
+				std::thread producer([&]()
+				{
+					for (size_t i = 0; i < total; )
+						i += ring.Write(bytes.data(), chunk);
+				});
+
+				std::vector<byte_t> buffer(chunk);
+				size_t received = 0;
+				while (received < total)
+					received += ring.Read(buffer.data(), chunk);
+				producer.join();
+				const auto end = steady_clock::now();
+				const auto duration = duration_cast<microseconds>(end - start).count();
+				const auto message = Utf16::Format(
+					L"# %Iu bytes in %Iu byte chunks through ByteRing took %llu microseconds",
+					total,
+					chunk,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			Logger::WriteMessage(L"#");
+		}
+	};
+}
@@ -1,5 +1,9 @@
 #include <Neat\Types.h>
+#include <Neat\AllocatorScope.h>
+#include <Neat\ArenaAllocator.h>
 #include <Neat\Convert.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\StatsAllocator.h>
 
 #include <chrono>
 
@@ -33,6 +37,36 @@ namespace Neat
 			Assert::AreEqual(L"text ", Convert::ToUtf16(std::wstring(L"text ")));
 		}
 
+		TEST_METHOD(Convert_Allocator)
+		{
+			// Results which lose the allocator fall back to the scope, which counts them
+			MallocAllocator malloc;
+			StatsAllocator heap(&malloc);
+			AllocatorScope scope(&heap);
+
+			ArenaAllocator alloc(1_kB);
+			const auto utf8 = Convert::ToUtf8(L"text \x0442\x0435\x043A\x0441\x0442", &alloc);
+			Assert::AreEqual(u8"text \u0442\u0435\u043A\u0441\u0442", utf8);
+			// Result is counted before it's allocated, so there is no slack
+			Assert::AreEqual(16_sz, utf8.GetSize());
+			Assert::IsTrue(&alloc == utf8.GetAllocator());
+			Assert::IsTrue(alloc.Owns(const_cast<byte_t*>(utf8.GetBuffer()), utf8.GetSize()));
+
+			const auto utf16 = Convert::ToUtf16(utf8);
+			Assert::AreEqual(L"text \x0442\x0435\x043A\x0441\x0442", utf16);
+			Assert::IsTrue(&alloc == utf16.GetAllocator());
+			Assert::IsTrue(&alloc == Convert::ToUtf8(utf16).GetAllocator());
+
+			Assert::AreEqual(L"42", Convert::ToUtf16(42, &alloc));
+			Assert::IsTrue(&alloc == Convert::ToUtf16(42, &alloc).GetAllocator());
+			Assert::IsTrue(&alloc == Convert::ToUtf8(0xABu, Convert::Base::Hex, &alloc).GetAllocator());
+			Assert::IsTrue(&alloc == Convert::ToUtf8(1.5, &alloc).GetAllocator());
+			Assert::IsTrue(&alloc == Convert::ToBuffer(L"0fae01", &alloc).GetAllocator());
+			Assert::IsTrue(&alloc == Convert::ToUtf16(std::string("text"), &alloc).GetAllocator());
+
+			Assert::AreEqual(0_sz, heap.GetSnapshot().allocations);
+		}
+
 		TEST_METHOD(Convert_IntegerToString)
 		{
 			// UTF8
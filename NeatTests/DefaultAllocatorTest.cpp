@@ -116,5 +116,17 @@ namespace Neat
 				list.pop_front();
 			}
 		}
+
+		TEST_METHOD(DefaultAllocator_Aligned)
+		{
+			DefaultAllocator alloc;
+			for (auto alignment : { 32_sz, 64_sz, 4_kB })
+			{
+				auto p = alloc.AllocateAligned(100, alignment);
+				Assert::IsNotNull(p);
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % alignment);
+				alloc.DeallocateAligned(p, 100, alignment);
+			}
+		}
 	};
 }
@@ -17,7 +17,7 @@ namespace Neat
 	public:
 		TEST_METHOD(FallbackAllocator_Basic)
 		{
-			StackAllocator<16> primary;
+			StackAllocator<4 * IAllocator::DefaultAlignment> primary;
 			MallocAllocator fallback;
 			FallbackAllocator alloc(&primary, &fallback);
 			for (auto i : { 1, 2, 3, 4 })
@@ -51,5 +51,53 @@ namespace Neat
 			vec.push_back(4);
 			vec.push_back(5);
 		}
+
+		TEST_METHOD(FallbackAllocator_Aligned)
+		{
+			StackAllocator<64> primary;
+			MallocAllocator fallback;
+			FallbackAllocator alloc(&primary, &fallback);
+
+			auto p = alloc.AllocateAligned(16, 32);
+			Assert::IsNotNull(p);
+			Assert::IsTrue(primary.Owns(p, 16));
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % 32);
+
+			auto q = alloc.AllocateAligned(128, 64);
+			Assert::IsNotNull(q);
+			Assert::IsFalse(primary.Owns(q, 128));
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(q) % 64);
+
+			alloc.DeallocateAligned(q, 128, 64);
+			alloc.DeallocateAligned(p, 16, 32);
+		}
+
+		TEST_METHOD(FallbackAllocator_Reallocate)
+		{
+			StackAllocator<128> primary;
+			MallocAllocator fallback;
+			FallbackAllocator alloc(&primary, &fallback);
+			auto p = alloc.Allocate(16);
+			memcpy(p, "Neat", 4);
+
+			// Top block of the primary is resized by the primary
+			auto q = alloc.Reallocate(p, 16, 64);
+			Assert::IsNotNull(q);
+			Assert::IsTrue(primary.Owns(q, 64));
+			Assert::IsTrue(p + 16 == q + 64);
+			Assert::AreEqual(64_sz, primary.GetCapacity());
+			Assert::AreEqual(0, memcmp(q, "Neat", 4));
+
+			// Block moves to the fallback when the primary is full
+			auto r = alloc.Reallocate(q, 64, 256);
+			Assert::IsNotNull(r);
+			Assert::IsFalse(primary.Owns(r, 256));
+			Assert::AreEqual(128_sz, primary.GetCapacity());
+			Assert::AreEqual(0, memcmp(r, "Neat", 4));
+
+			r = alloc.Reallocate(r, 256, 512);
+			Assert::AreEqual(0, memcmp(r, "Neat", 4));
+			alloc.Deallocate(r, 512);
+		}
 	};
 }
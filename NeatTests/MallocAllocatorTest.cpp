@@ -116,5 +116,48 @@ namespace Neat
 				list.pop_front();
 			}
 		}
+
+		TEST_METHOD(MallocAllocator_Aligned)
+		{
+			MallocAllocator alloc;
+			for (auto alignment : { 32_sz, 64_sz, 4_kB })
+			{
+				auto p = alloc.AllocateAligned(100, alignment);
+				Assert::IsNotNull(p);
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % alignment);
+				alloc.DeallocateAligned(p, 100, alignment);
+			}
+
+			// Over-aligned element types and explicit minimum alignment
+			struct alignas(64) CacheLine
+			{
+				byte_t data[64];
+			};
+
+			std::vector<CacheLine, Allocator<CacheLine>> lines(&alloc);
+			lines.resize(3);
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(lines.data()) % 64);
+
+			std::vector<float, Allocator<float>> floats(Allocator<float>(&alloc, 32));
+			floats.resize(15);
+			Assert::AreEqual(32_sz, floats.get_allocator().GetAlignment());
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(floats.data()) % 32);
+		}
+
+		TEST_METHOD(MallocAllocator_Reallocate)
+		{
+			MallocAllocator alloc;
+			auto p = alloc.Reallocate(nullptr, 0, 4);
+			Assert::IsNotNull(p);
+			memcpy(p, "Neat", 4);
+
+			p = alloc.Reallocate(p, 4, 64_kB);
+			Assert::IsNotNull(p);
+			Assert::AreEqual(0, memcmp(p, "Neat", 4));
+
+			if (alloc.TryExpand(p, 64_kB, 100))
+				Assert::AreEqual(0, memcmp(p, "Neat", 4));
+			alloc.Deallocate(p, 100);
+		}
 	};
 }
@@ -0,0 +1,125 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\ArenaAllocator.h>
+#include <Neat\Buffer.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\MemoryResource.h>
+#include <Neat\Utf.h>
+
+#include <memory>
+#include <memory_resource>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(MemoryResourceTest)
+	{
+	public:
+		TEST_METHOD(MemoryResource_AllocatorResource)
+		{
+			ArenaAllocator arena;
+			AllocatorMemoryResource resource(&arena);
+
+			std::pmr::vector<Utf16> strings(&resource);
+			for (auto i = 0; i < 10; i++)
+				strings.push_back(Utf16(L"Hello World!", Utf16::End, &arena));
+			const auto used = arena.GetUsed();
+
+			Buffer buffer(100, &arena);
+			Assert::IsTrue(arena.Owns(buffer, buffer.GetSize()));
+			Assert::IsTrue(arena.Owns(reinterpret_cast<byte_t*>(strings.data()), sizeof(Utf16) * strings.size()));
+			Assert::IsTrue(arena.Owns(strings[9].GetBuffer(), strings[9].GetSize()));
+			Assert::IsTrue(arena.GetUsed() > used);
+
+			auto p = resource.allocate(100, 64);
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % 64);
+			resource.deallocate(p, 100, 64);
+
+			AllocatorMemoryResource same(&arena);
+			MallocAllocator malloc;
+			AllocatorMemoryResource other(&malloc);
+			Assert::IsTrue(resource == same);
+			Assert::IsFalse(resource == other);
+		}
+
+		TEST_METHOD(MemoryResource_ResourceAllocator)
+		{
+			std::pmr::monotonic_buffer_resource resource;
+			MemoryResourceAllocator alloc(&resource);
+			Assert::IsTrue(&resource == alloc.GetResource());
+
+			Buffer buffer(&alloc);
+			const byte_t foo[] = { 0x0F, 0xF0, 0xFF };
+			for (auto i = 0; i < 100; i++)
+				buffer.Append(foo, sizeof(foo));
+			Assert::AreEqual(300_sz, buffer.GetSize());
+
+			Utf8 string("Hello", Utf8::End, &alloc);
+			string += " World!";
+			Assert::AreEqual("Hello World!", string.GetString());
+
+			auto p = alloc.AllocateAligned(100, 256);
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % 256);
+			alloc.DeallocateAligned(p, 100, 256);
+
+			// Bad allocation is reported with nullptr
+			MemoryResourceAllocator null(std::pmr::null_memory_resource());
+			Assert::IsNull(null.Allocate(16));
+		}
+
+		TEST_METHOD(MemoryResource_RoundTrip)
+		{
+			ArenaAllocator arena;
+			AllocatorMemoryResource resource(&arena);
+			MemoryResourceAllocator alloc(&resource);
+
+			Buffer buffer(1_kB, &alloc);
+			Assert::IsTrue(arena.Owns(buffer, buffer.GetSize()));
+		}
+
+		TEST_METHOD(MemoryResource_Propagation)
+		{
+			ArenaAllocator first;
+			ArenaAllocator second;
+			Allocator<int32_t> firstAlloc(&first);
+			Allocator<int32_t> secondAlloc(&second);
+			Assert::IsTrue(firstAlloc == Allocator<int64_t>(&first));
+			Assert::IsTrue(firstAlloc != secondAlloc);
+			Assert::IsTrue(firstAlloc != Allocator<int32_t>(&first, 64));
+
+			std::vector<int32_t, Allocator<int32_t>> a({ 1, 2, 3 }, firstAlloc);
+			std::vector<int32_t, Allocator<int32_t>> b({ 4, 5 }, secondAlloc);
+
+			// Allocators follow contents on swap and assignment
+			a.swap(b);
+			Assert::IsTrue(a.get_allocator() == secondAlloc);
+			Assert::IsTrue(first.Owns(reinterpret_cast<byte_t*>(b.data()), sizeof(int32_t) * b.size()));
+
+			a = b;
+			Assert::IsTrue(a.get_allocator() == firstAlloc);
+			Assert::IsTrue(first.Owns(reinterpret_cast<byte_t*>(a.data()), sizeof(int32_t) * a.size()));
+
+			// Moved-from container keeps a usable allocator
+			std::vector<int32_t, Allocator<int32_t>> c(std::move(a));
+			a.push_back(42);
+			Assert::AreEqual(42, a.back());
+			Assert::IsTrue(c.get_allocator() == firstAlloc);
+
+			Allocator<int32_t> empty(nullptr);
+			auto thrown = false;
+			try
+			{
+				empty.allocate(1);
+			}
+			catch (const std::bad_alloc&)
+			{
+				thrown = true;
+			}
+			Assert::IsTrue(thrown);
+		}
+	};
+}
@@ -0,0 +1,214 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\ObjectPool.h>
+#include <Neat\Utf.h>
+#include <Neat\Uuid.h>
+
+#include <chrono>
+#include <map>
+#include <stdexcept>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(ObjectPoolTest)
+	{
+		struct Record
+		{
+			Record(int64_t id, size_t& alive) :
+				id(id),
+				alive(alive)
+			{
+				if (id < 0)
+					throw std::invalid_argument("id");
+				alive++;
+			}
+
+			~Record()
+			{
+				alive--;
+			}
+
+			int64_t id;
+			size_t& alive;
+		};
+
+	public:
+		TEST_METHOD(ObjectPool_Basic)
+		{
+			size_t alive = 0;
+			ObjectPool<Record> pool(4);
+			Assert::AreEqual(0_sz, pool.GetSlabCount());
+
+			auto first = pool.Create(int64_t(1), alive);
+			auto second = pool.Create(int64_t(2), alive);
+			Assert::IsNotNull(first);
+			Assert::AreEqual(int64_t(2), second->id);
+			Assert::AreEqual(2_sz, alive);
+			Assert::AreEqual(2_sz, pool.GetSize());
+			Assert::AreEqual(1_sz, pool.GetSlabCount());
+			Assert::IsTrue(pool.Owns(first));
+
+			pool.Destroy(first);
+			Assert::AreEqual(1_sz, alive);
+			Assert::AreEqual(1_sz, pool.GetSize());
+
+			// Freed slot is reused first
+			Assert::IsTrue(first == pool.Create(int64_t(3), alive));
+			Assert::AreEqual(int64_t(3), first->id);
+
+			pool.Destroy(first);
+			pool.Destroy(second);
+			pool.Destroy(nullptr);
+			Assert::AreEqual(0_sz, alive);
+			Assert::AreEqual(0_sz, pool.GetSize());
+		}
+
+		TEST_METHOD(ObjectPool_Slabs)
+		{
+			size_t alive = 0;
+			ObjectPool<Record> pool(4);
+			std::vector<Record*> records;
+			for (auto i = 0; i < 10; i++)
+				records.push_back(pool.Create(int64_t(i), alive));
+			Assert::AreEqual(3_sz, pool.GetSlabCount());
+
+			// Slots of one slab are adjacent
+			Assert::IsTrue(records[0] + 1 == records[1]);
+			Assert::IsTrue(records[4] + 3 == records[7]);
+
+			for (auto record : records)
+				pool.Destroy(record);
+			for (auto i = 0; i < 10; i++)
+				records[i] = pool.Create(int64_t(i), alive);
+			Assert::AreEqual(3_sz, pool.GetSlabCount());
+
+			for (auto record : records)
+				pool.Destroy(record);
+			Assert::AreEqual(0_sz, alive);
+
+			Record outside(0, alive);
+			Assert::IsFalse(pool.Owns(&outside));
+		}
+
+		TEST_METHOD(ObjectPool_Exception)
+		{
+			size_t alive = 0;
+			ObjectPool<Record> pool;
+			auto record = pool.Create(int64_t(1), alive);
+			pool.Destroy(record);
+
+			auto thrown = false;
+			try
+			{
+				pool.Create(int64_t(-1), alive);
+			}
+			catch (const std::invalid_argument&)
+			{
+				thrown = true;
+			}
+			Assert::IsTrue(thrown);
+			Assert::AreEqual(0_sz, pool.GetSize());
+
+			// Slot of the failed object went back to free list
+			Assert::IsTrue(record == pool.Create(int64_t(2), alive));
+			pool.Destroy(record);
+		}
+
+		TEST_METHOD(ObjectPool_Upstream)
+		{
+			struct alignas(64) CacheLine
+			{
+				byte_t data[64];
+			};
+
+			MallocAllocator upstream;
+			ObjectPool<CacheLine> pool(16, &upstream);
+			std::vector<CacheLine*> lines;
+			for (auto i = 0; i < 40; i++)
+			{
+				auto line = pool.Create();
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(line) % 64);
+				lines.push_back(line);
+			}
+			Assert::AreEqual(3_sz, pool.GetSlabCount());
+			for (auto line : lines)
+				pool.Destroy(line);
+		}
+
+		TEST_METHOD(ObjectPool_Map)
+		{
+			ObjectPool<Uuid> pool;
+			std::map<int64_t, Uuid*> records;
+			for (auto i = 0; i < 100; i++)
+			{
+				const auto b = static_cast<byte_t>(i);
+				records[i] = pool.Create(std::initializer_list<byte_t>{ b, b, b, b, b, b, b, b, b, b, b, b, b, b, b, b });
+			}
+			Assert::AreEqual(100_sz, pool.GetSize());
+			Assert::IsTrue(*records[42] == Uuid({ 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42, 42 }));
+
+			for (auto& record : records)
+				pool.Destroy(record.second);
+			Assert::AreEqual(0_sz, pool.GetSize());
+		}
+
+		TEST_METHOD(ObjectPool_Throughput)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto count = 100000u;
+			std::vector<Uuid*> uuids(64);
+			{
+				const auto start = steady_clock::now();
+				for (auto i = 0u; i < count; i++)
+				{
+					auto& uuid = uuids[i % uuids.size()];
+					delete uuid;
+					uuid = new Uuid();
+				}
+				for (auto& uuid : uuids)
+				{
+					delete uuid;
+					uuid = nullptr;
+				}
+				const auto end = steady_clock::now();
+				const auto duration = duration_cast<microseconds>(end - start).count();
+				const auto message = Utf16::Format(
+					L"# %u Uuid new/delete pairs took %llu microseconds",
+					count,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			{
+				ObjectPool<Uuid> pool;
+				const auto start = steady_clock::now();
+				for (auto i = 0u; i < count; i++)
+				{
+					auto& uuid = uuids[i % uuids.size()];
+					pool.Destroy(uuid);
+					uuid = pool.Create();
+				}
+				for (auto& uuid : uuids)
+				{
+					pool.Destroy(uuid);
+					uuid = nullptr;
+				}
+				const auto end = steady_clock::now();
+				const auto duration = duration_cast<microseconds>(end - start).count();
+				const auto message = Utf16::Format(
+					L"# %u Uuid ObjectPool Create/Destroy pairs took %llu microseconds",
+					count,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			Logger::WriteMessage(L"#");
+		}
+	};
+}
@@ -0,0 +1,286 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\FallbackAllocator.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\PoolAllocator.h>
+#include <Neat\Utf.h>
+
+#include <chrono>
+#include <map>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(PoolAllocatorTest)
+	{
+	public:
+		TEST_METHOD(PoolAllocator_Basic)
+		{
+			PoolAllocator alloc;
+			Assert::AreEqual(0_sz, alloc.GetSlabCount());
+
+			for (auto size : { 1_sz, 16_sz, 17_sz, 100_sz, 4_kB })
+			{
+				auto p = alloc.Allocate(size);
+				Assert::IsNotNull(p);
+				Assert::IsTrue(alloc.Owns(p, size));
+				memset(p, 0xAB, size);
+			}
+			Assert::AreEqual(4_sz, alloc.GetSlabCount());
+
+			Assert::IsNull(alloc.Allocate(4_kB + 1));
+		}
+
+		TEST_METHOD(PoolAllocator_SizeClass)
+		{
+			Assert::AreEqual(0_sz, PoolAllocator::GetSizeClass(0));
+			Assert::AreEqual(0_sz, PoolAllocator::GetSizeClass(16));
+			Assert::AreEqual(1_sz, PoolAllocator::GetSizeClass(17));
+			Assert::AreEqual(1_sz, PoolAllocator::GetSizeClass(32));
+			Assert::AreEqual(8_sz, PoolAllocator::GetSizeClass(4_kB));
+
+			Assert::AreEqual(16_sz, PoolAllocator::GetClassSize(0));
+			Assert::AreEqual(4_kB, PoolAllocator::GetClassSize(8));
+		}
+
+		TEST_METHOD(PoolAllocator_Reuse)
+		{
+			PoolAllocator alloc;
+			auto first = alloc.Allocate(24);
+			auto second = alloc.Allocate(24);
+			Assert::IsTrue(second == first + 32);
+
+			alloc.Deallocate(first, 24);
+			Assert::IsTrue(first == alloc.Allocate(30));
+
+			alloc.Deallocate(second, 24);
+			Assert::IsTrue(second == alloc.Allocate(32));
+			Assert::AreEqual(1_sz, alloc.GetSlabCount());
+		}
+
+		TEST_METHOD(PoolAllocator_Owns)
+		{
+			PoolAllocator alloc(4_kB);
+			MallocAllocator other;
+
+			auto p = alloc.Allocate(64);
+			auto q = other.Allocate(64);
+			Assert::IsTrue(alloc.Owns(p, 64));
+			Assert::IsFalse(alloc.Owns(q, 64));
+			Assert::IsFalse(alloc.Owns(p, 8_kB));
+			other.Deallocate(q, 64);
+
+			std::vector<byte_t*> blocks;
+			for (auto i = 0; i < 256; i++)
+				blocks.push_back(alloc.Allocate(64));
+			Assert::IsTrue(alloc.GetSlabCount() > 1);
+			for (auto block : blocks)
+				Assert::IsTrue(alloc.Owns(block, 64));
+
+			alloc.Release();
+			Assert::AreEqual(0_sz, alloc.GetSlabCount());
+			Assert::IsFalse(alloc.Owns(p, 64));
+		}
+
+		TEST_METHOD(PoolAllocator_Upstream)
+		{
+			MallocAllocator upstream;
+			PoolAllocator alloc(16_kB, &upstream);
+			auto p = alloc.Allocate(128);
+			Assert::IsNotNull(p);
+			Assert::AreEqual(16_kB, alloc.GetSlabSize());
+			Assert::AreEqual(1_sz, alloc.GetSlabCount());
+		}
+
+		TEST_METHOD(PoolAllocator_Map)
+		{
+			PoolAllocator alloc;
+			std::map<int32_t, int64_t, std::less<int32_t>, Allocator<std::pair<const int32_t, int64_t>>> map(&alloc);
+			for (auto i = 0; i < 1000; i++)
+				map[i] = i * 2;
+			for (auto i = 0; i < 1000; i += 2)
+				map.erase(i);
+			for (auto i = 0; i < 1000; i++)
+				map[i] = i * 3;
+
+			Assert::AreEqual(1000_sz, map.size());
+			Assert::AreEqual(int64_t(2997), map[999]);
+		}
+
+		TEST_METHOD(PoolAllocator_Fallback)
+		{
+			PoolAllocator primary;
+			MallocAllocator fallback;
+			FallbackAllocator alloc(&primary, &fallback);
+
+			Buffer small(100, &alloc);
+			Buffer large(8_kB, &alloc);
+			Assert::IsTrue(primary.Owns(small.GetBuffer(), small.GetSize()));
+			Assert::IsFalse(primary.Owns(large.GetBuffer(), large.GetSize()));
+
+			small.Append(large, 1_kB);
+			Assert::AreEqual(1124_sz, small.GetSize());
+			Assert::IsTrue(primary.Owns(small.GetBuffer(), small.GetSize()));
+		}
+
+		TEST_METHOD(PoolAllocator_Throughput)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto count = 100000u;
+			const size_t sizes[] = { 8, 24, 40, 100, 250, 600, 1500, 3000 };
+			std::vector<byte_t*> blocks(64);
+
+			auto run = [&](IAllocator& alloc)
+			{
+				const auto start = steady_clock::now();
+				for (auto i = 0u; i < count; i++)
+				{
+					const auto size = sizes[i % _countof(sizes)];
+					auto& block = blocks[i % blocks.size()];
+					if (block)
+						alloc.Deallocate(block, sizes[(i - blocks.size()) % _countof(sizes)]);
+					block = alloc.Allocate(size);
+				}
+				for (auto i = count; i < count + blocks.size(); i++)
+				{
+					auto& block = blocks[i % blocks.size()];
+					alloc.Deallocate(block, sizes[(i - blocks.size()) % _countof(sizes)]);
+					block = nullptr;
+				}
+				const auto end = steady_clock::now();
+				return duration_cast<microseconds>(end - start).count();
+			};
+			{
+				MallocAllocator alloc;
+				const auto duration = run(alloc);
+				const auto message = Utf16::Format(
+					L"# %u MallocAllocator allocate/deallocate pairs took %llu microseconds",
+					count,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			{
+				PoolAllocator alloc;
+				const auto duration = run(alloc);
+				const auto message = Utf16::Format(
+					L"# %u PoolAllocator allocate/deallocate pairs took %llu microseconds",
+					count,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			Logger::WriteMessage(L"#");
+		}
+
+		TEST_METHOD(PoolAllocator_Aligned)
+		{
+			PoolAllocator alloc;
+			Assert::IsNotNull(alloc.Allocate(16));
+
+			for (auto alignment : { 32_sz, 64_sz, 512_sz, 4_kB })
+			{
+				auto p = alloc.AllocateAligned(20, alignment);
+				Assert::IsNotNull(p);
+				Assert::IsTrue(alloc.Owns(p, 20));
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % alignment);
+				alloc.DeallocateAligned(p, 20, alignment);
+				Assert::IsTrue(p == alloc.AllocateAligned(20, alignment));
+			}
+			Assert::IsNull(alloc.AllocateAligned(20, 8_kB));
+		}
+
+		TEST_METHOD(PoolAllocator_Reallocate)
+		{
+			PoolAllocator alloc;
+			auto p = alloc.Allocate(20);
+			Assert::IsTrue(alloc.TryExpand(p, 20, 32));
+			Assert::IsFalse(alloc.TryExpand(p, 32, 33));
+			Assert::IsFalse(alloc.TryExpand(p, 32, 8_kB));
+
+			p[0] = 42;
+			auto q = alloc.Reallocate(p, 32, 100);
+			Assert::IsNotNull(q);
+			Assert::IsTrue(p != q);
+			Assert::AreEqual(42, static_cast<int>(q[0]));
+			Assert::IsTrue(p == alloc.Allocate(32));
+		}
+
+		TEST_METHOD(PoolAllocator_Batch)
+		{
+			PoolAllocator alloc;
+			const size_t sizes[] = { 24, 0, 100, 24, 4_kB };
+			byte_t* blocks[_countof(sizes)];
+			Assert::IsTrue(alloc.AllocateBatch(sizes, _countof(sizes), blocks));
+			Assert::IsNull(blocks[1]);
+			Assert::IsTrue(blocks[3] == blocks[0] + 32);
+			for (auto i = 0u; i < _countof(sizes); i++)
+			{
+				if (sizes[i] > 0)
+					Assert::IsTrue(alloc.Owns(blocks[i], sizes[i]));
+			}
+
+			alloc.DeallocateBatch(blocks, sizes, _countof(sizes));
+			Assert::IsTrue(blocks[3] == alloc.Allocate(24));
+			Assert::IsTrue(blocks[0] == alloc.Allocate(24));
+
+			// Oversized block fails the whole batch
+			const size_t oversized[] = { 24, 8_kB };
+			byte_t* none[_countof(oversized)];
+			Assert::IsFalse(alloc.AllocateBatch(oversized, _countof(oversized), none));
+			Assert::IsNull(none[0]);
+			Assert::IsNull(none[1]);
+		}
+
+		TEST_METHOD(PoolAllocator_BatchThroughput)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto rounds = 1000u;
+			std::vector<size_t> sizes(256);
+			for (auto i = 0u; i < sizes.size(); i++)
+				sizes[i] = 16 + (i * 40) % 1000;
+			std::vector<byte_t*> blocks(sizes.size());
+
+			PoolAllocator pool;
+			IAllocator& alloc = pool;
+			auto start = steady_clock::now();
+			for (auto round = 0u; round < rounds; round++)
+			{
+				for (auto i = 0u; i < sizes.size(); i++)
+					blocks[i] = alloc.Allocate(sizes[i]);
+				for (auto i = 0u; i < sizes.size(); i++)
+					alloc.Deallocate(blocks[i], sizes[i]);
+			}
+			auto end = steady_clock::now();
+			const auto single = duration_cast<microseconds>(end - start).count();
+
+			start = steady_clock::now();
+			for (auto round = 0u; round < rounds; round++)
+			{
+				alloc.AllocateBatch(sizes.data(), sizes.size(), blocks.data());
+				alloc.DeallocateBatch(blocks.data(), sizes.data(), sizes.size());
+			}
+			end = steady_clock::now();
+			const auto batch = duration_cast<microseconds>(end - start).count();
+
+			Logger::WriteMessage(Utf16::Format(
+				L"# %u rounds of %u single allocations took %llu microseconds",
+				rounds,
+				static_cast<unsigned>(sizes.size()),
+				single));
+			Logger::WriteMessage(Utf16::Format(
+				L"# %u rounds of %u batched allocations took %llu microseconds",
+				rounds,
+				static_cast<unsigned>(sizes.size()),
+				batch));
+			Logger::WriteMessage(L"#");
+		}
+	};
+}
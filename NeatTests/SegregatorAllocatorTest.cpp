@@ -0,0 +1,155 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\FallbackAllocator.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\PoolAllocator.h>
+#include <Neat\SegregatorAllocator.h>
+#include <Neat\Utf.h>
+
+#include <chrono>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(SegregatorAllocatorTest)
+	{
+		class ProbedAllocator : public MallocAllocator
+		{
+		public:
+			byte_t* Allocate(size_t bytes) override
+			{
+				allocations++;
+				return MallocAllocator::Allocate(bytes);
+			}
+
+			bool Owns(byte_t* p, size_t bytes) override
+			{
+				probes++;
+				return MallocAllocator::Owns(p, bytes);
+			}
+
+			size_t allocations = 0;
+			size_t probes = 0;
+		};
+
+	public:
+		TEST_METHOD(SegregatorAllocator_Basic)
+		{
+			PoolAllocator small;
+			ProbedAllocator large;
+			SegregatorAllocator<PoolAllocator::MaxBlockSize> alloc(&small, &large);
+
+			auto p = alloc.Allocate(100);
+			Assert::IsNotNull(p);
+			Assert::IsTrue(small.Owns(p, 100));
+			Assert::IsTrue(alloc.Owns(p, 100));
+
+			auto q = alloc.Allocate(4_kB + 1);
+			Assert::IsNotNull(q);
+			Assert::IsFalse(small.Owns(q, 4_kB + 1));
+			Assert::IsTrue(alloc.Owns(q, 4_kB + 1));
+			Assert::AreEqual(1_sz, large.probes);
+
+			alloc.Deallocate(p, 100);
+			alloc.Deallocate(q, 4_kB + 1);
+			Assert::AreEqual(1_sz, large.probes);
+			Assert::IsTrue(p == alloc.Allocate(100));
+			alloc.Deallocate(p, 100);
+		}
+
+		TEST_METHOD(SegregatorAllocator_Threshold)
+		{
+			ProbedAllocator small;
+			ProbedAllocator large;
+			SegregatorAllocator<64> alloc(&small, &large);
+			Assert::AreEqual(64_sz, alloc.Threshold);
+
+			Buffer buffer(64, &alloc);
+			Assert::AreEqual(1_sz, small.allocations);
+			Assert::AreEqual(0_sz, large.allocations);
+
+			const byte_t tail[] = { 1 };
+			buffer.Append(tail, _countof(tail));
+			Assert::AreEqual(65_sz, buffer.GetSize());
+			Assert::AreEqual(1_sz, small.allocations);
+			Assert::AreEqual(1_sz, large.allocations);
+			Assert::AreEqual(0_sz, small.probes + large.probes);
+		}
+
+		TEST_METHOD(SegregatorAllocator_Aligned)
+		{
+			PoolAllocator small;
+			MallocAllocator large;
+			SegregatorAllocator<PoolAllocator::MaxBlockSize> alloc(&small, &large);
+
+			auto p = alloc.AllocateAligned(100, 64);
+			Assert::IsNotNull(p);
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % 64);
+			Assert::IsTrue(small.Owns(p, 100));
+			alloc.DeallocateAligned(p, 100, 64);
+
+			auto q = alloc.AllocateAligned(8_kB, 4_kB);
+			Assert::IsNotNull(q);
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(q) % 4_kB);
+			alloc.DeallocateAligned(q, 8_kB, 4_kB);
+		}
+
+		TEST_METHOD(SegregatorAllocator_Throughput)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto count = 100000u;
+			const size_t sizes[] = { 8, 24, 100, 600, 3000, 6000, 20000 };
+			std::vector<byte_t*> blocks(64);
+
+			auto run = [&](IAllocator& alloc)
+			{
+				const auto start = steady_clock::now();
+				for (auto i = 0u; i < count; i++)
+				{
+					auto& block = blocks[i % blocks.size()];
+					if (block)
+						alloc.Deallocate(block, sizes[(i - blocks.size()) % _countof(sizes)]);
+					block = alloc.Allocate(sizes[i % _countof(sizes)]);
+				}
+				for (auto i = count; i < count + blocks.size(); i++)
+				{
+					auto& block = blocks[i % blocks.size()];
+					alloc.Deallocate(block, sizes[(i - blocks.size()) % _countof(sizes)]);
+					block = nullptr;
+				}
+				const auto end = steady_clock::now();
+				return duration_cast<microseconds>(end - start).count();
+			};
+			{
+				PoolAllocator primary;
+				MallocAllocator fallback;
+				FallbackAllocator alloc(&primary, &fallback);
+				const auto duration = run(alloc);
+				const auto message = Utf16::Format(
+					L"# %u FallbackAllocator allocate/deallocate pairs took %llu microseconds",
+					count,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			{
+				PoolAllocator small;
+				MallocAllocator large;
+				SegregatorAllocator<PoolAllocator::MaxBlockSize> alloc(&small, &large);
+				const auto duration = run(alloc);
+				const auto message = Utf16::Format(
+					L"# %u SegregatorAllocator allocate/deallocate pairs took %llu microseconds",
+					count,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			Logger::WriteMessage(L"#");
+		}
+	};
+}
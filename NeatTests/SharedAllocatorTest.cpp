@@ -0,0 +1,125 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\SharedAllocator.h>
+
+#include <atomic>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(SharedAllocatorTest)
+	{
+	public:
+		TEST_METHOD(SharedAllocator_Basic)
+		{
+			std::vector<byte_t> region(64_kB);
+			SharedAllocator alloc(region.data(), region.size());
+			Assert::AreEqual(64_kB, alloc.GetSize());
+			Assert::AreEqual(0_sz, alloc.GetReserved());
+
+			auto p = alloc.Allocate(24);
+			auto q = alloc.Allocate(24);
+			Assert::IsNotNull(p);
+			Assert::IsTrue(q == p + 32);
+			Assert::IsTrue(alloc.Owns(p, 24));
+			Assert::AreEqual(0_sz, static_cast<size_t>(p - region.data()) % SharedAllocator::Granularity);
+			Assert::AreEqual(64_sz, alloc.GetReserved());
+
+			alloc.Deallocate(p, 24);
+			Assert::IsTrue(p == alloc.Allocate(32));
+			Assert::AreEqual(64_sz, alloc.GetReserved());
+
+			Assert::IsTrue(alloc.TryExpand(p, 24, 32));
+			Assert::IsFalse(alloc.TryExpand(p, 32, 33));
+			Assert::IsNull(alloc.AllocateAligned(16, 64));
+			Assert::IsNull(alloc.Allocate(64_kB));
+		}
+
+		TEST_METHOD(SharedAllocator_Attach)
+		{
+			std::vector<byte_t> region(64_kB);
+			SharedAllocator first(region.data(), region.size());
+			auto p = first.Allocate(100);
+			strcpy_s(reinterpret_cast<char*>(p), 100, "payload");
+			first.SetRoot(first.GetOffset(p));
+
+			// Same region seen at another address, as by another process
+			std::vector<byte_t> copy(region);
+			SharedAllocator second(copy.data(), copy.size());
+			const auto offset = second.GetRoot();
+			Assert::AreEqual(first.GetOffset(p), offset);
+			Assert::AreEqual("payload", reinterpret_cast<const char*>(second.GetPointer(offset)));
+			Assert::AreEqual(first.GetReserved(), second.GetReserved());
+			Assert::IsNull(second.GetPointer(0));
+			Assert::AreEqual(0_sz, second.GetOffset(nullptr));
+		}
+
+		TEST_METHOD(SharedAllocator_Exhaust)
+		{
+			std::vector<byte_t> region(4_kB);
+			SharedAllocator alloc(region.data(), region.size());
+
+			std::vector<byte_t*> blocks;
+			while (auto p = alloc.Allocate(64))
+				blocks.push_back(p);
+			Assert::IsTrue(blocks.size() > 50);
+			Assert::IsTrue(alloc.GetReserved() <= 4_kB);
+
+			for (auto p : blocks)
+				alloc.Deallocate(p, 64);
+			for (size_t i = 0; i < blocks.size(); i++)
+				Assert::IsNotNull(alloc.Allocate(64));
+			Assert::IsNull(alloc.Allocate(64));
+
+			Assert::ExpectException<std::invalid_argument>([&]()
+			{
+				SharedAllocator tiny(region.data(), 16);
+			});
+		}
+
+		TEST_METHOD(SharedAllocator_Threads)
+		{
+			std::vector<byte_t> region(1_MB);
+			SharedAllocator alloc(region.data(), region.size());
+
+			std::atomic<size_t> corrupted = 0;
+			std::vector<std::thread> threads;
+			for (auto t = 0; t < 4; t++)
+			{
+				threads.emplace_back([&alloc, &corrupted, t]()
+				{
+					std::vector<byte_t*> blocks;
+					for (auto i = 0; i < 20000; i++)
+					{
+						const auto size = 16_sz << (i % 4);
+						auto p = alloc.Allocate(size);
+						memset(p, t, size);
+						blocks.push_back(p);
+						if (blocks.size() == 16)
+						{
+							for (size_t j = 0; j < blocks.size(); j++)
+							{
+								const auto blockSize = 16_sz << ((i - 15 + j) % 4);
+								if (blocks[j][blockSize - 1] != t)
+									corrupted++;
+								alloc.Deallocate(blocks[j], blockSize);
+							}
+							blocks.clear();
+						}
+					}
+				});
+			}
+			for (auto& thread : threads)
+				thread.join();
+
+			Assert::AreEqual(0_sz, corrupted.load());
+			Assert::IsTrue(alloc.GetReserved() < 1_MB);
+		}
+	};
+}
@@ -0,0 +1,177 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\SharedBuffer.h>
+#include <Neat\StatsAllocator.h>
+
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(SharedBufferTest)
+	{
+	public:
+		TEST_METHOD(SharedBuffer_Basic)
+		{
+			SharedBuffer empty;
+			Assert::IsTrue(empty.IsEmpty());
+			Assert::IsNull(empty.GetBuffer());
+			Assert::AreEqual(0_sz, empty.GetUseCount());
+
+			const byte_t foo[] = { 0x0F, 0xF0, 0xFF };
+			MallocAllocator malloc;
+			StatsAllocator alloc(&malloc);
+			SharedBuffer buffer(foo, sizeof(foo), &alloc);
+			Assert::AreEqual(3_sz, buffer.GetSize());
+			Assert::AreEqual(0, memcmp(foo, static_cast<const SharedBuffer&>(buffer).GetBuffer(), sizeof(foo)));
+			Assert::IsTrue(&alloc == buffer.GetAllocator());
+
+			// Copies share the block
+			SharedBuffer copy(buffer);
+			Assert::AreEqual(2_sz, buffer.GetUseCount());
+			SharedBuffer moved(std::move(copy));
+			Assert::AreEqual(2_sz, buffer.GetUseCount());
+			Assert::IsTrue(copy.IsEmpty());
+			moved.Reset();
+			Assert::AreEqual(1_sz, buffer.GetUseCount());
+			Assert::AreEqual(1_sz, alloc.GetSnapshot().allocations);
+
+			// Contents of other buffers are copied
+			Buffer source(foo, sizeof(foo));
+			SharedBuffer other(source);
+			Assert::AreEqual(3_sz, other.GetSize());
+			Assert::IsFalse(other.GetBuffer() == source.GetBuffer());
+		}
+
+		TEST_METHOD(SharedBuffer_Slice)
+		{
+			MallocAllocator malloc;
+			StatsAllocator alloc(&malloc);
+			const byte_t foo[] = { 0x01, 0x02, 0x03, 0x04, 0x05, 0x06 };
+			SharedBuffer slice;
+			// Writable access would detach the slice from the block
+			const SharedBuffer& sliceView = slice;
+			{
+				SharedBuffer buffer(foo, sizeof(foo), &alloc);
+				const SharedBuffer& view = buffer;
+				const auto middle = buffer.Slice(1, 4);
+				Assert::AreEqual(4_sz, middle.GetSize());
+				Assert::IsTrue(view.GetBuffer() + 1 == middle.GetBuffer());
+
+				// Slice of slice points into the same block
+				slice = middle.Slice(2);
+				Assert::AreEqual(2_sz, slice.GetSize());
+				Assert::IsTrue(view.GetBuffer() + 3 == sliceView.GetBuffer());
+				Assert::AreEqual(3_sz, buffer.GetUseCount());
+
+				Assert::IsTrue(buffer.Slice(6).IsEmpty());
+				Assert::ExpectException<std::out_of_range>([&]() { buffer.Slice(7); });
+				Assert::ExpectException<std::out_of_range>([&]() { buffer.Slice(2, 5); });
+			}
+
+			// Slice keeps the block alive
+			Assert::AreEqual(1_sz, slice.GetUseCount());
+			Assert::AreEqual(0_sz, alloc.GetSnapshot().deallocations);
+			Assert::IsTrue(0x04 == sliceView.GetBuffer()[0]);
+			Assert::IsTrue(0x05 == sliceView.GetBuffer()[1]);
+
+			// Assigning own slice releases the rest
+			slice = slice.Slice(1);
+			Assert::AreEqual(1_sz, slice.GetSize());
+			Assert::IsTrue(0x05 == sliceView.GetBuffer()[0]);
+
+			slice.Reset();
+			Assert::AreEqual(1_sz, alloc.GetSnapshot().deallocations);
+			Assert::AreEqual(0_sz, alloc.GetSnapshot().liveBytes);
+		}
+
+		TEST_METHOD(SharedBuffer_CopyOnWrite)
+		{
+			const byte_t foo[] = { 0x0F, 0xF0, 0xFF };
+			SharedBuffer buffer(foo, sizeof(foo));
+			const SharedBuffer shared(buffer);
+
+			// Writable access detaches from the shared block
+			auto p = buffer.GetBuffer();
+			p[0] = 0x42;
+			Assert::AreEqual(1_sz, buffer.GetUseCount());
+			Assert::AreEqual(1_sz, shared.GetUseCount());
+			Assert::IsTrue(0x0F == shared.GetBuffer()[0]);
+			Assert::IsTrue(0xF0 == buffer.GetBuffer()[1]);
+
+			// Sole owner writes in place
+			Assert::IsTrue(p == buffer.GetBuffer());
+
+			auto slice = shared.Slice(1);
+			slice.GetBuffer()[0] = 0x18;
+			Assert::AreEqual(2_sz, slice.GetSize());
+			Assert::IsTrue(0xF0 == shared.GetBuffer()[1]);
+		}
+
+		TEST_METHOD(SharedBuffer_WriteAfterSlice)
+		{
+			MallocAllocator malloc;
+			StatsAllocator alloc(&malloc);
+			const byte_t foo[] = { 0x01, 0x02, 0x03, 0x04 };
+			SharedBuffer buffer(foo, sizeof(foo), &alloc);
+			const SharedBuffer before = buffer.Slice(1, 2);
+			auto p = buffer.GetBuffer();
+			Assert::AreEqual(2_sz, alloc.GetSnapshot().allocations);
+
+			// Views taken after writable access get their own bytes
+			const auto slice = buffer.Slice(1, 2);
+			const SharedBuffer copy(buffer);
+			Assert::AreEqual(1_sz, buffer.GetUseCount());
+			Assert::AreEqual(4_sz, alloc.GetSnapshot().allocations);
+
+			p[1] = 0x42;
+			p[2] = 0x42;
+			Assert::IsTrue(0x02 == slice.GetBuffer()[0]);
+			Assert::IsTrue(0x03 == slice.GetBuffer()[1]);
+			Assert::IsTrue(0x02 == copy.GetBuffer()[1]);
+			Assert::IsTrue(0x02 == before.GetBuffer()[0]);
+			Assert::IsTrue(0x42 == static_cast<const SharedBuffer&>(buffer).GetBuffer()[1]);
+
+			// Views of the others still share
+			const auto part = slice.Slice(1);
+			Assert::AreEqual(2_sz, slice.GetUseCount());
+			Assert::AreEqual(4_sz, alloc.GetSnapshot().allocations);
+		}
+
+		TEST_METHOD(SharedBuffer_Threads)
+		{
+			MallocAllocator malloc;
+			StatsAllocator alloc(&malloc);
+			std::vector<byte_t> bytes(1_kB, 0x42);
+			{
+				SharedBuffer buffer(bytes.data(), bytes.size(), &alloc);
+
+				// Threads take and drop slices of the same block
+				std::vector<std::thread> threads;
+				for (auto t = 0; t < 4; t++)
+				{
+					threads.emplace_back([slice = buffer.Slice(t * 256, 256)]()
+					{
+						for (auto i = 0; i < 10000; i++)
+						{
+							const auto part = slice.Slice(i % 256, 1);
+							if (0x42 != part.GetBuffer()[0])
+								throw std::runtime_error("Unexpected byte");
+						}
+					});
+				}
+				for (auto& thread : threads)
+					thread.join();
+				Assert::AreEqual(1_sz, buffer.GetUseCount());
+			}
+			Assert::AreEqual(1_sz, alloc.GetSnapshot().allocations);
+			Assert::AreEqual(1_sz, alloc.GetSnapshot().deallocations);
+		}
+	};
+}
@@ -15,19 +15,19 @@ namespace Neat
 	public:
 		TEST_METHOD(StackAllocator_Basic)
 		{
-			StackAllocator<32> alloc;
+			StackAllocator<64> alloc;
 			for (auto i : {1, 2, 3, 4})
 			{
-				auto p = alloc.Allocate(8);
+				auto p = alloc.Allocate(16);
 				Assert::IsNotNull(p);
-				Assert::IsTrue(alloc.Owns(p, 8));
+				Assert::IsTrue(alloc.Owns(p, 16));
 			}
 			Assert::AreEqual(0_sz, alloc.GetCapacity());
 		}
 
 		TEST_METHOD(StackAllocator_Vector)
 		{
-			StackAllocator<32> alloc;
+			StackAllocator<128> alloc;
 			std::vector<uint16_t, Allocator<uint16_t>> vec(&alloc);
 			vec.push_back(1);
 			vec.push_back(2);
@@ -38,5 +38,127 @@ namespace Neat
 			const auto capacity = alloc.GetCapacity();
 			vec.clear();
 		}
+
+		TEST_METHOD(StackAllocator_Lifo)
+		{
+			StackAllocator<64> alloc;
+			auto first = alloc.Allocate(16);
+			auto second = alloc.Allocate(16);
+			Assert::AreEqual(32_sz, alloc.GetCapacity());
+
+			// Only the most recent block is given back
+			alloc.Deallocate(first, 16);
+			Assert::AreEqual(32_sz, alloc.GetCapacity());
+
+			alloc.Deallocate(second, 16);
+			Assert::AreEqual(48_sz, alloc.GetCapacity());
+
+			for (auto i = 0; i < 100; i++)
+			{
+				auto p = alloc.Allocate(48);
+				Assert::IsNotNull(p);
+				alloc.Deallocate(p, 48);
+			}
+			Assert::AreEqual(48_sz, alloc.GetCapacity());
+		}
+
+		TEST_METHOD(StackAllocator_MarkRewind)
+		{
+			StackAllocator<256> alloc;
+			auto outer = alloc.Allocate(16);
+			const auto mark = alloc.Mark();
+			Assert::AreEqual(240_sz, mark);
+
+			for (auto i = 0; i < 5; i++)
+			{
+				const auto inner = alloc.Mark();
+				Assert::IsNotNull(alloc.Allocate(16));
+				Assert::IsNotNull(alloc.Allocate(16));
+				alloc.Rewind(inner);
+				Assert::AreEqual(inner, alloc.GetCapacity());
+
+				Assert::IsNotNull(alloc.Allocate(4));
+				Assert::IsNotNull(alloc.Allocate(4));
+			}
+			Assert::AreEqual(mark - 10 * IAllocator::DefaultAlignment, alloc.GetCapacity());
+
+			alloc.Rewind(mark);
+			Assert::AreEqual(mark, alloc.GetCapacity());
+			Assert::IsTrue(alloc.Owns(outer, 16));
+
+			// Rewinding to a deeper mark is ignored
+			alloc.Rewind(0);
+			Assert::AreEqual(mark, alloc.GetCapacity());
+		}
+
+		TEST_METHOD(StackAllocator_Aligned)
+		{
+			StackAllocator<256> alloc;
+			Assert::IsNotNull(alloc.Allocate(3));
+
+			auto p = alloc.AllocateAligned(20, 32);
+			Assert::IsNotNull(p);
+			Assert::IsTrue(alloc.Owns(p, 20));
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % 32);
+
+			auto q = alloc.AllocateAligned(1, 64);
+			Assert::IsNotNull(q);
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(q) % 64);
+			Assert::IsTrue(q + 1 <= p);
+
+			alloc.DeallocateAligned(q, 1, 64);
+			Assert::IsNull(alloc.AllocateAligned(256, 32));
+		}
+
+		TEST_METHOD(StackAllocator_DefaultAlignment)
+		{
+			StackAllocator<251> alloc;
+			const auto top = alloc.GetCapacity();
+
+			// Odd sizes don't misalign the following blocks
+			byte_t* blocks[5];
+			const size_t sizes[] = { 1, 3, 7, 5, 2 };
+			for (auto i = 0; i < _countof(sizes); i++)
+			{
+				blocks[i] = alloc.Allocate(sizes[i]);
+				Assert::IsNotNull(blocks[i]);
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(blocks[i]) % IAllocator::DefaultAlignment);
+				Assert::IsTrue(alloc.Owns(blocks[i], sizes[i]));
+			}
+			Assert::IsTrue(blocks[1] + sizes[1] <= blocks[0]);
+
+			auto p = alloc.AllocateAligned(5, 4);
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % IAllocator::DefaultAlignment);
+			alloc.DeallocateAligned(p, 5, 4);
+
+			// Freeing in reverse order reclaims the rounded sizes
+			const auto capacity = alloc.GetCapacity();
+			for (auto i = _countof(sizes); i > 0; i--)
+				alloc.Deallocate(blocks[i - 1], sizes[i - 1]);
+			Assert::AreEqual(capacity + 5 * IAllocator::DefaultAlignment, alloc.GetCapacity());
+			Assert::IsTrue(alloc.GetCapacity() <= top);
+		}
+
+		TEST_METHOD(StackAllocator_Reallocate)
+		{
+			StackAllocator<128> alloc;
+			auto p = alloc.Allocate(16);
+			memcpy(p, "Neat", 4);
+
+			// Top block grows by moving its start down
+			auto q = alloc.Reallocate(p, 16, 80);
+			Assert::IsNotNull(q);
+			Assert::AreEqual(0, memcmp(q, "Neat", 4));
+			Assert::AreEqual(48_sz, alloc.GetCapacity());
+			Assert::IsNull(alloc.Reallocate(q, 80, 160));
+
+			q = alloc.Reallocate(q, 80, 4);
+			Assert::AreEqual(0, memcmp(q, "Neat", 4));
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(q) % IAllocator::DefaultAlignment);
+			Assert::AreEqual(128 - IAllocator::DefaultAlignment, alloc.GetCapacity());
+
+			alloc.Deallocate(q, 4);
+			Assert::AreEqual(128_sz, alloc.GetCapacity());
+		}
 	};
 }
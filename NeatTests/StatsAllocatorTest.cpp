@@ -0,0 +1,133 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\FallbackAllocator.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\StackAllocator.h>
+#include <Neat\StatsAllocator.h>
+
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(StatsAllocatorTest)
+	{
+	public:
+		TEST_METHOD(StatsAllocator_Basic)
+		{
+			MallocAllocator malloc;
+			StatsAllocator alloc(&malloc, "basic");
+			Assert::AreEqual("basic", alloc.GetTag());
+
+			auto p = alloc.Allocate(100);
+			auto q = alloc.Allocate(28);
+			alloc.Deallocate(p, 100);
+
+			auto snapshot = alloc.GetSnapshot();
+			Assert::AreEqual("basic", snapshot.tag);
+			Assert::AreEqual(2_sz, snapshot.allocations);
+			Assert::AreEqual(1_sz, snapshot.deallocations);
+			Assert::AreEqual(0_sz, snapshot.failures);
+			Assert::AreEqual(128_sz, snapshot.allocatedBytes);
+			Assert::AreEqual(100_sz, snapshot.deallocatedBytes);
+			Assert::AreEqual(28_sz, snapshot.liveBytes);
+			Assert::AreEqual(128_sz, snapshot.peakBytes);
+
+			alloc.Deallocate(q, 28);
+			snapshot = alloc.GetSnapshot();
+			Assert::AreEqual(0_sz, snapshot.liveBytes);
+			Assert::AreEqual(128_sz, snapshot.peakBytes);
+		}
+
+		TEST_METHOD(StatsAllocator_Histogram)
+		{
+			Assert::AreEqual(0_sz, StatsAllocator::GetBucket(0));
+			Assert::AreEqual(1_sz, StatsAllocator::GetBucket(1));
+			Assert::AreEqual(2_sz, StatsAllocator::GetBucket(2));
+			Assert::AreEqual(2_sz, StatsAllocator::GetBucket(3));
+			Assert::AreEqual(7_sz, StatsAllocator::GetBucket(64));
+			Assert::AreEqual(7_sz, StatsAllocator::GetBucket(127));
+			Assert::AreEqual(StatsAllocator::BucketCount - 1, StatsAllocator::GetBucket(1_GB));
+
+			MallocAllocator malloc;
+			StatsAllocator alloc(&malloc);
+			for (auto size : { 1_sz, 64_sz, 100_sz, 127_sz })
+				alloc.Deallocate(alloc.Allocate(size), size);
+
+			const auto snapshot = alloc.GetSnapshot();
+			Assert::AreEqual(1_sz, snapshot.histogram[1]);
+			Assert::AreEqual(3_sz, snapshot.histogram[7]);
+			Assert::IsTrue(alloc.GetReport().find("64..127: 3") != std::string::npos);
+		}
+
+		TEST_METHOD(StatsAllocator_FallbackRate)
+		{
+			StackAllocator<64> stack;
+			MallocAllocator malloc;
+			StatsAllocator primary(&stack, "stack");
+			FallbackAllocator alloc(&primary, &malloc);
+
+			std::vector<Buffer> buffers;
+			buffers.reserve(4);
+			for (auto i = 0; i < 4; i++)
+				buffers.emplace_back(32, &alloc);
+
+			const auto snapshot = primary.GetSnapshot();
+			Assert::AreEqual(4_sz, snapshot.allocations);
+			Assert::AreEqual(2_sz, snapshot.failures);
+			Assert::AreEqual(0.5, snapshot.GetFailureRate());
+			Assert::AreEqual(64_sz, snapshot.liveBytes);
+		}
+
+		TEST_METHOD(StatsAllocator_Threads)
+		{
+			class LockedAllocator : public MallocAllocator
+			{
+			public:
+				byte_t* Allocate(size_t bytes) override
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					return MallocAllocator::Allocate(bytes);
+				}
+
+				void Deallocate(byte_t* p, size_t bytes) override
+				{
+					std::lock_guard<std::mutex> lock(m_mutex);
+					MallocAllocator::Deallocate(p, bytes);
+				}
+
+			private:
+				std::mutex m_mutex;
+			};
+
+			LockedAllocator locked;
+			StatsAllocator alloc(&locked, "threads");
+
+			std::vector<std::thread> threads;
+			for (auto t = 0; t < 4; t++)
+			{
+				threads.emplace_back([&alloc]()
+				{
+					for (auto i = 0; i < 1000; i++)
+						alloc.Deallocate(alloc.Allocate(16), 16);
+				});
+			}
+			for (auto& thread : threads)
+				thread.join();
+
+			const auto snapshot = alloc.GetSnapshot();
+			Assert::AreEqual(4000_sz, snapshot.allocations);
+			Assert::AreEqual(4000_sz, snapshot.deallocations);
+			Assert::AreEqual(64000_sz, snapshot.allocatedBytes);
+			Assert::AreEqual(0_sz, snapshot.liveBytes);
+			Assert::IsTrue(snapshot.peakBytes >= 16);
+			Assert::IsTrue(snapshot.peakBytes <= 64);
+		}
+	};
+}
@@ -0,0 +1,254 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\ThreadCachingAllocator.h>
+#include <Neat\Utf.h>
+
+#include <atomic>
+#include <chrono>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(ThreadCachingAllocatorTest)
+	{
+		class CountingAllocator : public MallocAllocator
+		{
+		public:
+			byte_t* Allocate(size_t bytes) override
+			{
+				allocations++;
+				live++;
+				return MallocAllocator::Allocate(bytes);
+			}
+
+			void Deallocate(byte_t* p, size_t bytes) override
+			{
+				deallocations++;
+				live--;
+				MallocAllocator::Deallocate(p, bytes);
+			}
+
+			size_t allocations = 0;
+			size_t deallocations = 0;
+			size_t live = 0;
+		};
+
+		class LockedAllocator : public MallocAllocator
+		{
+		public:
+			byte_t* Allocate(size_t bytes) override
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				return MallocAllocator::Allocate(bytes);
+			}
+
+			void Deallocate(byte_t* p, size_t bytes) override
+			{
+				std::lock_guard<std::mutex> lock(m_mutex);
+				MallocAllocator::Deallocate(p, bytes);
+			}
+
+		private:
+			std::mutex m_mutex;
+		};
+
+	public:
+		TEST_METHOD(ThreadCachingAllocator_Basic)
+		{
+			CountingAllocator backing;
+			{
+				ThreadCachingAllocator alloc(&backing);
+				auto p = alloc.Allocate(24);
+				Assert::IsNotNull(p);
+				Assert::IsTrue(alloc.Owns(p, 24));
+				Assert::AreEqual(ThreadCachingAllocator::BatchSize, backing.allocations);
+
+				alloc.Deallocate(p, 24);
+				Assert::IsTrue(p == alloc.Allocate(32));
+				Assert::AreEqual(ThreadCachingAllocator::BatchSize, backing.allocations);
+
+				auto large = alloc.Allocate(64_kB);
+				Assert::IsNotNull(large);
+				Assert::AreEqual(ThreadCachingAllocator::BatchSize + 1, backing.allocations);
+				alloc.Deallocate(large, 64_kB);
+				alloc.Deallocate(p, 32);
+			}
+			Assert::AreEqual(0_sz, backing.live);
+		}
+
+		TEST_METHOD(ThreadCachingAllocator_Drain)
+		{
+			CountingAllocator backing;
+			ThreadCachingAllocator alloc(&backing);
+
+			std::vector<byte_t*> blocks;
+			for (auto i = 0; i < 200; i++)
+				blocks.push_back(alloc.Allocate(100));
+			for (auto block : blocks)
+				alloc.Deallocate(block, 100);
+
+			// Magazine keeps at most two batches
+			Assert::IsTrue(backing.live <= 2 * ThreadCachingAllocator::BatchSize);
+			Assert::IsTrue(backing.live >= ThreadCachingAllocator::BatchSize);
+
+			alloc.Flush();
+			Assert::AreEqual(0_sz, backing.live);
+		}
+
+		TEST_METHOD(ThreadCachingAllocator_ThreadExit)
+		{
+			CountingAllocator backing;
+			ThreadCachingAllocator alloc(&backing);
+
+			std::thread([&alloc]()
+			{
+				alloc.Deallocate(alloc.Allocate(16), 16);
+			}).join();
+			const auto allocations = backing.allocations;
+
+			// Cache of exited thread is adopted, so no new batch is needed
+			std::thread([&alloc]()
+			{
+				alloc.Deallocate(alloc.Allocate(16), 16);
+			}).join();
+			Assert::AreEqual(allocations, backing.allocations);
+		}
+
+		TEST_METHOD(ThreadCachingAllocator_Stress)
+		{
+			CountingAllocator backing;
+			{
+				ThreadCachingAllocator alloc(&backing);
+				const auto threadCount = 8;
+
+				// Blocks are freed by another thread than the one that allocated them
+				std::vector<Buffer> buffers[threadCount];
+				std::vector<std::thread> threads;
+				for (auto t = 0; t < threadCount; t++)
+				{
+					threads.emplace_back([&alloc, &buffers, t]()
+					{
+						for (auto i = 0; i < 1000; i++)
+						{
+							Buffer buffer(1 + (i * 37 + t) % 3000, &alloc);
+							memset(buffer, t, buffer.GetSize());
+							buffers[t].push_back(std::move(buffer));
+						}
+					});
+				}
+				for (auto& thread : threads)
+					thread.join();
+				threads.clear();
+
+				std::atomic<size_t> corrupted(0);
+				for (auto t = 0; t < threadCount; t++)
+				{
+					threads.emplace_back([&buffers, &corrupted, t]()
+					{
+						auto& victims = buffers[(t + 1) % threadCount];
+						for (auto& buffer : victims)
+						{
+							if (buffer[buffer.GetSize() - 1] != (t + 1) % threadCount)
+								corrupted++;
+						}
+						victims.clear();
+					});
+				}
+				for (auto& thread : threads)
+					thread.join();
+				Assert::AreEqual(0_sz, corrupted.load());
+			}
+			Assert::AreEqual(0_sz, backing.live);
+			Assert::AreEqual(backing.allocations, backing.deallocations);
+		}
+
+		TEST_METHOD(ThreadCachingAllocator_Scaling)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto count = 20000u;
+			const auto maxThreads = (std::max)(4u, std::thread::hardware_concurrency());
+
+			auto run = [count](IAllocator& alloc, unsigned threadCount)
+			{
+				std::vector<std::thread> threads;
+				const auto start = steady_clock::now();
+				for (auto t = 0u; t < threadCount; t++)
+				{
+					threads.emplace_back([&alloc, count]()
+					{
+						byte_t* blocks[16] = {};
+						for (auto i = 0u; i < count; i++)
+						{
+							auto& block = blocks[i % _countof(blocks)];
+							if (block)
+								alloc.Deallocate(block, 64);
+							block = alloc.Allocate(64);
+						}
+						for (auto block : blocks)
+							alloc.Deallocate(block, 64);
+					});
+				}
+				for (auto& thread : threads)
+					thread.join();
+				const auto end = steady_clock::now();
+				return duration_cast<microseconds>(end - start).count();
+			};
+
+			for (auto threadCount = 1u; threadCount <= maxThreads; threadCount *= 2)
+			{
+				{
+					LockedAllocator alloc;
+					const auto duration = run(alloc, threadCount);
+					const auto message = Utf16::Format(
+						L"# %u threads x %u locked MallocAllocator pairs took %llu microseconds",
+						threadCount,
+						count,
+						duration);
+					Logger::WriteMessage(message);
+				}
+				{
+					MallocAllocator backing;
+					ThreadCachingAllocator alloc(&backing);
+					const auto duration = run(alloc, threadCount);
+					const auto message = Utf16::Format(
+						L"# %u threads x %u ThreadCachingAllocator pairs took %llu microseconds",
+						threadCount,
+						count,
+						duration);
+					Logger::WriteMessage(message);
+				}
+			}
+			Logger::WriteMessage(L"#");
+		}
+
+		TEST_METHOD(ThreadCachingAllocator_Batch)
+		{
+			CountingAllocator backing;
+			{
+				ThreadCachingAllocator alloc(&backing);
+				const size_t sizes[] = { 24, 64_kB, 0, 24, 100 };
+				byte_t* blocks[_countof(sizes)];
+				Assert::IsTrue(alloc.AllocateBatch(sizes, _countof(sizes), blocks));
+				Assert::IsNull(blocks[2]);
+				Assert::AreEqual(2 * ThreadCachingAllocator::BatchSize + 1, backing.allocations);
+				memset(blocks[1], 0xAB, 64_kB);
+
+				alloc.DeallocateBatch(blocks, sizes, _countof(sizes));
+				Assert::AreEqual(1_sz, backing.deallocations);
+				Assert::IsTrue(blocks[3] == alloc.Allocate(24));
+				alloc.Deallocate(blocks[3], 24);
+			}
+			Assert::AreEqual(0_sz, backing.live);
+		}
+	};
+}
@@ -0,0 +1,233 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\FallbackAllocator.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\TlsfAllocator.h>
+#include <Neat\Utf.h>
+
+#include <algorithm>
+#include <chrono>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat
+{
+	TEST_CLASS(TlsfAllocatorTest)
+	{
+	public:
+		TEST_METHOD(TlsfAllocator_Basic)
+		{
+			TlsfAllocator alloc(64_kB);
+			Assert::IsTrue(alloc.GetCapacity() > 63_kB);
+			Assert::AreEqual(0_sz, alloc.GetUsed());
+
+			for (auto size : { 0_sz, 1_sz, 16_sz, 17_sz, 100_sz, 4_kB })
+			{
+				auto p = alloc.Allocate(size);
+				Assert::IsNotNull(p);
+				Assert::IsTrue(alloc.Owns(p, size));
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % TlsfAllocator::Granularity);
+				memset(p, 0xAB, size);
+			}
+			Assert::AreEqual(16_sz + 16 + 16 + 32 + 112 + 4_kB, alloc.GetUsed());
+
+			Assert::IsNull(alloc.Allocate(64_kB));
+			Assert::IsNull(alloc.Allocate(TlsfAllocator::MaxBlockSize + 1));
+		}
+
+		TEST_METHOD(TlsfAllocator_Index)
+		{
+			size_t firstLevel;
+			size_t secondLevel;
+			TlsfAllocator::GetIndex(16, firstLevel, secondLevel);
+			Assert::AreEqual(0_sz, firstLevel);
+			Assert::AreEqual(1_sz, secondLevel);
+
+			TlsfAllocator::GetIndex(240, firstLevel, secondLevel);
+			Assert::AreEqual(0_sz, firstLevel);
+			Assert::AreEqual(15_sz, secondLevel);
+
+			TlsfAllocator::GetIndex(256, firstLevel, secondLevel);
+			Assert::AreEqual(1_sz, firstLevel);
+			Assert::AreEqual(0_sz, secondLevel);
+
+			TlsfAllocator::GetIndex(496, firstLevel, secondLevel);
+			Assert::AreEqual(1_sz, firstLevel);
+			Assert::AreEqual(15_sz, secondLevel);
+
+			TlsfAllocator::GetIndex(1_MB + 64_kB, firstLevel, secondLevel);
+			Assert::AreEqual(13_sz, firstLevel);
+			Assert::AreEqual(1_sz, secondLevel);
+
+			TlsfAllocator::GetIndex(TlsfAllocator::MaxBlockSize, firstLevel, secondLevel);
+			Assert::AreEqual(TlsfAllocator::FirstLevelCount - 1, firstLevel);
+			Assert::AreEqual(TlsfAllocator::SecondLevelCount - 1, secondLevel);
+		}
+
+		TEST_METHOD(TlsfAllocator_Coalesce)
+		{
+			byte_t region[16_kB];
+			TlsfAllocator alloc(region, sizeof(region));
+			const auto capacity = alloc.GetCapacity();
+
+			std::vector<byte_t*> blocks;
+			for (auto p = alloc.Allocate(100); p; p = alloc.Allocate(100))
+				blocks.push_back(p);
+			Assert::IsTrue(blocks.size() > 100);
+
+			// Free every other block, holes are too small for a bigger request
+			for (size_t i = 0; i < blocks.size(); i += 2)
+				alloc.Deallocate(blocks[i], 100);
+			Assert::IsNull(alloc.Allocate(300));
+
+			// Freeing the rest merges everything back into one block
+			for (size_t i = 1; i < blocks.size(); i += 2)
+				alloc.Deallocate(blocks[i], 100);
+			Assert::AreEqual(0_sz, alloc.GetUsed());
+
+			auto p = alloc.Allocate(capacity / 2);
+			Assert::IsTrue(blocks[0] == p);
+			alloc.Deallocate(p, capacity / 2);
+		}
+
+		TEST_METHOD(TlsfAllocator_Reuse)
+		{
+			TlsfAllocator alloc(64_kB);
+			auto first = alloc.Allocate(24);
+			auto second = alloc.Allocate(24);
+			Assert::IsTrue(second == first + 32 + 16);
+
+			alloc.Deallocate(first, 24);
+			Assert::IsTrue(first == alloc.Allocate(30));
+
+			alloc.Deallocate(first, 30);
+			alloc.Deallocate(second, 24);
+			Assert::IsTrue(first == alloc.Allocate(1_kB));
+		}
+
+		TEST_METHOD(TlsfAllocator_Aligned)
+		{
+			TlsfAllocator alloc(64_kB);
+			Assert::IsNotNull(alloc.Allocate(16));
+
+			for (auto alignment : { 32_sz, 64_sz, 512_sz, 4_kB })
+			{
+				auto p = alloc.AllocateAligned(20, alignment);
+				Assert::IsNotNull(p);
+				Assert::IsTrue(alloc.Owns(p, 20));
+				Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % alignment);
+				memset(p, 0xCD, 20);
+				alloc.DeallocateAligned(p, 20, alignment);
+			}
+			Assert::AreEqual(16_sz, alloc.GetUsed());
+			Assert::IsNull(alloc.AllocateAligned(20, 64_kB));
+		}
+
+		TEST_METHOD(TlsfAllocator_Expand)
+		{
+			TlsfAllocator alloc(64_kB);
+			auto p = alloc.Allocate(100);
+			Assert::IsTrue(alloc.TryExpand(p, 100, 1_kB));
+			Assert::AreEqual(1_kB, alloc.GetUsed());
+
+			// Shrinking releases the tail, which becomes available for the next block
+			Assert::IsTrue(alloc.TryExpand(p, 1_kB, 200));
+			Assert::AreEqual(208_sz, alloc.GetUsed());
+			auto q = alloc.Allocate(100);
+			Assert::IsTrue(q == p + 208 + 16);
+
+			// Next block is in use now
+			Assert::IsFalse(alloc.TryExpand(p, 200, 1_kB));
+			Assert::IsTrue(alloc.TryExpand(q, 100, 2_kB));
+
+			Buffer buffer(100, &alloc);
+			const auto before = buffer.GetBuffer();
+			const byte_t foo[256] = {};
+			buffer.Append(foo, sizeof(foo));
+			Assert::IsTrue(before == buffer.GetBuffer());
+		}
+
+		TEST_METHOD(TlsfAllocator_Fallback)
+		{
+			TlsfAllocator primary(16_kB);
+			MallocAllocator fallback;
+			FallbackAllocator alloc(&primary, &fallback);
+
+			Buffer small(100, &alloc);
+			Buffer large(32_kB, &alloc);
+			Assert::IsTrue(primary.Owns(small.GetBuffer(), small.GetSize()));
+			Assert::IsFalse(primary.Owns(large.GetBuffer(), large.GetSize()));
+
+			Utf8 string("Hello World!", Utf8::End, &alloc);
+			Assert::IsTrue(primary.Owns(reinterpret_cast<byte_t*>(string.GetString()), string.GetLength()));
+		}
+
+		TEST_METHOD(TlsfAllocator_Latency)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto count = 100000u;
+			const size_t sizes[] = { 8, 24, 40, 100, 250, 600, 1500, 3000, 9000, 24000 };
+			std::vector<byte_t*> blocks(256);
+			std::vector<int64_t> latencies;
+			latencies.reserve(count);
+
+			auto run = [&](IAllocator& alloc)
+			{
+				latencies.clear();
+				for (auto i = 0u; i < count; i++)
+				{
+					// Pseudo-random mix of sizes and lifetimes, the same for every allocator
+					const auto slot = (i * 2654435761u) % blocks.size();
+					const auto size = sizes[(i * 40503u >> 3) % _countof(sizes)];
+					auto& block = blocks[slot];
+
+					const auto start = steady_clock::now();
+					if (block)
+						alloc.Deallocate(block, *reinterpret_cast<size_t*>(block));
+					block = alloc.Allocate(size);
+					const auto end = steady_clock::now();
+
+					*reinterpret_cast<size_t*>(block) = size;
+					latencies.push_back(duration_cast<nanoseconds>(end - start).count());
+				}
+				for (auto& block : blocks)
+				{
+					if (block)
+						alloc.Deallocate(block, *reinterpret_cast<size_t*>(block));
+					block = nullptr;
+				}
+				std::sort(latencies.begin(), latencies.end());
+			};
+
+			auto report = [&](const wchar_t* name)
+			{
+				const auto message = Utf16::Format(
+					L"# %u %ls deallocate/allocate pairs: p50 %lld ns, p99 %lld ns, p99.9 %lld ns, max %lld ns",
+					count,
+					name,
+					latencies[latencies.size() / 2],
+					latencies[latencies.size() * 99 / 100],
+					latencies[latencies.size() * 999 / 1000],
+					latencies.back());
+				Logger::WriteMessage(message);
+			};
+			{
+				MallocAllocator alloc;
+				run(alloc);
+				report(L"MallocAllocator");
+			}
+			{
+				TlsfAllocator alloc(16_MB);
+				run(alloc);
+				report(L"TlsfAllocator");
+			}
+			Logger::WriteMessage(L"#");
+		}
+	};
+}
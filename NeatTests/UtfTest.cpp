@@ -1,6 +1,12 @@
 #include <Neat\Types.h>
 #include <Neat\Utf.h>
+#include <Neat\AllocatorScope.h>
+#include <Neat\ArenaAllocator.h>
+#include <Neat\MallocAllocator.h>
 #include <Neat\StackAllocator.h>
+#include <Neat\StatsAllocator.h>
+
+#include <vector>
 
 #include <CppUnitTest.h>
 
@@ -441,6 +447,22 @@ namespace Neat
 			Assert::IsTrue(before == after);
 		}
 
+		TEST_METHOD(String_ReserveInPlace)
+		{
+			ArenaAllocator alloc;
+			Utf8 string(&alloc);
+			string.Append('x');
+
+			const auto before = string.GetBuffer();
+			for (auto i = 0; i < 100; i++)
+				string += "abc";
+
+			const auto after = string.GetBuffer();
+			Assert::IsTrue(before == after);
+			Assert::AreEqual(301_sz, string.GetLength());
+			Assert::IsTrue(string.EndsWith("cabc"));
+		}
+
 		TEST_METHOD(String_Match)
 		{
 			{
@@ -1451,7 +1473,7 @@ namespace Neat
 		TEST_METHOD(String_CustomAllocator)
 		{
 			{
-				StackAllocator<20> alloc;
+				StackAllocator<32> alloc;
 				Utf8 string(&alloc);
 				Assert::IsTrue(string.GetAllocator() == &alloc);
 
@@ -1460,11 +1482,12 @@ namespace Neat
 				Assert::AreEqual("Hello World!", string);
 				Assert::IsTrue(string.GetAllocator() == &alloc);
 
+				// String grew on top of the stack, so only its final size is used
 				const auto capacity = alloc.GetCapacity();
-				Assert::AreEqual(0_sz, capacity);
+				Assert::AreEqual(16_sz, capacity);
 			}
 			{
-				StackAllocator<40> alloc;
+				StackAllocator<64> alloc;
 				Utf16 string(&alloc);
 				Assert::IsTrue(string.GetAllocator() == &alloc);
 
@@ -1474,7 +1497,7 @@ namespace Neat
 				Assert::IsTrue(string.GetAllocator() == &alloc);
 
 				const auto capacity = alloc.GetCapacity();
-				Assert::AreEqual(0_sz, capacity);
+				Assert::AreEqual(32_sz, capacity);
 			}
 		}
 
@@ -1492,5 +1515,144 @@ namespace Neat
 			Assert::AreEqual("some", Utf8::CopyBefore("some/path", '/'));
 			Assert::AreEqual(L"some", Utf16::CopyBefore(L"some/path", L'/'));
 		}
+
+		TEST_METHOD(String_StaticPolicy)
+		{
+			typedef StringT<char, Utf8Traits, StaticAllocatorPolicy<MallocAllocator>> MallocUtf8;
+
+			MallocUtf8 string("Hello");
+			string += " World!";
+			Assert::AreEqual("Hello World!", string.GetString());
+			Assert::AreEqual("World", string.Substring(6, 5).GetString());
+
+			const auto tokens = string.Split(" ");
+			Assert::AreEqual(2_sz, tokens.size());
+			Assert::AreEqual("Hello", tokens[0].GetString());
+			Assert::AreEqual("World!", MallocUtf8::CopyBefore("World!/Hello", '/').GetString());
+		}
+
+		TEST_METHOD(String_CopyBatch)
+		{
+			ArenaAllocator alloc(1_kB);
+			const wchar_t* strings[] = { L"first", nullptr, L"second", L"" };
+			auto copies = Utf16::CopyBatch(strings, nullptr, _countof(strings), &alloc);
+			Assert::AreEqual(_countof(strings), copies.size());
+			Assert::AreEqual(L"first", copies[0]);
+			Assert::IsTrue(copies[1].IsEmpty());
+			Assert::AreEqual(L"second", copies[2]);
+			Assert::AreEqual(L"", copies[3]);
+			Assert::AreEqual(1_sz, alloc.GetBlockCount());
+			Assert::IsTrue(&alloc == copies[2].GetAllocator());
+
+			const size_t lengths[] = { 3, 0, 3, 0 };
+			copies = Utf16::CopyBatch(strings, lengths, _countof(strings));
+			Assert::AreEqual(L"fir", copies[0]);
+			Assert::AreEqual(L"sec", copies[2]);
+
+			// Tokens of split come from the string's allocator
+			Utf16 string(L"a,bc,,def", Utf16::End, &alloc);
+			const auto used = alloc.GetUsed();
+			const auto tokens = string.Split(L",");
+			Assert::AreEqual(3_sz, tokens.size());
+			Assert::AreEqual(L"def", tokens[2]);
+			Assert::IsTrue(&alloc == tokens[0].GetAllocator());
+			Assert::IsTrue(alloc.GetUsed() > used);
+		}
+
+		TEST_METHOD(String_CopyBatchScratch)
+		{
+			MallocAllocator malloc;
+			StatsAllocator heap(&malloc);
+			const Utf8 small("a,b,c", Utf8::End, &heap);
+			const Utf8 large("a,b,c,d,e,f,g,h,i,j,k,l", Utf8::End, &heap);
+			const auto live = heap.GetSnapshot().liveBytes;
+
+			// Small batches need no allocations besides the tokens
+			auto allocations = heap.GetSnapshot().allocations;
+			Assert::AreEqual(3_sz, small.Split(",").size());
+			Assert::AreEqual(allocations + 3, heap.GetSnapshot().allocations);
+
+			// Large ones take one scratch block, which is released
+			allocations = heap.GetSnapshot().allocations;
+			const auto tokens = large.Split(",");
+			Assert::AreEqual(12_sz, tokens.size());
+			Assert::AreEqual("l", tokens[11]);
+			Assert::AreEqual(allocations + 12 + 1, heap.GetSnapshot().allocations);
+			Assert::AreEqual(live + 12 * 2, heap.GetSnapshot().liveBytes);
+		}
+
+		TEST_METHOD(String_CopyBatchFailure)
+		{
+			StackAllocator<64> small;
+			const char* strings[] = { "a string which fits", "another one which doesn't fit in the allocator" };
+			Assert::ExpectException<std::bad_alloc>([&]() { Utf8::CopyBatch(strings, nullptr, _countof(strings), &small); });
+
+			// Scratch of split fits, the tokens don't and the scratch is released
+			StackAllocator<320> stack;
+			StatsAllocator alloc(&stack);
+			const Utf8 string("some,tokens,which,don't,fit,on,the,stack,allocator");
+			Assert::ExpectException<std::bad_alloc>([&]() { string.Split(",", &alloc); });
+			Assert::AreEqual(0_sz, alloc.GetSnapshot().liveBytes);
+			Assert::AreEqual(1_sz, alloc.GetSnapshot().failures);
+			Assert::IsTrue(alloc.GetSnapshot().allocations > 2);
+		}
+
+		TEST_METHOD(String_AllocatorPropagation)
+		{
+			// Strings which lose the allocator fall back to the scope, which counts them
+			MallocAllocator malloc;
+			StatsAllocator heap(&malloc);
+			AllocatorScope scope(&heap);
+
+			ArenaAllocator alloc(1_kB);
+			const auto owned = [&alloc](const Utf16& string)
+			{
+				return &alloc == string.GetAllocator() && alloc.Owns(string.GetBuffer(), string.GetSize());
+			};
+
+			const Utf16 string(L"One Two", Utf16::End, &alloc);
+			Assert::IsTrue(owned(Utf16(string)));
+			Assert::IsTrue(owned(string.Substring(4)));
+			Assert::IsTrue(owned(string.ToLower()));
+			Assert::IsTrue(owned(string.ToUpper()));
+			Assert::IsTrue(owned(string + L"!"));
+			for (const auto& token : string.Split(L" "))
+				Assert::IsTrue(owned(token));
+
+			const auto formatted = Utf16::Format(&alloc, L"%ls %d", L"One", 2);
+			Assert::AreEqual(L"One 2", formatted);
+			Assert::IsTrue(owned(formatted));
+			Assert::IsTrue(&alloc == Utf16::Format(&alloc, L"").GetAllocator());
+			Assert::IsTrue(&alloc == Utf16::CopyBefore(nullptr, L'/', &alloc).GetAllocator());
+
+			// Copies made while the vector grows keep the allocator too
+			std::vector<Utf16> copies;
+			for (auto i = 0; i < 10; i++)
+				copies.push_back(string);
+			for (const auto& copy : copies)
+				Assert::IsTrue(owned(copy));
+
+			// Explicit allocator wins over the one of the source
+			ArenaAllocator other(1_kB);
+			Assert::IsTrue(&other == Utf16(string, &other).GetAllocator());
+			Assert::IsTrue(&other == string.Substring(0, 3, &other).GetAllocator());
+			Assert::IsTrue(&other == string.ToLower(&other).GetAllocator());
+			Assert::IsTrue(&other == string.Split(L" ", &other)[1].GetAllocator());
+
+			// Swap exchanges allocators along with buffers
+			Utf16 left(L"left", Utf16::End, &alloc);
+			Utf16 right(L"right", Utf16::End, &other);
+			swap(left, right);
+			Assert::AreEqual(L"right", left);
+			Assert::IsTrue(&other == left.GetAllocator());
+			Assert::IsTrue(owned(right));
+
+			// Copy assignment keeps the allocator of the target
+			left = string;
+			Assert::AreEqual(L"One Two", left);
+			Assert::IsTrue(&other == left.GetAllocator());
+
+			Assert::AreEqual(0_sz, heap.GetSnapshot().allocations);
+		}
 	};
 }
\ No newline at end of file
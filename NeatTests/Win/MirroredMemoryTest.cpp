@@ -0,0 +1,61 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\ByteRing.h>
+#include <Neat\Win\MirroredMemory.h>
+#include <Neat\Win\PageAllocator.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat::Win
+{
+	TEST_CLASS(MirroredMemoryTest)
+	{
+	public:
+		TEST_METHOD(MirroredMemory_Basic)
+		{
+			auto memory = MirroredMemory::Create(1);
+			const auto size = memory.GetSize();
+			Assert::AreEqual(PageAllocator::GetAllocationGranularity(), size);
+
+			// Both halves show the same bytes
+			const auto base = memory.GetBase();
+			base[0] = 42;
+			base[size + size - 1] = 43;
+			Assert::AreEqual(42, static_cast<int>(base[size]));
+			Assert::AreEqual(43, static_cast<int>(base[size - 1]));
+
+			auto moved = std::move(memory);
+			Assert::IsTrue(base == moved.GetBase());
+		}
+
+		TEST_METHOD(MirroredMemory_Ring)
+		{
+			auto memory = MirroredMemory::Create(64_kB);
+			ByteRing ring(memory.GetBase(), memory.GetSize(), true);
+			Assert::IsTrue(ring.IsMirrored());
+
+			byte_t bytes[100];
+			for (auto i = 0; i < _countof(bytes); i++)
+				bytes[i] = static_cast<byte_t>(i);
+
+			// Move the positions close to the end of the region
+			ring.Commit(ring.Reserve().size - 10);
+			ring.Consume(ring.Peek().size);
+
+			// Spans cross the end of the region in one piece
+			auto span = ring.Reserve();
+			Assert::AreEqual(ring.GetCapacity(), span.size);
+			memcpy(span.data, bytes, sizeof(bytes));
+			ring.Commit(sizeof(bytes));
+
+			span = ring.Peek();
+			Assert::AreEqual(sizeof(bytes), span.size);
+			Assert::AreEqual(0, memcmp(bytes, span.data, sizeof(bytes)));
+			Assert::AreEqual(0, memcmp(bytes + 10, memory.GetBase(), sizeof(bytes) - 10));
+			ring.Consume(span.size);
+			Assert::AreEqual(0_sz, ring.GetSize());
+		}
+	};
+}
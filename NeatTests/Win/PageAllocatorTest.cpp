@@ -0,0 +1,173 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\FallbackAllocator.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\PoolAllocator.h>
+#include <Neat\SegregatorAllocator.h>
+#include <Neat\Utf.h>
+#include <Neat\Win\PageAllocator.h>
+
+#include <chrono>
+#include <random>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat::Win
+{
+	TEST_CLASS(PageAllocatorTest)
+	{
+	public:
+		TEST_METHOD(PageAllocator_Basic)
+		{
+			PageAllocator alloc;
+			auto p = alloc.Allocate(100);
+			Assert::IsNotNull(p);
+			Assert::AreEqual(0_sz, reinterpret_cast<uintptr_t>(p) % PageAllocator::GetAllocationGranularity());
+			Assert::IsTrue(alloc.Owns(p, 100));
+			Assert::IsFalse(alloc.Owns(p + 1, 99));
+
+			memset(p, 0xFF, PageAllocator::GetPageSize());
+			alloc.Deallocate(p, 100);
+
+			MallocAllocator malloc;
+			auto q = malloc.Allocate(1_MB);
+			Assert::IsFalse(alloc.Owns(q, 1_MB));
+			malloc.Deallocate(q, 1_MB);
+		}
+
+		TEST_METHOD(PageAllocator_Options)
+		{
+			const uint32_t options[] =
+			{
+				PageAllocator::Prefault,
+				PageAllocator::LargePages,
+				PageAllocator::LargePages | PageAllocator::Prefault
+			};
+			for (auto option : options)
+			{
+				PageAllocator alloc(option);
+				Assert::AreEqual(option, alloc.GetOptions());
+
+				// Large pages silently fall back to regular ones without the privilege
+				Buffer buffer(4_MB, &alloc);
+				Assert::AreEqual(4_MB, buffer.GetSize());
+				Assert::IsTrue(alloc.Owns(buffer, buffer.GetSize()));
+				buffer[4_MB - 1] = 1;
+			}
+		}
+
+		TEST_METHOD(PageAllocator_Expand)
+		{
+			PageAllocator alloc;
+			const auto granularity = PageAllocator::GetAllocationGranularity();
+			auto p = alloc.Allocate(100);
+			p[99] = 42;
+
+			// Pages reserved up to the allocation granularity are committed in place
+			Assert::IsTrue(alloc.TryExpand(p, 100, granularity));
+			Assert::AreEqual(42, static_cast<int>(p[99]));
+			p[granularity - 1] = 1;
+			Assert::IsFalse(alloc.TryExpand(p, granularity, granularity + 1));
+
+			Assert::IsTrue(alloc.TryExpand(p, granularity, 100));
+			Assert::IsTrue(alloc.Owns(p, 100));
+			Assert::IsFalse(alloc.Owns(p, granularity));
+
+			auto q = alloc.Reallocate(p, 100, 1_MB);
+			Assert::IsNotNull(q);
+			Assert::AreEqual(42, static_cast<int>(q[99]));
+			alloc.Deallocate(q, 1_MB);
+		}
+
+		TEST_METHOD(PageAllocator_Fallback)
+		{
+			PoolAllocator pool;
+			PageAllocator pages;
+			{
+				FallbackAllocator alloc(&pool, &pages);
+				Buffer small(100, &alloc);
+				Buffer large(10_MB, &alloc);
+				Assert::IsTrue(pool.Owns(small, small.GetSize()));
+				Assert::IsFalse(pool.Owns(large, large.GetSize()));
+				Assert::IsTrue(pages.Owns(large, large.GetSize()));
+			}
+			{
+				SegregatorAllocator<PoolAllocator::MaxBlockSize> alloc(&pool, &pages);
+				Buffer small(100, &alloc);
+				Buffer large(10_MB, &alloc);
+				Assert::IsTrue(pool.Owns(small, small.GetSize()));
+				Assert::IsTrue(pages.Owns(large, large.GetSize()));
+			}
+		}
+
+		TEST_METHOD(PageAllocator_Touch)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto size = 64_MB;
+			const auto count = 1000000u;
+
+			std::vector<size_t> offsets(count);
+			std::mt19937_64 random(42);
+			for (auto& offset : offsets)
+				offset = random() % size;
+
+			auto run = [&](IAllocator& alloc, const wchar_t* name)
+			{
+				{
+					const auto start = steady_clock::now();
+					auto p = alloc.Allocate(size);
+					for (size_t i = 0; i < size; i += 64)
+						p[i] = static_cast<byte_t>(i);
+					alloc.Deallocate(p, size);
+					const auto end = steady_clock::now();
+					const auto duration = duration_cast<microseconds>(end - start).count();
+					const auto message = Utf16::Format(
+						L"# %u MB sequential touch with %s took %llu microseconds",
+						static_cast<uint32_t>(size / 1_MB),
+						name,
+						duration);
+					Logger::WriteMessage(message);
+				}
+				{
+					const auto start = steady_clock::now();
+					auto p = alloc.Allocate(size);
+					for (auto offset : offsets)
+						p[offset]++;
+					alloc.Deallocate(p, size);
+					const auto end = steady_clock::now();
+					const auto duration = duration_cast<microseconds>(end - start).count();
+					const auto message = Utf16::Format(
+						L"# %u random touches of %u MB with %s took %llu microseconds",
+						count,
+						static_cast<uint32_t>(size / 1_MB),
+						name,
+						duration);
+					Logger::WriteMessage(message);
+				}
+			};
+			{
+				MallocAllocator alloc;
+				run(alloc, L"MallocAllocator");
+			}
+			{
+				PageAllocator alloc;
+				run(alloc, L"PageAllocator");
+			}
+			{
+				PageAllocator alloc(PageAllocator::Prefault);
+				run(alloc, L"PageAllocator (prefault)");
+			}
+			{
+				PageAllocator alloc(PageAllocator::LargePages);
+				run(alloc, L"PageAllocator (large pages)");
+			}
+			Logger::WriteMessage(L"#");
+		}
+	};
+}
@@ -1,4 +1,8 @@
 #include "stdafx.h"
+#include <Neat\AllocatorScope.h>
+#include <Neat\ArenaAllocator.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\StatsAllocator.h>
 #include <Neat\Win\Path.h>
 
 using namespace Microsoft::VisualStudio::CppUnitTestFramework;
@@ -560,5 +564,32 @@ namespace Neat::Win
 				Assert::AreEqual(LR"(-u "C:\Windows\AppPatch\Custom\Custom64\{08274920-8908-45c2-9258-8ad67ff77b09}.sdb")", pair.second);
 			}
 		}
+
+		TEST_METHOD(Path_Allocator)
+		{
+			// Paths which lose the allocator fall back to the scope, which counts them
+			MallocAllocator malloc;
+			StatsAllocator heap(&malloc);
+			AllocatorScope scope(&heap);
+
+			ArenaAllocator alloc(1_kB);
+			const Path16 path(L"C:\\Windows\\System32\\notepad.exe", &alloc);
+			Assert::IsTrue(&alloc == Path16(path).GetAllocator());
+			Assert::IsTrue(&alloc == (path + Path16(L"more", &alloc)).GetAllocator());
+			Assert::IsTrue(&alloc == path.GetName().GetAllocator());
+			Assert::IsTrue(&alloc == path.GetNameWithoutExtension().GetAllocator());
+			Assert::IsTrue(&alloc == path.GetFolder().GetAllocator());
+			Assert::IsTrue(&alloc == Path16(L"notepad", &alloc).GetFolder().GetAllocator());
+
+			const auto url = Path16::UrlToWin32(L"file:///C:/Windows/notepad.exe", &alloc);
+			Assert::AreEqual(L"C:\\Windows\\notepad.exe", url);
+			Assert::IsTrue(&alloc == url.GetAllocator());
+
+			const auto pair = Path16::SplitCommandLine(L"\"C:\\App.exe\" /quiet", &alloc);
+			Assert::IsTrue(&alloc == pair.first.GetAllocator());
+			Assert::IsTrue(&alloc == pair.second.GetAllocator());
+
+			Assert::AreEqual(0_sz, heap.GetSnapshot().allocations);
+		}
 	};
 }
\ No newline at end of file
@@ -0,0 +1,177 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\MallocAllocator.h>
+#include <Neat\StackAllocator.h>
+#include <Neat\Utf.h>
+#include <Neat\Win\ProfilingAllocator.h>
+
+#include <chrono>
+#include <string>
+#include <thread>
+#include <vector>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat::Win
+{
+	TEST_CLASS(ProfilingAllocatorTest)
+	{
+	public:
+		TEST_METHOD(ProfilingAllocator_Basic)
+		{
+			MallocAllocator malloc;
+			ProfilingAllocator alloc(&malloc, 0);
+			Assert::AreEqual(0_sz, alloc.GetSamplingInterval());
+
+			auto p = alloc.Allocate(100);
+			auto q = alloc.Allocate(28);
+			{
+				Buffer buffer(1_kB, &alloc);
+				Assert::AreEqual(3_sz, alloc.GetLiveSampleCount());
+			}
+			alloc.Deallocate(p, 100);
+			Assert::AreEqual(1_sz, alloc.GetLiveSampleCount());
+
+			const auto profile = alloc.GetProfile();
+			Assert::AreEqual(0_sz, profile.find("heap profile: 1: 28 [3: 1152] @ heap_v2/0\n"));
+			Assert::IsTrue(profile.find("] @ 0x") != std::string::npos);
+			Assert::IsTrue(profile.find("\nMAPPED_LIBRARIES:\n") != std::string::npos);
+			alloc.Deallocate(q, 28);
+			Assert::AreEqual(0_sz, alloc.GetLiveSampleCount());
+		}
+
+		TEST_METHOD(ProfilingAllocator_Resize)
+		{
+			MallocAllocator malloc;
+			ProfilingAllocator alloc(&malloc, 0);
+
+			auto p = alloc.Allocate(100);
+			p = alloc.Reallocate(p, 100, 10_kB);
+			Assert::IsNotNull(p);
+			Assert::AreEqual(1_sz, alloc.GetLiveSampleCount());
+			Assert::AreEqual(0_sz, alloc.GetProfile().find("heap profile: 1: 10240 [2: 10340]"));
+			alloc.Deallocate(p, 10_kB);
+			Assert::AreEqual(0_sz, alloc.GetLiveSampleCount());
+		}
+
+		TEST_METHOD(ProfilingAllocator_ResizeFailure)
+		{
+			StackAllocator<256> stack;
+			ProfilingAllocator alloc(&stack, 0);
+
+			auto p = alloc.Allocate(64);
+			Assert::IsNotNull(p);
+			Assert::AreEqual(1_sz, alloc.GetLiveSampleCount());
+
+			// Block stays live when it can't grow, so does its sample
+			Assert::IsNull(alloc.Reallocate(p, 64, 1_kB));
+			Assert::AreEqual(1_sz, alloc.GetLiveSampleCount());
+			Assert::AreEqual(0_sz, alloc.GetProfile().find("heap profile: 1: 64 [1: 64]"));
+
+			alloc.Deallocate(p, 64);
+			Assert::AreEqual(0_sz, alloc.GetLiveSampleCount());
+		}
+
+		TEST_METHOD(ProfilingAllocator_Sampling)
+		{
+			MallocAllocator malloc;
+			ProfilingAllocator alloc(&malloc, 64_kB);
+
+			// 64 MB in 1 kB blocks is 1024 samples on average
+			for (auto i = 0; i < 64 * 1024; i++)
+				alloc.Deallocate(alloc.Allocate(1_kB), 1_kB);
+			Assert::AreEqual(0_sz, alloc.GetLiveSampleCount());
+
+			size_t live;
+			size_t liveBytes;
+			size_t total;
+			size_t totalBytes;
+			Assert::AreEqual(4, sscanf_s(alloc.GetProfile().c_str(), "heap profile: %zu: %zu [%zu: %zu]", &live, &liveBytes, &total, &totalBytes));
+			Assert::AreEqual(0_sz, live);
+			Assert::IsTrue(total > 850 && total < 1200);
+			Assert::AreEqual(total * 1_kB, totalBytes);
+
+			// Large blocks are sampled almost always
+			std::vector<byte_t*> blocks;
+			for (auto i = 0; i < 100; i++)
+				blocks.push_back(alloc.Allocate(1_MB));
+			Assert::IsTrue(alloc.GetLiveSampleCount() > 95);
+			for (auto block : blocks)
+				alloc.Deallocate(block, 1_MB);
+			Assert::AreEqual(0_sz, alloc.GetLiveSampleCount());
+		}
+
+		TEST_METHOD(ProfilingAllocator_Threads)
+		{
+			MallocAllocator malloc;
+			ProfilingAllocator alloc(&malloc, 4_kB);
+
+			std::vector<std::thread> threads;
+			for (auto t = 0; t < 4; t++)
+			{
+				threads.emplace_back([&alloc]()
+				{
+					std::vector<Buffer> buffers;
+					for (auto i = 0; i < 1000; i++)
+					{
+						buffers.emplace_back(1 + i % 500, &alloc);
+						if (buffers.size() > 16)
+							buffers.erase(buffers.begin());
+					}
+				});
+			}
+			for (auto& thread : threads)
+				thread.join();
+			Assert::AreEqual(0_sz, alloc.GetLiveSampleCount());
+		}
+
+		TEST_METHOD(ProfilingAllocator_Overhead)
+		{
+			// Perfomance comparison
+
+			using namespace std::chrono;
+			const auto count = 1000000u;
+			const size_t sizes[] = { 8, 24, 40, 100, 250, 600, 1500, 3000 };
+
+			auto run = [&](IAllocator& alloc)
+			{
+				byte_t* blocks[64] = {};
+				const auto start = steady_clock::now();
+				for (auto i = 0u; i < count; i++)
+				{
+					auto& block = blocks[i % _countof(blocks)];
+					if (block)
+						alloc.Deallocate(block, sizes[(i - _countof(blocks)) % _countof(sizes)]);
+					block = alloc.Allocate(sizes[i % _countof(sizes)]);
+				}
+				for (auto i = count; i < count + _countof(blocks); i++)
+					alloc.Deallocate(blocks[i % _countof(blocks)], sizes[(i - _countof(blocks)) % _countof(sizes)]);
+				const auto end = steady_clock::now();
+				return duration_cast<microseconds>(end - start).count();
+			};
+			{
+				MallocAllocator alloc;
+				const auto duration = run(alloc);
+				const auto message = Utf16::Format(
+					L"# %u MallocAllocator allocate/deallocate pairs took %llu microseconds",
+					count,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			{
+				MallocAllocator malloc;
+				ProfilingAllocator alloc(&malloc);
+				const auto duration = run(alloc);
+				const auto message = Utf16::Format(
+					L"# %u ProfilingAllocator allocate/deallocate pairs sampled every 512 kB took %llu microseconds",
+					count,
+					duration);
+				Logger::WriteMessage(message);
+			}
+			Logger::WriteMessage(L"#");
+		}
+	};
+}
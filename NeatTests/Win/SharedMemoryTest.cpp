@@ -0,0 +1,69 @@
+#include "IntToString.h"
+#include <CppUnitTest.h>
+
+#include <Neat\Types.h>
+#include <Neat\Buffer.h>
+#include <Neat\SharedAllocator.h>
+#include <Neat\Utf.h>
+#include <Neat\Win\Exception.h>
+#include <Neat\Win\SharedMemory.h>
+
+using namespace Microsoft::VisualStudio::CppUnitTestFramework;
+
+namespace Neat::Win
+{
+	TEST_CLASS(SharedMemoryTest)
+	{
+		static Utf16 GetName(const wchar_t* test)
+		{
+			return Utf16::Format(L"Local\\NeatTests.%ls.%u", test, ::GetCurrentProcessId());
+		}
+
+	public:
+		TEST_METHOD(SharedMemory_Basic)
+		{
+			const auto name = GetName(L"Basic");
+			auto first = SharedMemory::Create(name, 64_kB);
+			Assert::IsNotNull(first.GetBase());
+			Assert::AreEqual(64_kB, first.GetSize());
+			Assert::AreEqual(0, static_cast<int>(first.GetBase()[100]));
+
+			// Second view of the same region lands at another address
+			auto second = SharedMemory::Open(name);
+			Assert::IsTrue(first.GetBase() != second.GetBase());
+			Assert::AreEqual(64_kB, second.GetSize());
+
+			first.GetBase()[100] = 42;
+			Assert::AreEqual(42, static_cast<int>(second.GetBase()[100]));
+
+			Assert::ExpectException<Win32Exception>([]()
+			{
+				SharedMemory::Open(L"Local\\NeatTests.Missing");
+			});
+		}
+
+		TEST_METHOD(SharedMemory_Allocator)
+		{
+			const auto name = GetName(L"Allocator");
+			auto first = SharedMemory::Create(name, 1_MB);
+			auto second = SharedMemory::Open(name);
+			SharedAllocator producer(first.GetBase(), first.GetSize());
+			SharedAllocator consumer(second.GetBase(), second.GetSize());
+
+			// Payload is written once and read in place through the other view
+			Buffer payload(&producer);
+			const byte_t data[] = { 0xDE, 0xAD, 0xBE, 0xEF };
+			payload.Append(data, sizeof(data));
+			producer.SetRoot(producer.GetOffset(payload.GetBuffer()));
+
+			const auto p = consumer.GetPointer(consumer.GetRoot());
+			Assert::AreEqual(0, memcmp(data, p, sizeof(data)));
+			Assert::IsTrue(consumer.Owns(p, sizeof(data)));
+
+			// Block freed through one view is reused through the other
+			const auto q = producer.Allocate(sizeof(data));
+			consumer.Deallocate(consumer.GetPointer(producer.GetOffset(q)), sizeof(data));
+			Assert::IsTrue(q == producer.Allocate(sizeof(data)));
+		}
+	};
+}